@@ -0,0 +1,85 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCUTILS__FORMAT_NUMBER_H_
+#define RCUTILS__FORMAT_NUMBER_H_
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcutils/visibility_control.h"
+
+/// The longest decimal representation of a 64 bit integer, not including the null terminator.
+#define RCUTILS_FORMAT_INT64_MAX_LENGTH 20
+
+/// The length of a time in the format `YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ`.
+#define RCUTILS_FORMAT_TIME_ISO8601_LENGTH 30
+
+/// Format an unsigned integer in decimal.
+/**
+ * This produces the same output as `snprintf()` with `%llu`, without parsing
+ * a format string, by converting two digits at a time with a lookup table.
+ *
+ * \param value The value to format.
+ * \param buffer The buffer to write to, which must have room for at least
+ *   `RCUTILS_FORMAT_INT64_MAX_LENGTH + 1` characters.
+ * \return The number of characters written, not including the null terminator.
+ */
+RCUTILS_PUBLIC
+size_t
+rcutils_format_uint64(uint64_t value, char * buffer);
+
+/// Format a signed integer in decimal, see rcutils_format_uint64().
+RCUTILS_PUBLIC
+size_t
+rcutils_format_int64(int64_t value, char * buffer);
+
+/// Format an unsigned integer in decimal with a fixed number of digits.
+/**
+ * The value is padded with leading zeros, digits which don't fit are dropped.
+ * No null terminator is written.
+ *
+ * \param value The value to format.
+ * \param width The number of digits to write.
+ * \param buffer The buffer to write to, which must have room for `width` characters.
+ */
+RCUTILS_PUBLIC
+void
+rcutils_format_uint64_fixed(uint64_t value, size_t width, char * buffer);
+
+/// Format a time in nanoseconds since the epoch as an ISO 8601 date and time in UTC.
+/**
+ * The format is `YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ`, computed from the time
+ * without calling `gmtime()` or `strftime()`.
+ * All times representable as 64 bit nanoseconds have four digit years.
+ *
+ * \param nanoseconds The time in nanoseconds since the epoch, which may be negative.
+ * \param buffer The buffer to write to, which must have room for at least
+ *   `RCUTILS_FORMAT_TIME_ISO8601_LENGTH + 1` characters.
+ * \return The number of characters written, not including the null terminator.
+ */
+RCUTILS_PUBLIC
+size_t
+rcutils_format_time_iso8601(int64_t nanoseconds, char * buffer);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // RCUTILS__FORMAT_NUMBER_H_
@@ -17,10 +17,12 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "rcutils/allocator.h"
 #include "rcutils/error_handling.h"
+#include "rcutils/time.h"
 #include "rcutils/types/rcutils_ret.h"
 #include "rcutils/visibility_control.h"
 
@@ -33,6 +35,11 @@ extern "C"
 #define RCUTILS_LOGGING_SEPARATOR_STRING "."
 
 /// The flag if the logging system has been initialized.
+/**
+ * The flag is set with release semantics once the initialization completed,
+ * use RCUTILS_LOGGING_IS_INITIALIZED() to check it while another thread might
+ * be initializing the logging system.
+ */
 RCUTILS_PUBLIC
 extern bool g_rcutils_logging_initialized;
 
@@ -49,6 +56,11 @@ extern bool g_rcutils_logging_initialized;
  *
  * If multiple errors occur, the error code of the last error will be returned.
  *
+ * Concurrent calls, as well as calls to rcutils_logging_shutdown(), are
+ * serialized by a mutex, so that threads which log for the first time at the
+ * same time initialize the logging system only once.
+ * Once it's initialized this function only checks the flag without locking.
+ *
  * The `RCUTILS_CONSOLE_OUTPUT_FORMAT` environment variable can be used to set
  * the output format of messages logged to the console.
  * Available tokens are:
@@ -58,19 +70,33 @@ extern bool g_rcutils_logging_initialized;
  *   - `message`, the message string after it has been formatted
  *   - `name`, the full logger name
  *   - `severity`, the name of the severity level, e.g. `INFO`
+ *   - `time`, the time from rcutils_system_time_now() in seconds, with
+ *     nanoseconds after the decimal point, e.g. `1524165462.123456789`
+ *   - `time_as_nanoseconds`, the same time in nanoseconds
+ *   - `thread_id`, the id the operating system uses for the calling thread
  *
  * The format string can use these tokens by referencing them in curly brackets,
  * e.g. `"[{severity}] [{name}]: {message} ({function_name}() at {file_name}:{line_number})"`.
  * Any number of tokens can be used.
  * The limit of the format string is 2048 characters.
  *
+ * If the `RCUTILS_CONSOLE_OUTPUT_WRITEV` environment variable is set to `1`,
+ * rcutils_logging_console_output_handler() writes each output line with a
+ * single `writev()` call to the file descriptor of `stdout` or `stderr`,
+ * bypassing the buffering and locking of the standard streams.
+ * Output lines of different threads and processes are then not interleaved
+ * (when writing to a pipe, only for lines up to `PIPE_BUF` bytes), but might
+ * be reordered relative to output which is still buffered in the standard
+ * streams.
+ * This option is ignored on Windows.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | Yes
- * Thread-Safe        | No
- * Uses Atomics       | No
- * Lock-Free          | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
  *
  * \param allocator rcutils_allocator_t to be used.
  * \return `RCUTILS_RET_OK` if successful.
@@ -122,8 +148,8 @@ rcutils_ret_t rcutils_logging_initialize(void);
  * ------------------ | -------------
  * Allocates Memory   | No
  * Thread-Safe        | No
- * Uses Atomics       | No
- * Lock-Free          | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
  *
  * \return `RCUTILS_RET_OK` if successful.
  * \return `RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID` if the internal logger
@@ -144,6 +170,19 @@ typedef struct rcutils_log_location_t
   size_t line_number;
 } rcutils_log_location_t;
 
+/// The effective level of a logger cached at a log call site.
+/**
+ * The members are maintained by rcutils_logging_logger_is_enabled_for_cache()
+ * and must be zero initialized.
+ */
+typedef struct rcutils_log_level_cache_t
+{
+  /// The length and a hash of the logger name the level belongs to, zero if not bound yet.
+  uint64_t logger_name;
+  /// The effective level of the logger together with the generation it is valid for.
+  uint64_t logger_level;
+} rcutils_log_level_cache_t;
+
 /// The severity levels of log messages / loggers.
 enum RCUTILS_LOG_SEVERITY
 {
@@ -175,6 +214,12 @@ typedef void (* rcutils_logging_output_handler_t)(
 );
 
 /// The function pointer of the current output handler.
+/**
+ * The logging functions load it with acquire semantics and
+ * rcutils_logging_set_output_handler() stores it with release semantics, so
+ * use these functions rather than accessing it directly while other threads
+ * are logging.
+ */
 RCUTILS_PUBLIC
 extern rcutils_logging_output_handler_t g_rcutils_logging_output_handler;
 
@@ -184,8 +229,8 @@ extern rcutils_logging_output_handler_t g_rcutils_logging_output_handler;
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \return The function pointer of the current output handler.
@@ -200,8 +245,8 @@ rcutils_logging_output_handler_t rcutils_logging_get_output_handler();
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \param function The function pointer of the output handler to be used.
@@ -209,11 +254,79 @@ rcutils_logging_output_handler_t rcutils_logging_get_output_handler();
 RCUTILS_PUBLIC
 void rcutils_logging_set_output_handler(rcutils_logging_output_handler_t function);
 
+/// The maximum number of sinks which can be added in addition to the output handler.
+#define RCUTILS_LOGGING_MAX_SINKS 8
+
+/// Add an output handler as a sink which receives the messages of a severity or above.
+/**
+ * Sinks receive the messages in addition to the current output handler, in
+ * the order in which they were added, after the current output handler.
+ * Each sink has its own severity threshold, which is applied on top of the
+ * levels of the loggers.
+ *
+ * If more than one handler receives a message, the message is formatted only
+ * once and passed to all of them as the format `"%s"` with the formatted
+ * message as its only argument.
+ *
+ * If the current output handler is `NULL`, only the sinks receive messages
+ * and rcutils_logging_logger_is_enabled_for() returns false for severities
+ * which no sink accepts, so that the logging macros skip these messages
+ * before evaluating their arguments.
+ *
+ * Adding an output handler which is a sink already changes its threshold.
+ * The sinks are removed when the logging system is shut down.
+ *
+ * Sinks may be added and removed while other threads log, a message which is
+ * being dispatched concurrently may reach the sinks from before the change.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param function The function pointer of the output handler.
+ * \param severity The lowest severity the sink receives.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory fails, or
+ * \return `RCUTILS_RET_ERROR` if `RCUTILS_LOGGING_MAX_SINKS` sinks were added already.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_add_sink(rcutils_logging_output_handler_t function, int severity);
+
+/// Remove a sink which has been added with rcutils_logging_add_sink().
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param function The function pointer of the output handler.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if the output handler isn't a sink, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory fails.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_remove_sink(rcutils_logging_output_handler_t function);
+
 /// The default severity level for loggers.
 /**
  * This level is used for (1) nameless log calls and (2) named log
  * calls where the effective level of the logger name is unspecified.
  *
+ * The logging functions access it atomically, so use
+ * rcutils_logging_get_default_logger_level() and
+ * rcutils_logging_set_default_logger_level() rather than accessing it
+ * directly while other threads are logging.
+ *
  * \see rcutils_logging_get_logger_effective_level()
  */
 RCUTILS_PUBLIC
@@ -225,8 +338,8 @@ extern int g_rcutils_logging_default_logger_level;
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \return The level.
@@ -241,8 +354,8 @@ int rcutils_logging_get_default_logger_level();
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \param level The level to be used.
@@ -260,8 +373,8 @@ void rcutils_logging_set_default_logger_level(int level);
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \param name The name of the logger, must be null terminated c string
@@ -284,8 +397,8 @@ int rcutils_logging_get_logger_level(const char * name);
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \param name The name of the logger
@@ -305,13 +418,21 @@ int rcutils_logging_get_logger_leveln(const char * name, size_t name_length);
  * If an empty string is specified as the name, the
  * `g_rcutils_logging_default_logger_level` will be set.
  *
+ * The levels of the loggers are published as immutable snapshots, so that
+ * threads which look up levels at the same time never block and never see a
+ * partial change.
+ * Setting a level copies the nodes on the way to the logger into a new
+ * snapshot, which replaces the previous one.
+ * Calls which set levels are serialized, and each one waits until no thread
+ * uses the previous snapshot anymore before freeing it.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | Yes
- * Thread-Safe        | No
- * Uses Atomics       | No
- * Lock-Free          | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
  *
  * \param name The name of the logger, must be null terminated c string.
  * \param level The level to be used.
@@ -324,8 +445,83 @@ RCUTILS_PUBLIC
 RCUTILS_WARN_UNUSED
 rcutils_ret_t rcutils_logging_set_logger_level(const char * name, int level);
 
+/// Set the severity levels of multiple loggers.
+/**
+ * Identical to calling rcutils_logging_set_logger_level() for each pair of
+ * name and level, in order, but the levels are published in a single
+ * snapshot and the cached levels are only invalidated once.
+ * If an empty string is specified as a name, the
+ * `g_rcutils_logging_default_logger_level` will be set.
+ *
+ * The levels are set until the first error occurs, so if an error is returned
+ * the levels of the preceding loggers have been set already.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param names The names of the loggers, each must be a null terminated c string.
+ * \param levels The levels to be used, one for each name.
+ * \param count The number of names and levels.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments, or
+ * \return `RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID` if severity map invalid, or
+ * \return `RCUTILS_RET_ERROR` if an unspecified error occured
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_set_logger_levels(
+  const char * const * names, const int * levels, size_t count);
+
+/// Set the severity level for all loggers whose names match a pattern.
+/**
+ * The pattern is a logger name where a segment `*` matches any one segment
+ * of a name and a segment `**` matches any number of segments, including none.
+ * For example `planner.*.costmap` matches `planner.global.costmap` but not
+ * `planner.costmap`, and `planner.**.costmap` matches both.
+ * Other segments, including segments which contain a `*` next to other
+ * characters, only match themselves.
+ *
+ * A pattern which matches a logger also applies to its descendants, like the
+ * level of an ancestor does.
+ * The closest match wins: a pattern only applies if it matches a deeper
+ * logger than the closest ancestor which has its level set by name, and the
+ * level set by name wins if both match the same logger.
+ * If several patterns match at the same depth, the pattern set last wins.
+ * Setting the level `RCUTILS_LOG_SEVERITY_UNSET` disables the pattern.
+ *
+ * The patterns are evaluated when the effective level of a logger is
+ * resolved, by a single pass over the segments of its name for all patterns,
+ * and the result is cached like the levels set by name.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param pattern The pattern, must be a non-empty null terminated c string.
+ * \param level The level to be used.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments, or
+ * \return `RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID` if severity map invalid, or
+ * \return `RCUTILS_RET_ERROR` if an unspecified error occured
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_set_logger_level_pattern(const char * pattern, int level);
+
 /// Determine if a logger is enabled for a severity level.
 /**
+ * While the flight recorder is started this is also true for the severities
+ * it records, see rcutils_logging_flight_recorder_start().
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
@@ -343,6 +539,40 @@ RCUTILS_PUBLIC
 RCUTILS_WARN_UNUSED
 bool rcutils_logging_logger_is_enabled_for(const char * name, int severity);
 
+/// Determine if a logger is enabled for a severity level, caching its level.
+/**
+ * Identical to rcutils_logging_logger_is_enabled_for() but the effective level
+ * of the logger is cached, so that subsequent calls only need to compare the
+ * cached generation with the current one.
+ * The cached level is invalidated whenever the level of any logger or the
+ * default level is set.
+ *
+ * The cache is bound to the first logger name passed with it, identified by
+ * the length and a hash of its contents, so the name may be stored at a
+ * different address on every call.
+ * Calls with a different name are not cached but still resolved.
+ * The logging macros use one static cache per call site.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No, provided logging system is already initialized
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param cache The pointer to the zero initialized cache or NULL, in which case
+ *   nothing is cached.
+ * \param name The name of the logger, must be null terminated c string or NULL.
+ * \param severity The severity level.
+ *
+ * \return true if the logger is enabled for the level; false otherwise.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool rcutils_logging_logger_is_enabled_for_cache(
+  rcutils_log_level_cache_t * cache, const char * name, int severity);
+
 /// Determine the effective level for a logger.
 /**
  * The effective level is determined as the severity level of
@@ -351,6 +581,8 @@ bool rcutils_logging_logger_is_enabled_for(const char * name, int severity);
  * The ancestor hierarchy is signified by logger names being separated by dots:
  * a logger named `x` is an ancestor of `x.y`, and both `x` and `x.y` are
  * ancestors of `x.y.z`, etc.
+ * Levels set for patterns of logger names take part in this as described in
+ * rcutils_logging_set_logger_level_pattern().
  * If the level has not been set for the logger nor any of its
  * ancestors, the default level is used.
  *
@@ -358,8 +590,8 @@ bool rcutils_logging_logger_is_enabled_for(const char * name, int severity);
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | No, provided logging system is already initialized
- * Thread-Safe        | No
- * Uses Atomics       | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
  * Lock-Free          | Yes
  *
  * \param name The name of the logger, must be null terminated c string.
@@ -372,6 +604,125 @@ RCUTILS_PUBLIC
 RCUTILS_WARN_UNUSED
 int rcutils_logging_get_logger_effective_level(const char * name);
 
+/// The handle of a logger, see rcutils_logging_get_logger().
+typedef struct rcutils_logger_t rcutils_logger_t;
+
+/// Get the handle of a logger, creating it the first time the name is used.
+/**
+ * The name is interned in the logging system, every call with the same name
+ * returns the same handle.
+ * The handles of the ancestors of the logger are created along with it, and
+ * the handle caches its effective level until any logger level changes.
+ * Logging with a handle, e.g. with the `_LOGGER` variants of the logging
+ * macros, therefore neither looks up nor copies the name of the logger, it is
+ * only passed on to the output handler.
+ *
+ * The handles stay valid until rcutils_logging_shutdown() is called, using a
+ * handle afterwards is undefined behavior.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, the first time the name is used
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | No
+ *
+ * \param name The name of the logger, must be null terminated c string.
+ *
+ * \return The handle of the logger, or
+ * \return `NULL` on invalid arguments, or
+ * \return `NULL` if allocating memory failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logger_t * rcutils_logging_get_logger(const char * name);
+
+/// Get the name of a logger.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param logger The handle of the logger.
+ *
+ * \return The name, which is valid as long as the handle, or
+ * \return `NULL` on invalid arguments.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+const char * rcutils_logger_get_name(const rcutils_logger_t * logger);
+
+/// Get the handle of the closest ancestor of a logger.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param logger The handle of the logger.
+ *
+ * \return The handle of the parent, e.g. of `x.y` for `x.y.z`, or
+ * \return `NULL` if the name of the logger has no separator, or
+ * \return `NULL` on invalid arguments.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logger_t * rcutils_logger_get_parent(const rcutils_logger_t * logger);
+
+/// Determine the effective level of a logger.
+/**
+ * This is equivalent to rcutils_logging_get_logger_effective_level() for the
+ * name of the logger.
+ * The level is cached in the handle, it is only determined again after any
+ * logger level has changed, using the cached levels of the ancestors.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param logger The handle of the logger.
+ *
+ * \return The level, or
+ * \return -1 on invalid arguments.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+int rcutils_logger_get_effective_level(rcutils_logger_t * logger);
+
+/// Determine if a logger is enabled for a severity level.
+/**
+ * Like rcutils_logging_logger_is_enabled_for(), but the effective level is
+ * cached in the handle, see rcutils_logger_get_effective_level().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param logger The handle of the logger.
+ * \param severity The severity level.
+ *
+ * \return true if the logger is enabled for the level; false otherwise.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool rcutils_logger_is_enabled_for(rcutils_logger_t * logger, int severity);
+
 /// Log a message.
 /**
  * The attributes of this function are also being influenced by the currently
@@ -399,6 +750,131 @@ void rcutils_log(
   const char * format,
   ...);
 
+/// Log a message without checking if the logger is enabled for the severity.
+/**
+ * Identical to rcutils_log() but the message is passed to the output handler
+ * without determining the effective level of the logger again.
+ * This is used by the logging macros after they have checked the level with
+ * rcutils_logging_logger_is_enabled_for_cache() and should only be called
+ * after such a check.
+ * The level is only checked again if the flight recorder records the
+ * severity, since the check might have passed only for the flight recorder.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param location The pointer to the location struct or NULL
+ * \param severity The severity level
+ * \param name The name of the logger, must be null terminated c string or NULL
+ * \param format The format string
+ * \param ... The variable arguments
+ */
+RCUTILS_PUBLIC
+void rcutils_log_unchecked(
+  const rcutils_log_location_t * location,
+  int severity,
+  const char * name,
+  const char * format,
+  ...);
+
+/// Log a message with a logger handle without checking if it is enabled for the severity.
+/**
+ * Like rcutils_log_unchecked(), but the logger is given by its handle, see
+ * rcutils_logging_get_logger().
+ * This is used by the `_LOGGER` variants of the logging macros after they
+ * have checked the level with rcutils_logger_is_enabled_for().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param location The pointer to the location struct or NULL
+ * \param severity The severity level
+ * \param logger The handle of the logger
+ * \param format The format string
+ * \param ... The variable arguments
+ */
+RCUTILS_PUBLIC
+void rcutils_log_logger_unchecked(
+  const rcutils_log_location_t * location,
+  int severity,
+  rcutils_logger_t * logger,
+  const char * format,
+  ...);
+
+/// Set the process wide budget of the log volume.
+/**
+ * When more lines or bytes per second are logged than the budget allows,
+ * the threshold below which messages are shed is raised by one step, first
+ * shedding `DEBUG` and then also `INFO` messages.
+ * Messages with a severity of `WARN` and above are always passed on.
+ * The threshold is raised at most once per second and lowered by one step for
+ * each second in which the volume, including an estimate of the shed
+ * messages, fits into the budget again.
+ * The number of shed messages is logged as a warning with the logger name
+ * `rcutils` every second in which messages were shed, and is available from
+ * rcutils_logging_get_volume_statistics().
+ *
+ * The lines are counted for all output handlers, while the bytes are only
+ * counted for the output handlers provided by this library.
+ * Setting the budget resets the statistics.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param lines_per_second The number of lines per second, or 0 for no limit.
+ * \param bytes_per_second The number of bytes per second, or 0 for no limit.
+ */
+RCUTILS_PUBLIC
+void rcutils_logging_set_volume_budget(uint64_t lines_per_second, uint64_t bytes_per_second);
+
+/// The statistics of the log volume budget.
+typedef struct rcutils_logging_volume_statistics_t
+{
+  /// Messages with a severity below this one are currently shed.
+  /**
+   * This is `RCUTILS_LOG_SEVERITY_DEBUG` if no messages are shed.
+   */
+  int shed_severity;
+  /// The number of `DEBUG` messages shed since the budget was set.
+  uint64_t shed_debug_count;
+  /// The number of `INFO` messages shed since the budget was set.
+  uint64_t shed_info_count;
+} rcutils_logging_volume_statistics_t;
+
+/// Get the statistics of the log volume budget.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param statistics The statistics are stored here.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_get_volume_statistics(
+  rcutils_logging_volume_statistics_t * statistics);
+
 /// The default output handler outputs log messages to the standard streams.
 /**
  * The messages with a severity level `DEBUG` and `INFO` are written to `stdout`.
@@ -411,8 +887,7 @@ void rcutils_log(
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
- * Allocates Memory   | No, for formatted outputs <= 1023 characters
- *                    | Yes, for formatted outputs >= 1024 characters
+ * Allocates Memory   | Yes, only when the scratch buffer of the thread has to grow
  * Thread-Safe        | Yes, if the underlying *printf functions are
  * Uses Atomics       | No
  * Lock-Free          | Yes
@@ -428,6 +903,165 @@ void rcutils_logging_console_output_handler(
   const rcutils_log_location_t * location,
   int severity, const char * name, const char * format, va_list * args);
 
+/// Get a scratch buffer of the calling thread for the use in output handlers.
+/**
+ * The buffer is reused by all calls on the same thread and only grows, so
+ * output handlers which format into it don't allocate memory once it is large
+ * enough.
+ * It is separate from the buffer which rcutils_logging_console_output_handler()
+ * writes its output lines into, so an output handler can still call the
+ * console output handler while using the buffer.
+ *
+ * The buffer is allocated with the allocator given to
+ * rcutils_logging_initialize_with_allocator().
+ * It stays valid until this function is called again on the same thread, or
+ * until it is released by rcutils_logging_release_thread_scratch_buffers(),
+ * rcutils_logging_shutdown() on the same thread, or the exit of the thread.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, only when the buffer has to grow
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param size The minimum size of the buffer in bytes.
+ * \param buffer The pointer to the buffer is stored here.
+ * \param buffer_size The actual size of the buffer is stored here, it might be
+ *   larger than the requested size.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t rcutils_logging_get_thread_scratch_buffer(
+  size_t size, char ** buffer, size_t * buffer_size);
+
+/// Release the logging scratch buffers of the calling thread.
+/**
+ * This releases the buffer of rcutils_logging_get_thread_scratch_buffer() as
+ * well as the buffer used by rcutils_logging_console_output_handler().
+ * They are allocated again by the next call using them.
+ * The buffers are released automatically at the exit of the thread, as well
+ * as by rcutils_logging_shutdown() for the thread calling it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+RCUTILS_PUBLIC
+void rcutils_logging_release_thread_scratch_buffers(void);
+
+/// Check the `once` condition of a logging macro call site.
+/**
+ * The state is updated atomically, so that exactly one thread passes the
+ * condition even if the call site is reached by many threads at once.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param once The static state of the call site, which must be initialized
+ *   to zero and only be accessed through this function.
+ * \return true for the first call with the state; false otherwise.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool rcutils_logging_condition_once(uint64_t * once);
+
+/// Check the `throttle` condition of a logging macro call site.
+/**
+ * The condition passes the first time and then if the last time it passed for
+ * the call site is at least the duration before the given time, in which case
+ * the last time is updated to the given time.
+ * The last time is updated with a compare-exchange, so that exactly one thread
+ * passes the condition within each throttle interval even if the call site is
+ * reached by many threads at once.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param last_logged The static time the condition last passed for the call
+ *   site, which must be initialized to zero and only be accessed through this
+ *   function.
+ * \param duration The duration of the throttle interval in nanoseconds.
+ * \param now The current time in nanoseconds.
+ * \return true if the message should be logged; false otherwise.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool rcutils_logging_condition_throttle(
+  rcutils_time_point_value_t * last_logged, rcutils_duration_value_t duration,
+  rcutils_time_point_value_t now);
+
+/// The state of the `rate limit` condition of a logging macro call site.
+/**
+ * The members must be initialized to zero and only be accessed through
+ * rcutils_logging_condition_rate_limit().
+ */
+typedef struct rcutils_logging_rate_limit_t
+{
+  /// The time at which the bucket of messages is full again.
+  rcutils_time_point_value_t full_time;
+  /// The number of messages ignored since the last message which passed.
+  uint64_t suppressed;
+} rcutils_logging_rate_limit_t;
+
+/// Check the `rate limit` condition of a logging macro call site.
+/**
+ * The condition is a token bucket which holds up to `burst` messages and is
+ * refilled by one message per `period`.
+ * A message passes if the bucket isn't empty, otherwise it is counted as
+ * suppressed.
+ * The number of messages suppressed since the last one which passed is
+ * returned with the next message which passes, so that it can be reported.
+ * The call site is only evaluated when it is reached, so the number is not
+ * reported when the bucket refills, but kept until the next message passes,
+ * which might be much later or never if the messages stopped for good.
+ *
+ * The bucket is represented by the time at which it is full again, which is
+ * updated with a compare-exchange, so that no more messages pass than the
+ * bucket allows even if the call site is reached by many threads at once.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param rate_limit The static state of the call site.
+ * \param burst The maximum number of messages which pass at once, at least
+ *   one message is allowed.
+ * \param period The duration in nanoseconds after which one more message can
+ *   pass, zero disables the limit.
+ * \param now The current time in nanoseconds.
+ * \param suppressed The number of messages suppressed since the last message
+ *   which passed is stored here if the message passes.
+ * \return true if the message should be logged; false otherwise.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool rcutils_logging_condition_rate_limit(
+  rcutils_logging_rate_limit_t * rate_limit, uint64_t burst, rcutils_duration_value_t period,
+  rcutils_time_point_value_t now, uint64_t * suppressed);
+
 // Provide the compiler with branch prediction information
 #ifndef _WIN32
 /**
@@ -453,14 +1087,31 @@ void rcutils_logging_console_output_handler(
 # define RCUTILS_UNLIKELY(x) (x)
 #endif  // _WIN32
 
+/**
+ * \def RCUTILS_LOGGING_IS_INITIALIZED
+ * \brief Check `g_rcutils_logging_initialized` with acquire semantics.
+ * Unlike reading the flag directly this is free of data races with the
+ * initialization in another thread.
+ */
+#ifdef _MSC_VER
+// Volatile reads have acquire semantics with the default /volatile:ms.
+# define RCUTILS_LOGGING_IS_INITIALIZED() \
+  (*(volatile bool *)&g_rcutils_logging_initialized)
+#else
+# define RCUTILS_LOGGING_IS_INITIALIZED() \
+  __atomic_load_n(&g_rcutils_logging_initialized, __ATOMIC_ACQUIRE)
+#endif  // _MSC_VER
+
 /**
  * \def RCUTILS_LOGGING_AUTOINIT
  * \brief Initialize the rcl logging library.
  * Usually it is unnecessary to call the macro directly.
  * All logging macros ensure that this has been called once.
+ * If several threads get here at the same time only one of them initializes
+ * the logging system, see rcutils_logging_initialize_with_allocator().
  */
 #define RCUTILS_LOGGING_AUTOINIT \
-  if (RCUTILS_UNLIKELY(!g_rcutils_logging_initialized)) { \
+  if (RCUTILS_UNLIKELY(!RCUTILS_LOGGING_IS_INITIALIZED())) { \
     rcutils_ret_t ret = rcutils_logging_initialize(); \
     if (ret != RCUTILS_RET_OK) { \
       RCUTILS_SAFE_FWRITE_TO_STDERR( \
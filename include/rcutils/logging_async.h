@@ -0,0 +1,204 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCUTILS__LOGGING_ASYNC_H_
+#define RCUTILS__LOGGING_ASYNC_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/logging.h"
+#include "rcutils/types/rcutils_ret.h"
+#include "rcutils/visibility_control.h"
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+/// The behavior of the asynchronous logging queue when it is full.
+typedef enum rcutils_logging_async_overflow_policy_t
+{
+  /// Discard the record which is being logged.
+  RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST = 0,
+  /// Discard the oldest queued record to make room for the one being logged.
+  RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_OLDEST = 1,
+  /// Wait for the drain thread to make room for the record being logged.
+  RCUTILS_LOGGING_ASYNC_OVERFLOW_BLOCK = 2,
+} rcutils_logging_async_overflow_policy_t;
+
+/// The options used to configure asynchronous logging.
+typedef struct rcutils_logging_async_options_t
+{
+  /// The maximum number of queued records, rounded up to the next power of two.
+  size_t queue_capacity;
+  /// The maximum length of a formatted message, longer messages are truncated.
+  size_t max_message_length;
+  /// The maximum length of a logger name, longer names are truncated.
+  size_t max_name_length;
+  /// The behavior when the queue is full.
+  rcutils_logging_async_overflow_policy_t overflow_policy;
+  /// The allocator used to allocate the queue.
+  rcutils_allocator_t allocator;
+} rcutils_logging_async_options_t;
+
+/// The counters of the asynchronous logging queue.
+typedef struct rcutils_logging_async_stats_t
+{
+  /// The number of records which have been queued.
+  uint64_t enqueued;
+  /// The number of records which have been passed on to the output handler.
+  uint64_t written;
+  /// The number of records which have been discarded because the queue was full.
+  uint64_t dropped;
+  /// The number of records whose message or logger name had to be truncated.
+  uint64_t truncated;
+} rcutils_logging_async_stats_t;
+
+/// Return the default options for asynchronous logging.
+/**
+ * The defaults are a queue of 1024 records, messages of up to 1023 characters,
+ * logger names of up to 255 characters, the
+ * `RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST` policy and the default allocator.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logging_async_options_t
+rcutils_logging_async_get_default_options(void);
+
+/// Start logging asynchronously.
+/**
+ * The current output handler is wrapped by rcutils_logging_async_output_handler(),
+ * which becomes the new output handler.
+ * Log calls then only format the message and push it, together with the
+ * severity, the logger name and a copy of the location, into a bounded
+ * lock-free queue.
+ * A dedicated thread pops the records from the queue and passes them to the
+ * wrapped output handler, using `"%s"` as format string and the formatted
+ * message as the only argument.
+ *
+ * The strings referenced by the location must stay valid until the record was
+ * written, which is the case for the locations created by the logging macros.
+ *
+ * The output handler should not be changed while logging asynchronously,
+ * setting a new one bypasses the queue until rcutils_logging_async_stop() is
+ * called.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param options The options to use, or NULL for the default options.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if the options are invalid, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating the queue failed, or
+ * \return `RCUTILS_RET_ERROR` if asynchronous logging is already running or
+ *   the drain thread couldn't be started.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_async_start(const rcutils_logging_async_options_t * options);
+
+/// Stop logging asynchronously.
+/**
+ * All queued records are passed on to the wrapped output handler before this
+ * function returns, after which the wrapped output handler is restored.
+ * This is called by rcutils_logging_shutdown().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if not logging asynchronously, or
+ * \return `RCUTILS_RET_ERROR` if the drain thread couldn't be joined.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_async_stop(void);
+
+/// Determine if logging asynchronously.
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+bool
+rcutils_logging_async_is_enabled(void);
+
+/// Get the counters of the asynchronous logging queue.
+/**
+ * The counters are reset by rcutils_logging_async_start().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[out] stats The struct to copy the counters into.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if `stats` is NULL.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_async_get_stats(rcutils_logging_async_stats_t * stats);
+
+/// The output handler which queues records while logging asynchronously.
+/**
+ * This is installed by rcutils_logging_async_start() and shouldn't be set
+ * manually.
+ * When not logging asynchronously, the record is passed on directly to the
+ * wrapped output handler, if any.
+ *
+ * A mutex is only locked to wake the drain thread if it waits for records
+ * because the queue was empty, or to wait for room in a full queue with the
+ * `RCUTILS_LOGGING_ASYNC_OVERFLOW_BLOCK` policy.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param location The pointer to the location struct or NULL
+ * \param severity The severity level
+ * \param name The name of the logger, must be null terminated c string
+ * \param format The format string for the message contents
+ * \param args The variable argument list for the message format string
+ */
+RCUTILS_PUBLIC
+void rcutils_logging_async_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // RCUTILS__LOGGING_ASYNC_H_
@@ -0,0 +1,192 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCUTILS__LOGGING_BINARY_H_
+#define RCUTILS__LOGGING_BINARY_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/logging.h"
+#include "rcutils/types/rcutils_ret.h"
+#include "rcutils/visibility_control.h"
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+/// The options used to configure logging binary records to a file.
+typedef struct rcutils_logging_binary_options_t
+{
+  /// The path of the log file, it is overwritten if it exists already.
+  const char * file_path;
+  /// The size of the buffer records are collected in before being written.
+  size_t buffer_size;
+  /// The allocator used to allocate the buffer and the tables of interned strings.
+  rcutils_allocator_t allocator;
+} rcutils_logging_binary_options_t;
+
+/// Return the default options for logging binary records.
+/**
+ * The defaults are no file path, which has to be set, a buffer of 1 MiB and
+ * the default allocator.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logging_binary_options_t
+rcutils_logging_binary_get_default_options(void);
+
+/// Open the file which rcutils_logging_binary_output_handler() writes to.
+/**
+ * This doesn't change the output handler, call
+ * `rcutils_logging_set_output_handler(rcutils_logging_binary_output_handler)`
+ * to log binary records.
+ *
+ * Instead of formatting the message, each record stores the time from
+ * rcutils_system_time_now(), the severity, the ids of the logger name, of the
+ * call site and of the format string, and the raw values of the arguments.
+ * The strings are written to the file only once, when they are used for the
+ * first time.
+ * The file is turned into text by rcutils_logging_binary_decode(), which is
+ * also available as the `decode_binary_log` executable of this package.
+ *
+ * Call sites are identified by the address and the contents of the location
+ * struct, the strings it references must not change, which is the case for
+ * the locations created by the logging macros.
+ *
+ * String arguments are copied, but wide characters, long doubles and `%n` are
+ * not supported, the messages using them are formatted right away and stored
+ * as a single string.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param options The options to use, `file_path` must be set.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if the options are invalid, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCUTILS_RET_ERROR` if a binary log file is open already or the
+ *   file couldn't be opened.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_binary_open(const rcutils_logging_binary_options_t * options);
+
+/// Write the buffered records to the file.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if no binary log file is open, or
+ * \return `RCUTILS_RET_ERROR` if writing to the file failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_binary_flush(void);
+
+/// Write the buffered records and close the file.
+/**
+ * Records logged afterwards with rcutils_logging_binary_output_handler() are
+ * discarded.
+ * This is called by rcutils_logging_shutdown().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if no binary log file is open, or
+ * \return `RCUTILS_RET_ERROR` if writing to or closing the file failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_binary_close(void);
+
+/// The output handler which writes binary records.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, only for new strings and call sites, or when the scratch buffer of the thread has to grow
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param location The pointer to the location struct or NULL
+ * \param severity The severity level
+ * \param name The name of the logger, must be null terminated c string
+ * \param format The format string for the message contents
+ * \param args The variable argument list for the message format string
+ */
+RCUTILS_PUBLIC
+void rcutils_logging_binary_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args);
+
+/// Decode a binary log file into text.
+/**
+ * Each record is written as one line in the format
+ * `[{severity}] [{seconds}.{nanoseconds}] [{name}]: {message}`, followed by
+ * ` ({function_name}() at {file_name}:{line_number})` if requested and the
+ * record has a location.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param input The binary log file, opened for reading in binary mode.
+ * \param output The stream to write the text to.
+ * \param with_location Whether to write the locations of the records.
+ * \param allocator The allocator used for the interned strings and messages.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` on invalid arguments, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCUTILS_RET_ERROR` if the input isn't a valid binary log file or
+ *   writing the output failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_binary_decode(
+  FILE * input, FILE * output, bool with_location, rcutils_allocator_t allocator);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // RCUTILS__LOGGING_BINARY_H_
@@ -0,0 +1,168 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCUTILS__LOGGING_FILE_H_
+#define RCUTILS__LOGGING_FILE_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/logging.h"
+#include "rcutils/types/rcutils_ret.h"
+#include "rcutils/visibility_control.h"
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+/// The options used to configure logging to a file.
+typedef struct rcutils_logging_file_options_t
+{
+  /// The path of the log file, output is appended if it exists already.
+  const char * file_path;
+  /// The size of the buffer output lines are collected in before being written.
+  size_t buffer_size;
+  /// The maximum time in nanoseconds output lines are buffered, or 0 to not limit it.
+  int64_t flush_period_ns;
+  /// Output lines of this or a higher severity level are written immediately.
+  int flush_severity;
+  /// The size at which the log file is rotated, or 0 to never rotate it.
+  size_t max_file_size;
+  /// The number of rotated log files which are kept, named `<file_path>.1` (the newest) and so on.
+  size_t max_rotated_files;
+  /// The allocator used to allocate the buffer.
+  rcutils_allocator_t allocator;
+} rcutils_logging_file_options_t;
+
+/// Return the default options for logging to a file.
+/**
+ * The defaults are no file path, which has to be set, a buffer of 1 MiB, a
+ * flush period of one second, flushing immediately for `ERROR` and `FATAL`,
+ * rotating the file at 100 MiB, keeping 5 rotated files and the default
+ * allocator.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logging_file_options_t
+rcutils_logging_file_get_default_options(void);
+
+/// Open the log file which rcutils_logging_file_output_handler() writes to.
+/**
+ * This doesn't change the output handler, call
+ * `rcutils_logging_set_output_handler(rcutils_logging_file_output_handler)`
+ * to log to the file.
+ *
+ * Output lines are formatted like the ones of
+ * rcutils_logging_console_output_handler() and collected in a buffer, which
+ * is written to the file with a single call when it is full, when a line of
+ * the flush severity is logged, when the flush period has passed (checked by a
+ * background thread), on rcutils_logging_file_flush() and when the file is
+ * closed.
+ *
+ * Before the file would exceed the maximum file size, it is renamed to
+ * `<file_path>.1`, the existing rotated files are renamed to the next number,
+ * the oldest one beyond the maximum number of rotated files is removed, and a
+ * new file is started.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param options The options to use, `file_path` must be set.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if the options are invalid, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating the buffer failed, or
+ * \return `RCUTILS_RET_ERROR` if a log file is open already, the file couldn't
+ *   be opened or the flush thread couldn't be started.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_file_open(const rcutils_logging_file_options_t * options);
+
+/// Write the buffered output lines to the log file.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if no log file is open, or
+ * \return `RCUTILS_RET_ERROR` if writing to the file failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_file_flush(void);
+
+/// Write the buffered output lines and close the log file.
+/**
+ * Output lines logged afterwards with rcutils_logging_file_output_handler()
+ * are discarded.
+ * This is called by rcutils_logging_shutdown().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if no log file is open, or
+ * \return `RCUTILS_RET_ERROR` if writing to or closing the file failed, or the
+ *   flush thread couldn't be joined.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_file_close(void);
+
+/// The output handler which writes output lines to the log file.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, only when the scratch buffer of the thread has to grow
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param location The pointer to the location struct or NULL
+ * \param severity The severity level
+ * \param name The name of the logger, must be null terminated c string
+ * \param format The format string for the message contents
+ * \param args The variable argument list for the message format string
+ */
+RCUTILS_PUBLIC
+void rcutils_logging_file_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // RCUTILS__LOGGING_FILE_H_
@@ -0,0 +1,162 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCUTILS__LOGGING_FLIGHT_RECORDER_H_
+#define RCUTILS__LOGGING_FLIGHT_RECORDER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/types/rcutils_ret.h"
+#include "rcutils/visibility_control.h"
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+/// The options used to configure the flight recorder.
+typedef struct rcutils_logging_flight_recorder_options_t
+{
+  /// The path of the file the records are dumped to, it is overwritten by each dump.
+  const char * file_path;
+  /// The size of the ring each thread records into, rounded up to a power of two.
+  size_t thread_buffer_size;
+  /// The number of threads which can record at the same time.
+  size_t max_threads;
+  /// The lowest severity which is recorded, regardless of the levels of the loggers.
+  int severity;
+  /// Whether the records are dumped when a message with the severity `FATAL` is logged.
+  bool dump_on_fatal;
+  /// Whether the records are dumped when the process receives a fatal signal.
+  bool dump_on_signal;
+  /// The allocator used to allocate the rings and the buffers of the dump.
+  rcutils_allocator_t allocator;
+} rcutils_logging_flight_recorder_options_t;
+
+/// Return the default options for the flight recorder.
+/**
+ * The defaults are no file path, which has to be set, rings of 64 KiB for up
+ * to 64 threads which record all severities starting with `DEBUG`, dumps on
+ * `FATAL` messages and fatal signals, and the default allocator.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_logging_flight_recorder_options_t
+rcutils_logging_flight_recorder_get_default_options(void);
+
+/// Start recording the recent log records of each thread in memory.
+/**
+ * While the flight recorder is started every message with at least the
+ * recorded severity is kept in a fixed size ring of the logging thread, also
+ * if the level of its logger filters it out.
+ * The oldest records of a thread are overwritten once its ring is full.
+ * Nothing is formatted or written until the records are dumped, so that the
+ * history of the `DEBUG` messages is available after a crash while running at
+ * a higher level.
+ *
+ * Each record stores the time from rcutils_system_time_now(), the severity,
+ * the logger name, pointers to the format string and the strings of the
+ * location, and the raw values of the arguments like
+ * rcutils_logging_binary_output_handler().
+ * The format strings and the strings of the locations must therefore stay
+ * valid while the flight recorder is started, which is the case for string
+ * literals and the locations created by the logging macros.
+ *
+ * The records of all threads are dumped ordered by time in the binary log
+ * format, which is turned into text by rcutils_logging_binary_decode() or the
+ * `decode_binary_log` executable of this package.
+ * Dumping only uses memory allocated when starting and async-signal-safe
+ * system calls, so that it can run from a signal handler.
+ * If `dump_on_signal` is set, handlers for `SIGSEGV`, `SIGBUS`, `SIGFPE`,
+ * `SIGILL` and `SIGABRT` are installed which dump the records before the
+ * previous handler is restored and the signal is raised again.
+ *
+ * A ring is allocated when a thread logs for the first time and is reused by
+ * another thread after the thread exits, keeping the records of the exited
+ * thread.
+ * The messages of threads beyond `max_threads` are not recorded.
+ * Records larger than half of a ring are not recorded either.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param options The options to use, `file_path` must be set.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_INVALID_ARGUMENT` if the options are invalid, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCUTILS_RET_ERROR` if the flight recorder is started already or
+ *   the signal handlers couldn't be installed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_flight_recorder_start(const rcutils_logging_flight_recorder_options_t * options);
+
+/// Stop recording and release the rings, without dumping the records.
+/**
+ * The previous signal handlers are restored.
+ * This is called by rcutils_logging_shutdown().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \return `RCUTILS_RET_OK` if successful or if the flight recorder isn't started, or
+ * \return `RCUTILS_RET_ERROR` if the signal handlers couldn't be restored.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_flight_recorder_stop(void);
+
+/// Write the records of all threads to the file of the flight recorder.
+/**
+ * The records stay in the rings, a later dump overwrites the file with the
+ * records at that time.
+ * Records which are overwritten by their thread while they are being dumped
+ * are skipped.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_ERROR` if the flight recorder isn't started, another
+ *   dump is in progress or writing the file failed.
+ */
+RCUTILS_PUBLIC
+RCUTILS_WARN_UNUSED
+rcutils_ret_t
+rcutils_logging_flight_recorder_dump(void);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // RCUTILS__LOGGING_FLIGHT_RECORDER_H_
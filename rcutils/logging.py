@@ -63,6 +63,20 @@ throttle_args = {
 throttle_doc_lines = [
     'Log calls are being ignored if the last logged message is not longer ago than the specified '
     'duration.']
+rate_limit_params = OrderedDict((
+    ('burst', 'The number of messages which can be logged in a burst'),
+    ('period', 'The duration in milliseconds after which one more message can be logged'),
+))
+# The condition reports the number of suppressed messages with the severity and the name of the
+# logger, which are filled in by get_macro_arguments().
+rate_limit_args = {
+    'condition_before':
+        'RCUTILS_LOG_CONDITION_RATELIMIT_BEFORE(burst, period, {severity}, {name})',
+    'condition_after': 'RCUTILS_LOG_CONDITION_RATELIMIT_AFTER'}
+rate_limit_doc_lines = [
+    'Log calls are being ignored if the bucket of burst messages, which is refilled by one '
+    'message per period, is empty. The number of ignored log calls is logged before the next '
+    'message which passes, it is not reported if no further message passes.']
 
 
 def get_suffix_from_features(features):
@@ -76,6 +90,8 @@ def get_suffix_from_features(features):
         suffix += '_SKIPFIRST'
     if 'throttle' in features:
         suffix += '_THROTTLE'
+    if 'rate_limit' in features:
+        suffix += '_RATELIMIT'
     if 'once' in features:
         suffix += '_ONCE'
     if 'named' in features:
@@ -168,6 +184,14 @@ feature_combinations = OrderedDict((
             }, **name_args
         },
         doc_lines=skipfirst_doc_lines + throttle_doc_lines + name_doc_lines)),
+    (('rate_limit'), Feature(
+        params=rate_limit_params,
+        args=rate_limit_args,
+        doc_lines=rate_limit_doc_lines)),
+    (('rate_limit', 'named'), Feature(
+        params=OrderedDict((*rate_limit_params.items(), *name_params.items())),
+        args={**rate_limit_args, **name_args},
+        doc_lines=rate_limit_doc_lines + name_doc_lines)),
 ))
 
 
@@ -175,9 +199,72 @@ def get_macro_parameters(feature_combination):
     return feature_combinations[feature_combination].params
 
 
-def get_macro_arguments(feature_combination):
-    args = []
+def get_macro_arguments(feature_combination, severity=None, name=None, condition_name=None):
+    args = OrderedDict()
     for k, default_value in default_args.items():
-        value = feature_combinations[feature_combination].args.get(k, default_value)
-        args.append(value)
-    return args
+        args[k] = feature_combinations[feature_combination].args.get(k, default_value)
+    if name is not None:
+        args['name'] = name
+    if condition_name is None:
+        condition_name = args['name']
+    if severity is not None:
+        args = OrderedDict(
+            (k, v.format(severity='RCUTILS_LOG_SEVERITY_' + severity, name=condition_name))
+            for k, v in args.items())
+    return list(args.values())
+
+
+static_name_params = OrderedDict((
+    ('logger', 'The name of the logger as an identifier, see RCUTILS_LOG_MIN_SEVERITY_FOR()'),
+))
+# The feature combinations of the named macros have a counterpart which takes the name of the
+# logger as an identifier instead of a string, so that the preprocessor can look up a minimum
+# severity for each logger.
+static_feature_combinations = OrderedDict(
+    (fc, f) for fc, f in feature_combinations.items() if 'named' in fc)
+
+
+def get_static_suffix_from_features(features):
+    return get_suffix_from_features(features).replace('_NAMED', '_STATIC')
+
+
+def get_static_macro_parameters(feature_combination):
+    params = OrderedDict()
+    for k, v in get_macro_parameters(feature_combination).items():
+        if k in name_params:
+            params.update(static_name_params)
+        else:
+            params[k] = v
+    return params
+
+
+def get_static_macro_arguments(feature_combination, severity=None):
+    return get_macro_arguments(feature_combination, severity=severity, name='#logger')
+
+
+logger_name_params = OrderedDict((
+    ('logger', 'The logger handle returned by rcutils_logging_get_logger()'),
+))
+# The feature combinations of the named macros also have a counterpart which takes a logger
+# handle, the conditions which need the name of the logger get it from the handle.
+logger_feature_combinations = static_feature_combinations
+
+
+def get_logger_suffix_from_features(features):
+    return get_suffix_from_features(features).replace('_NAMED', '_LOGGER')
+
+
+def get_logger_macro_parameters(feature_combination):
+    params = OrderedDict()
+    for k, v in get_macro_parameters(feature_combination).items():
+        if k in name_params:
+            params.update(logger_name_params)
+        else:
+            params[k] = v
+    return params
+
+
+def get_logger_macro_arguments(feature_combination, severity=None):
+    return get_macro_arguments(
+        feature_combination, severity=severity, name='logger',
+        condition_name='rcutils_logger_get_name(__rcutils_logging_logger)')
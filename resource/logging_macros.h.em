@@ -47,12 +47,16 @@ extern "C"
 #define RCUTILS_LOG_MIN_SEVERITY RCUTILS_LOG_MIN_SEVERITY_DEBUG
 #endif
 
-// TODO(dhood): optimise severity check via notifyLoggerLevelsChanged concept or similar.
 /**
  * \def RCUTILS_LOG_COND_NAMED
  * The logging macro all other logging macros call directly or indirectly.
  *
- * \note The condition will only be evaluated if this logging statement is enabled.
+ * \note The condition and the format arguments will only be evaluated if this
+ *   logging statement is enabled, and the message is passed to
+ *   rcutils_log_unchecked() without checking the level of the logger again.
+ * \note The effective level of the logger is cached in a static cache of the
+ *   call site until any logger level changes, see
+ *   rcutils_logging_logger_is_enabled_for_cache().
  *
  * \param severity The severity level
  * \param condition_before The condition macro(s) inserted before the log call
@@ -64,9 +68,38 @@ extern "C"
   { \
     RCUTILS_LOGGING_AUTOINIT \
     static rcutils_log_location_t __rcutils_logging_location = {__func__, __FILE__, __LINE__}; \
-    if (rcutils_logging_logger_is_enabled_for(name, severity)) { \
+    static rcutils_log_level_cache_t __rcutils_logging_level_cache = {0, 0}; \
+    if (rcutils_logging_logger_is_enabled_for_cache( \
+        &__rcutils_logging_level_cache, name, severity)) \
+    { \
       condition_before \
-      rcutils_log(&__rcutils_logging_location, severity, name, __VA_ARGS__); \
+      rcutils_log_unchecked(&__rcutils_logging_location, severity, name, __VA_ARGS__); \
+      condition_after \
+    } \
+  }
+
+/**
+ * \def RCUTILS_LOG_COND_LOGGER
+ * The logging macro all logging macros taking a logger handle call.
+ *
+ * Unlike RCUTILS_LOG_COND_NAMED() the effective level is cached in the logger
+ * handle, so the name of the logger is only used to output the message.
+ * The logging system has been initialized when the handle was created.
+ *
+ * \param severity The severity level
+ * \param condition_before The condition macro(s) inserted before the log call
+ * \param condition_after The condition macro(s) inserted after the log call
+ * \param logger The logger handle returned by rcutils_logging_get_logger()
+ * \param ... The format string, followed by the variable arguments for the format string
+ */
+#define RCUTILS_LOG_COND_LOGGER(severity, condition_before, condition_after, logger, ...) \
+  { \
+    rcutils_logger_t * __rcutils_logging_logger = (logger); \
+    static rcutils_log_location_t __rcutils_logging_location = {__func__, __FILE__, __LINE__}; \
+    if (rcutils_logger_is_enabled_for(__rcutils_logging_logger, severity)) { \
+      condition_before \
+      rcutils_log_logger_unchecked( \
+        &__rcutils_logging_location, severity, __rcutils_logging_logger, __VA_ARGS__); \
       condition_after \
     } \
   }
@@ -90,9 +123,8 @@ extern "C"
  */
 #define RCUTILS_LOG_CONDITION_ONCE_BEFORE \
   { \
-    static int __rcutils_logging_once = 0; \
-    if (RCUTILS_UNLIKELY(0 == __rcutils_logging_once)) { \
-      __rcutils_logging_once = 1;
+    static uint64_t __rcutils_logging_once = 0; \
+    if (RCUTILS_UNLIKELY(rcutils_logging_condition_once(&__rcutils_logging_once))) {
 /**
  * \def RCUTILS_LOG_CONDITION_ONCE_AFTER
  * A macro finalizing the `once` condition.
@@ -150,9 +182,8 @@ typedef bool (* RclLogFilter)();
  */
 #define RCUTILS_LOG_CONDITION_SKIPFIRST_BEFORE \
   { \
-    static bool __rcutils_logging_first = true; \
-    if (RCUTILS_UNLIKELY(true == __rcutils_logging_first)) { \
-      __rcutils_logging_first = false; \
+    static uint64_t __rcutils_logging_first = 0; \
+    if (RCUTILS_UNLIKELY(rcutils_logging_condition_once(&__rcutils_logging_first))) { \
     } else {
 /**
  * \def RCUTILS_LOG_CONDITION_SKIPFIRST_AFTER
@@ -181,11 +212,11 @@ typedef bool (* RclLogFilter)();
         "%s() at %s:%d getting current steady time failed\n", \
         __func__, __FILE__, __LINE__); \
     } else { \
-      __rcutils_logging_condition = __rcutils_logging_now >= __rcutils_logging_last_logged + __rcutils_logging_duration; \
+      __rcutils_logging_condition = rcutils_logging_condition_throttle( \
+        &__rcutils_logging_last_logged, __rcutils_logging_duration, __rcutils_logging_now); \
     } \
  \
-    if (RCUTILS_LIKELY(__rcutils_logging_condition)) { \
-      __rcutils_logging_last_logged = __rcutils_logging_now;
+    if (RCUTILS_LIKELY(__rcutils_logging_condition)) {
 
 /**
  * \def RCUTILS_LOG_CONDITION_THROTTLE_AFTER
@@ -195,15 +226,121 @@ typedef bool (* RclLogFilter)();
   }
 ///@@}
 
+/** @@name Macros for the `rate limit` condition which ignores log calls if
+ * the bucket of messages is empty, and reports the number of ignored calls
+ * before the next message which passes at the same call site.
+ */
+///@@{
+/**
+ * \def RCUTILS_LOG_CONDITION_RATELIMIT_BEFORE
+ * A macro initializing and checking the `rate limit` condition.
+ */
+#define RCUTILS_LOG_CONDITION_RATELIMIT_BEFORE(burst, period, severity, name) { \
+    static rcutils_logging_rate_limit_t __rcutils_logging_rate_limit = {0, 0}; \
+    rcutils_time_point_value_t __rcutils_logging_now = 0; \
+    uint64_t __rcutils_logging_suppressed = 0; \
+    bool __rcutils_logging_condition = true; \
+    if (rcutils_steady_time_now(&__rcutils_logging_now) != RCUTILS_RET_OK) { \
+      rcutils_log( \
+        &__rcutils_logging_location, RCUTILS_LOG_SEVERITY_ERROR, "", \
+        "%s() at %s:%d getting current steady time failed\n", \
+        __func__, __FILE__, __LINE__); \
+    } else { \
+      __rcutils_logging_condition = rcutils_logging_condition_rate_limit( \
+        &__rcutils_logging_rate_limit, burst, RCUTILS_MS_TO_NS((rcutils_duration_value_t)period), \
+        __rcutils_logging_now, &__rcutils_logging_suppressed); \
+    } \
+ \
+    if (RCUTILS_LIKELY(__rcutils_logging_condition)) { \
+      if (RCUTILS_UNLIKELY(__rcutils_logging_suppressed > 0)) { \
+        rcutils_log_unchecked( \
+          &__rcutils_logging_location, severity, name, "%llu similar messages suppressed", \
+          (unsigned long long)__rcutils_logging_suppressed); \
+      }
+
+/**
+ * \def RCUTILS_LOG_CONDITION_RATELIMIT_AFTER
+ * A macro finalizing the `rate limit` condition.
+ */
+#define RCUTILS_LOG_CONDITION_RATELIMIT_AFTER } \
+  }
+///@@}
+
 @{
 import sys
 sys.path.insert(0, rcutils_module_path)
 from rcutils.logging import feature_combinations
 from rcutils.logging import get_macro_arguments
+from rcutils.logging import get_logger_macro_arguments
+from rcutils.logging import get_logger_macro_parameters
+from rcutils.logging import get_logger_suffix_from_features
 from rcutils.logging import get_macro_parameters
+from rcutils.logging import get_static_macro_arguments
+from rcutils.logging import get_static_macro_parameters
+from rcutils.logging import get_static_suffix_from_features
 from rcutils.logging import get_suffix_from_features
+from rcutils.logging import logger_feature_combinations
 from rcutils.logging import severities
+from rcutils.logging import static_feature_combinations
 }@
+/** @@name Macros for compiling out logging macros per logger.
+ */
+///@@{
+/**
+ * \def RCUTILS_LOG_MIN_SEVERITY_FOR
+ * The minimum severity of the `_STATIC` logging macros for a logger.
+ *
+ * Define RCUTILS_LOG_MIN_SEVERITY_FOR_<logger>=RCUTILS_LOG_MIN_SEVERITY_[DEBUG|INFO|WARN|ERROR|FATAL|NONE]
+ * in your build options to compile out the `_STATIC` logging macros of that
+ * logger below that severity, e.g. `RCUTILS_LOG_MIN_SEVERITY_FOR_my_package`
+ * for the logger `my_package`.
+ * Loggers without such a definition use RCUTILS_LOG_MIN_SEVERITY.
+ * Since the preprocessor can't compare string literals the logger is named by
+ * an identifier, which is also used as the name of the logger at runtime.
+ *
+ * \param logger The name of the logger as an identifier
+ * \return The minimum severity as one of the RCUTILS_LOG_MIN_SEVERITY_* values
+ */
+#define RCUTILS_LOG_MIN_SEVERITY_FOR(logger) \
+  __RCUTILS_LOG_MIN_SEVERITY_FOR_DEFINITION(RCUTILS_LOG_MIN_SEVERITY_FOR_ ## logger)
+// The definition for the logger expands to a number which selects a placeholder with a comma, an
+// undefined one stays an identifier without a comma and the second argument is the default.
+#define __RCUTILS_LOG_MIN_SEVERITY_FOR_DEFINITION(definition) \
+  __RCUTILS_LOG_MIN_SEVERITY_FOR_VALUE(definition)
+#define __RCUTILS_LOG_MIN_SEVERITY_FOR_VALUE(value) \
+  __RCUTILS_LOG_MIN_SEVERITY_FOR_PLACEHOLDER(__RCUTILS_LOG_MIN_SEVERITY_PLACEHOLDER_ ## value)
+#define __RCUTILS_LOG_MIN_SEVERITY_FOR_PLACEHOLDER(placeholder_or_identifier) \
+  __RCUTILS_LOG_SECOND_ARGUMENT(placeholder_or_identifier, RCUTILS_LOG_MIN_SEVERITY, ~)
+#define __RCUTILS_LOG_SECOND_ARGUMENT(first, second, ...) second
+@[for min_severity in range(len(severities) + 1)]@
+#define __RCUTILS_LOG_MIN_SEVERITY_PLACEHOLDER_@(min_severity) ~, @(min_severity)
+@[end for]@
+
+/**
+ * \def RCUTILS_LOG_STATIC_SELECT
+ * Expands to a macro which expands to its arguments if the `_STATIC` logging
+ * macros of the logger are enabled for the severity and to nothing otherwise.
+ *
+ * \param min_severity The severity as one of the RCUTILS_LOG_MIN_SEVERITY_* values
+ * \param logger The name of the logger as an identifier
+ */
+#define RCUTILS_LOG_STATIC_SELECT(min_severity, logger) \
+  __RCUTILS_LOG_STATIC_SELECT_VALUES(RCUTILS_LOG_MIN_SEVERITY_FOR(logger), min_severity)
+#define __RCUTILS_LOG_STATIC_SELECT_VALUES(logger_min_severity, min_severity) \
+  __RCUTILS_LOG_STATIC_SELECT_PASTE(logger_min_severity, min_severity)
+#define __RCUTILS_LOG_STATIC_SELECT_PASTE(logger_min_severity, min_severity) \
+  __RCUTILS_LOG_STATIC_ ## logger_min_severity ## _ ## min_severity
+@[for logger_min_severity in range(len(severities) + 1)]@
+@[  for min_severity in range(len(severities))]@
+@[    if min_severity >= logger_min_severity]@
+#define __RCUTILS_LOG_STATIC_@(logger_min_severity)_@(min_severity)(...) __VA_ARGS__
+@[    else]@
+#define __RCUTILS_LOG_STATIC_@(logger_min_severity)_@(min_severity)(...)
+@[    end if]@
+@[  end for]@
+@[end for]@
+///@@}
+
 @[for severity in severities]@
 /** @@name Logging macros for severity @(severity).
  */
@@ -241,7 +378,76 @@ from rcutils.logging import severities
 # define RCUTILS_LOG_@(severity)@(suffix)(@(''.join([p + ', ' for p in get_macro_parameters(feature_combination).keys()]))...) \
   RCUTILS_LOG_COND_NAMED( \
     RCUTILS_LOG_SEVERITY_@(severity), \
-    @(''.join([str(a) + ', ' for a in get_macro_arguments(feature_combination)]))\
+    @(''.join([str(a) + ', ' for a in get_macro_arguments(feature_combination, severity)]))\
+    __VA_ARGS__)
+@[ end for]@
+#endif
+
+// logging macros for severity @(severity) which are compiled out per logger
+@[ for feature_combination in static_feature_combinations]@
+@{suffix = get_static_suffix_from_features(feature_combination)}@
+/**
+ * \def RCUTILS_LOG_@(severity)@(suffix)
+ * Log a message with severity @(severity) unless compiled out for the logger,
+ * see RCUTILS_LOG_MIN_SEVERITY_FOR()@
+@[ if static_feature_combinations[feature_combination].doc_lines]@
+, with the following conditions:
+@[   for doc_line in static_feature_combinations[feature_combination].doc_lines]@
+ * - @(doc_line)
+@[   end for]@
+ *
+ * \note The conditions will only be evaluated if this logging statement is enabled.
+ *
+@[ else]@
+.
+@[ end if]@
+@[ for param_name, doc_line in get_static_macro_parameters(feature_combination).items()]@
+ * \param @(param_name) @(doc_line)
+@[ end for]@
+ * \param ... The format string, followed by the variable arguments for the format string
+ */
+# define RCUTILS_LOG_@(severity)@(suffix)(@(''.join([p + ', ' for p in get_static_macro_parameters(feature_combination).keys()]))...) \
+  RCUTILS_LOG_STATIC_SELECT(RCUTILS_LOG_MIN_SEVERITY_@(severity), logger)( \
+    RCUTILS_LOG_COND_NAMED( \
+      RCUTILS_LOG_SEVERITY_@(severity), \
+      @(''.join([str(a) + ', ' for a in get_static_macro_arguments(feature_combination, severity)]))\
+      __VA_ARGS__))
+@[ end for]@
+
+// logging macros for severity @(severity) which take a logger handle
+#if (RCUTILS_LOG_MIN_SEVERITY > RCUTILS_LOG_MIN_SEVERITY_@(severity))
+@[ for feature_combination in logger_feature_combinations]@
+@{suffix = get_logger_suffix_from_features(feature_combination)}@
+/// Empty logging macro due to the preprocessor definition of RCUTILS_LOG_MIN_SEVERITY.
+# define RCUTILS_LOG_@(severity)@(suffix)(@(''.join([p + ', ' for p in get_logger_macro_parameters(feature_combination).keys()]))format, ...)
+@[ end for]@
+#else
+@[ for feature_combination in logger_feature_combinations]@
+@{suffix = get_logger_suffix_from_features(feature_combination)}@
+/**
+ * \def RCUTILS_LOG_@(severity)@(suffix)
+ * Log a message with severity @(severity) using a logger handle, see
+ * rcutils_logging_get_logger()@
+@[ if logger_feature_combinations[feature_combination].doc_lines]@
+, with the following conditions:
+@[   for doc_line in logger_feature_combinations[feature_combination].doc_lines]@
+ * - @(doc_line)
+@[   end for]@
+ *
+ * \note The conditions will only be evaluated if this logging statement is enabled.
+ *
+@[ else]@
+.
+@[ end if]@
+@[ for param_name, doc_line in get_logger_macro_parameters(feature_combination).items()]@
+ * \param @(param_name) @(doc_line)
+@[ end for]@
+ * \param ... The format string, followed by the variable arguments for the format string
+ */
+# define RCUTILS_LOG_@(severity)@(suffix)(@(''.join([p + ', ' for p in get_logger_macro_parameters(feature_combination).keys()]))...) \
+  RCUTILS_LOG_COND_LOGGER( \
+    RCUTILS_LOG_SEVERITY_@(severity), \
+    @(''.join([str(a) + ', ' for a in get_logger_macro_arguments(feature_combination, severity)]))\
     __VA_ARGS__)
 @[ end for]@
 #endif
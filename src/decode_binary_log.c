@@ -0,0 +1,58 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Decode a file written by rcutils_logging_binary_output_handler() to stdout.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/logging_binary.h"
+
+int main(int argc, char ** argv)
+{
+  bool with_location = false;
+  const char * file_path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--with-location") == 0) {
+      with_location = true;
+    } else if (NULL == file_path && argv[i][0] != '-') {
+      file_path = argv[i];
+    } else {
+      file_path = NULL;
+      break;
+    }
+  }
+  if (NULL == file_path) {
+    fprintf(stderr, "usage: %s [--with-location] <binary log file>\n", argv[0]);
+    return 2;
+  }
+
+  FILE * input = fopen(file_path, "rb");
+  if (NULL == input) {
+    fprintf(stderr, "failed to open '%s'\n", file_path);
+    return 1;
+  }
+  rcutils_ret_t ret = rcutils_logging_binary_decode(
+    input, stdout, with_location, rcutils_get_default_allocator());
+  fclose(input);
+  if (ret != RCUTILS_RET_OK) {
+    fprintf(stderr, "failed to decode '%s': %s\n", file_path, rcutils_get_error_string_safe());
+    rcutils_reset_error();
+    return 1;
+  }
+  return 0;
+}
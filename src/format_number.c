@@ -0,0 +1,163 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "rcutils/format_number.h"
+
+// The decimal digits of all numbers from 0 to 99.
+static const char g_rcutils_digit_pairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/// Write exactly two digits.
+static inline void
+__rcutils_format_two_digits(unsigned int value, char * buffer)
+{
+  memcpy(buffer, g_rcutils_digit_pairs + 2 * value, 2);
+}
+
+/// Write exactly eight digits of a value below 100000000 using 32 bit arithmetic.
+static inline void
+__rcutils_format_eight_digits(uint32_t value, char * buffer)
+{
+  __rcutils_format_two_digits(value / 1000000, buffer);
+  __rcutils_format_two_digits(value / 10000 % 100, buffer + 2);
+  __rcutils_format_two_digits(value / 100 % 100, buffer + 4);
+  __rcutils_format_two_digits(value % 100, buffer + 6);
+}
+
+size_t
+rcutils_format_uint64(uint64_t value, char * buffer)
+{
+  // The digits are written backwards from the end of a temporary buffer, in chunks of eight
+  // digits so that only two 64 bit divisions are needed at most.
+  char digits[RCUTILS_FORMAT_INT64_MAX_LENGTH + 4];
+  char * position = digits + sizeof(digits);
+  while (value >= 100000000) {
+    position -= 8;
+    __rcutils_format_eight_digits((uint32_t)(value % 100000000), position);
+    value /= 100000000;
+  }
+  uint32_t remainder = (uint32_t)value;
+  while (remainder >= 100) {
+    position -= 2;
+    __rcutils_format_two_digits(remainder % 100, position);
+    remainder /= 100;
+  }
+  if (remainder >= 10) {
+    position -= 2;
+    __rcutils_format_two_digits(remainder, position);
+  } else {
+    *--position = (char)('0' + remainder);
+  }
+  size_t length = (size_t)(digits + sizeof(digits) - position);
+  memcpy(buffer, position, length);
+  buffer[length] = '\0';
+  return length;
+}
+
+size_t
+rcutils_format_int64(int64_t value, char * buffer)
+{
+  if (value >= 0) {
+    return rcutils_format_uint64((uint64_t)value, buffer);
+  }
+  buffer[0] = '-';
+  // Negate in unsigned arithmetic, which is well defined for the smallest value as well.
+  return 1 + rcutils_format_uint64(0 - (uint64_t)value, buffer + 1);
+}
+
+void
+rcutils_format_uint64_fixed(uint64_t value, size_t width, char * buffer)
+{
+  char * position = buffer + width;
+  while (position - buffer >= 2) {
+    position -= 2;
+    __rcutils_format_two_digits((unsigned int)(value % 100), position);
+    value /= 100;
+  }
+  if (position != buffer) {
+    *buffer = (char)('0' + value % 10);
+  }
+}
+
+size_t
+rcutils_format_time_iso8601(int64_t nanoseconds, char * buffer)
+{
+  // Split into days, seconds of the day and nanoseconds, rounding towards negative infinity.
+  const int64_t nanoseconds_per_second = 1000 * 1000 * 1000;
+  const int64_t seconds_per_day = 24 * 60 * 60;
+  int64_t seconds = nanoseconds / nanoseconds_per_second;
+  int64_t subsecond = nanoseconds % nanoseconds_per_second;
+  if (subsecond < 0) {
+    subsecond += nanoseconds_per_second;
+    --seconds;
+  }
+  int64_t days = seconds / seconds_per_day;
+  int64_t second_of_day = seconds % seconds_per_day;
+  if (second_of_day < 0) {
+    second_of_day += seconds_per_day;
+    --days;
+  }
+
+  // Convert the days since the epoch into a date of the proleptic Gregorian calendar, using
+  // eras of 400 years which start on March 1st so that the leap day is the last day of a year.
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int64_t day_of_era = days - era * 146097;
+  const int64_t year_of_era =
+    (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  const int64_t day_of_year =
+    day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const int64_t shifted_month = (5 * day_of_year + 2) / 153;
+  const int64_t day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  const int64_t month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  const int64_t year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+  rcutils_format_uint64_fixed((uint64_t)year, 4, buffer);
+  buffer[4] = '-';
+  __rcutils_format_two_digits((unsigned int)month, buffer + 5);
+  buffer[7] = '-';
+  __rcutils_format_two_digits((unsigned int)day, buffer + 8);
+  buffer[10] = 'T';
+  __rcutils_format_two_digits((unsigned int)(second_of_day / 3600), buffer + 11);
+  buffer[13] = ':';
+  __rcutils_format_two_digits((unsigned int)(second_of_day / 60 % 60), buffer + 14);
+  buffer[16] = ':';
+  __rcutils_format_two_digits((unsigned int)(second_of_day % 60), buffer + 17);
+  buffer[19] = '.';
+  rcutils_format_uint64_fixed((uint64_t)subsecond, 9, buffer + 20);
+  buffer[29] = 'Z';
+  buffer[30] = '\0';
+  return RCUTILS_FORMAT_TIME_ISO8601_LENGTH;
+}
+
+#if __cplusplus
+}
+#endif
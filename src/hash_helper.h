@@ -0,0 +1,48 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HASH_HELPER_H_
+#define HASH_HELPER_H_
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Hash the given number of characters of a string using FNV-1a.
+static inline size_t
+rcutils_hash_string(const char * string, size_t length)
+{
+#if SIZE_MAX > 0xffffffff
+  size_t hash = (size_t)14695981039346656037ULL;
+  const size_t prime = (size_t)1099511628211ULL;
+#else
+  size_t hash = 2166136261U;
+  const size_t prime = 16777619U;
+#endif
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= (unsigned char)string[i];
+    hash *= prime;
+  }
+  return hash;
+}
+
+#if __cplusplus
+}
+#endif
+
+#endif  // HASH_HELPER_H_
@@ -17,20 +17,40 @@ extern "C"
 {
 #endif
 
+#include <limits.h>
 #include <stdint.h>
 #include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
+#include "./hash_helper.h"
+#include "./logging_levels.h"
+#include "./logging_output.h"
+#include "./stdatomic_helper.h"
+#include "./thread_helper.h"
 #include "rcutils/allocator.h"
 #include "rcutils/error_handling.h"
 #include "rcutils/find.h"
+#include "rcutils/format_number.h"
 #include "rcutils/format_string.h"
 #include "rcutils/get_env.h"
 #include "rcutils/logging.h"
-#include "rcutils/snprintf.h"
-#include "rcutils/types/string_map.h"
+#include "rcutils/logging_async.h"
+#include "rcutils/logging_binary.h"
+#include "rcutils/logging_file.h"
+#include "rcutils/logging_flight_recorder.h"
+#include "rcutils/macros.h"
+#include "rcutils/time.h"
 
 #define RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_LEN 2048
 
+// The cached level of a location meaning that the default level applies.
+// The default level itself isn't cached since it can be changed directly.
+#define RCUTILS_LOGGING_CACHED_DEFAULT_LEVEL UINT32_MAX
+
 const char * g_rcutils_log_severity_names[] = {
   [RCUTILS_LOG_SEVERITY_UNSET] = "UNSET",
   [RCUTILS_LOG_SEVERITY_DEBUG] = "DEBUG",
@@ -42,22 +62,401 @@ const char * g_rcutils_log_severity_names[] = {
 
 bool g_rcutils_logging_initialized = false;
 
+// The globals which are part of the API can't be declared atomic, so they are accessed with
+// atomic operations on their plain types instead, which are single loads on the hot path.
+// On Windows aligned volatile accesses are atomic, and loads have acquire semantics with the
+// default /volatile:ms of MSVC.
+
+static inline void __rcutils_logging_set_initialized(bool initialized)
+{
+#ifdef _WIN32
+  _InterlockedExchange8((volatile char *)&g_rcutils_logging_initialized, (char)initialized);
+#else
+  __atomic_store_n(&g_rcutils_logging_initialized, initialized, __ATOMIC_RELEASE);
+#endif  // _WIN32
+}
+
+// Serializes the initialization and the shutdown, so that threads which log for the first
+// time at the same time initialize the logging system only once.
+static rcutils_mutex_t g_rcutils_logging_initialization_mutex = RCUTILS_MUTEX_INITIALIZER;
+
 char g_rcutils_logging_output_format_string[RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_LEN];
 static const char * g_rcutils_logging_default_output_format = "[{severity}] [{name}]: {message}";
 
+/// The operations of the compiled output format.
+typedef enum rcutils_logging_output_format_op_type_t
+{
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LITERAL,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_SEVERITY,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_NAME,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_MESSAGE,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FUNCTION_NAME,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FILE_NAME,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LINE_NUMBER,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME_AS_NANOSECONDS,
+  RCUTILS_LOGGING_OUTPUT_FORMAT_OP_THREAD_ID,
+} rcutils_logging_output_format_op_type_t;
+
+typedef struct rcutils_logging_output_format_op_t
+{
+  rcutils_logging_output_format_op_type_t type;
+  // The span of the output format string to copy for literal operations.
+  const char * literal;
+  size_t literal_length;
+} rcutils_logging_output_format_op_t;
+
+// The output format string is compiled into operations at initialization.
+// Every token is preceded by a literal or directly follows another token, and the shortest
+// token takes 6 characters, so the format string can never result in more operations than this.
+#define RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_OPS (RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_LEN / 2)
+static rcutils_logging_output_format_op_t
+  g_rcutils_logging_output_format_ops[RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_OPS];
+static size_t g_rcutils_logging_output_format_ops_count = 0;
+
+/// A buffer which is reused by all log calls of a thread and only grows.
+typedef struct rcutils_logging_scratch_buffer_t
+{
+  char * data;
+  size_t capacity;
+  // The allocator of the data, which is kept since logging might be re-initialized meanwhile.
+  rcutils_allocator_t allocator;
+} rcutils_logging_scratch_buffer_t;
+
+typedef struct rcutils_logging_thread_scratch_buffers_t
+{
+  // The buffer used by the console output handler.
+  rcutils_logging_scratch_buffer_t output;
+  // The buffer handed out to custom output handlers.
+  rcutils_logging_scratch_buffer_t user;
+  // The buffer of a message which is formatted once for several sinks.
+  rcutils_logging_scratch_buffer_t message;
+  // Whether a message in the message buffer is being passed to the sinks.
+  bool dispatching;
+  // Whether the buffers are registered to be released at thread exit.
+  bool registered;
+} rcutils_logging_thread_scratch_buffers_t;
+
+// The smallest size a scratch buffer is allocated with, which fits most log messages.
+#define RCUTILS_LOGGING_MIN_SCRATCH_BUFFER_SIZE 1024
+static RCUTILS_THREAD_LOCAL rcutils_logging_thread_scratch_buffers_t
+  g_rcutils_logging_thread_scratch_buffers;
+static rcutils_thread_key_t g_rcutils_logging_thread_exit_key;
+static bool g_rcutils_logging_thread_exit_key_created = false;
+
+/// The parts of the time and thread id tokens which rarely change, rendered once per thread.
+typedef struct rcutils_logging_thread_token_cache_t
+{
+  // The seconds of the last expanded time, valid if their digits aren't empty.
+  int64_t seconds;
+  char seconds_digits[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  size_t seconds_digits_length;
+  // The id of the thread, rendered on first use.
+  char thread_id[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+} rcutils_logging_thread_token_cache_t;
+
+static RCUTILS_THREAD_LOCAL rcutils_logging_thread_token_cache_t
+  g_rcutils_logging_thread_token_cache;
+
 static rcutils_allocator_t g_rcutils_logging_allocator;
 
 rcutils_logging_output_handler_t g_rcutils_logging_output_handler = NULL;
-static rcutils_string_map_t g_rcutils_logging_severities_map;
+
+static inline rcutils_logging_output_handler_t __rcutils_logging_get_output_handler(void)
+{
+#ifdef _WIN32
+  return *(volatile rcutils_logging_output_handler_t *)&g_rcutils_logging_output_handler;
+#else
+  return __atomic_load_n(&g_rcutils_logging_output_handler, __ATOMIC_ACQUIRE);
+#endif  // _WIN32
+}
+
+static inline void __rcutils_logging_set_output_handler(rcutils_logging_output_handler_t function)
+{
+#ifdef _WIN32
+  InterlockedExchangePointer(
+    (PVOID volatile *)&g_rcutils_logging_output_handler, (PVOID)function);
+#else
+  __atomic_store_n(&g_rcutils_logging_output_handler, function, __ATOMIC_RELEASE);
+#endif  // _WIN32
+}
+
+/// The state of the epoch based reclamation of snapshots, which readers use without locking.
+/**
+ * Readers register in the counter of the parity of the current epoch, and writers
+ * advance the epoch after publishing a snapshot and wait for the counter of the
+ * previous epoch to drop to zero, after which no reader can use the old snapshot.
+ */
+typedef struct rcutils_logging_epoch_t
+{
+  atomic_uint_least64_t epoch;
+  atomic_uint_least64_t readers[2];
+} rcutils_logging_epoch_t;
+
+/// Start reading the current snapshot, which stays valid until the matching leave.
+/**
+ * This never blocks, but restarts if a writer advances the epoch concurrently.
+ *
+ * \param[out] epoch The epoch to pass to __rcutils_logging_epoch_leave().
+ */
+static void
+__rcutils_logging_epoch_enter(rcutils_logging_epoch_t * state, uint64_t * epoch)
+{
+  while (true) {
+    *epoch = atomic_load(&state->epoch);
+    atomic_fetch_add(&state->readers[*epoch & 1], 1);
+    // A writer which advanced the epoch in between might not wait for this reader.
+    if (atomic_load(&state->epoch) == *epoch) {
+      break;
+    }
+    atomic_fetch_sub(&state->readers[*epoch & 1], 1);
+  }
+}
+
+static void
+__rcutils_logging_epoch_leave(rcutils_logging_epoch_t * state, uint64_t epoch)
+{
+  atomic_fetch_sub_explicit(&state->readers[epoch & 1], 1, memory_order_release);
+}
+
+/// Wait until no reader can use the snapshot which has just been replaced.
+/**
+ * This must be called with the mutex of the writers locked.
+ */
+static void
+__rcutils_logging_epoch_synchronize(rcutils_logging_epoch_t * state)
+{
+  uint64_t epoch = atomic_fetch_add(&state->epoch, 1);
+  // Readers of the new epoch can only see the new snapshot.
+  while (atomic_load_explicit(&state->readers[epoch & 1], memory_order_acquire) != 0) {
+    rcutils_thread_yield();
+  }
+}
+
+/// An output handler which receives the messages of a severity or above.
+typedef struct rcutils_logging_sink_t
+{
+  rcutils_logging_output_handler_t output_handler;
+  int severity;
+} rcutils_logging_sink_t;
+
+/// A snapshot of the sinks, which is never modified once it has been published.
+typedef struct rcutils_logging_sinks_t
+{
+  size_t count;
+  rcutils_logging_sink_t sinks[RCUTILS_LOGGING_MAX_SINKS];
+} rcutils_logging_sinks_t;
+
+// The current snapshot of the sinks, NULL if there are none.
+static atomic_uintptr_t g_rcutils_logging_sinks = ATOMIC_VAR_INIT(0);
+// The lowest severity which any sink receives, above all severities if there are no sinks.
+static atomic_int g_rcutils_logging_sinks_min_severity = ATOMIC_VAR_INIT(INT_MAX);
+// Serializes the writers, which copy the current snapshot to replace it.
+static rcutils_mutex_t g_rcutils_logging_sinks_mutex = RCUTILS_MUTEX_INITIALIZER;
+static rcutils_logging_epoch_t g_rcutils_logging_sinks_epoch;
+
+static inline int __rcutils_logging_get_sinks_min_severity(void)
+{
+  return (int)atomic_load_explicit(&g_rcutils_logging_sinks_min_severity, memory_order_relaxed);
+}
+
+/// Whether neither the output handler nor any sink would receive a message of the severity.
+static inline bool __rcutils_logging_is_discarded(int severity)
+{
+  return NULL == __rcutils_logging_get_output_handler() &&
+         severity < __rcutils_logging_get_sinks_min_severity();
+}
+
+/// Copy the output handlers of the sinks which receive a severity, in the order they were added.
+/**
+ * The snapshot is only read while copying, so the sinks may add or remove sinks themselves.
+ *
+ * \return The number of output handlers which have been copied.
+ */
+static size_t
+__rcutils_logging_get_sinks(
+  int severity, rcutils_logging_output_handler_t output_handlers[RCUTILS_LOGGING_MAX_SINKS])
+{
+  if (severity < __rcutils_logging_get_sinks_min_severity()) {
+    return 0;
+  }
+  uint64_t epoch;
+  __rcutils_logging_epoch_enter(&g_rcutils_logging_sinks_epoch, &epoch);
+  const rcutils_logging_sinks_t * sinks =
+    (const rcutils_logging_sinks_t *)atomic_load(&g_rcutils_logging_sinks);
+  size_t count = 0;
+  for (size_t i = 0; sinks != NULL && i < sinks->count; ++i) {
+    if (severity >= sinks->sinks[i].severity) {
+      output_handlers[count++] = sinks->sinks[i].output_handler;
+    }
+  }
+  __rcutils_logging_epoch_leave(&g_rcutils_logging_sinks_epoch, epoch);
+  return count;
+}
+
+/// Publish a snapshot of the sinks and free the previous one once no reader uses it anymore.
+/**
+ * This must be called with the mutex of the writers locked.
+ *
+ * \param sinks The new snapshot, or NULL if there are no sinks anymore.
+ */
+static void
+__rcutils_logging_publish_sinks(rcutils_logging_sinks_t * sinks)
+{
+  int min_severity = INT_MAX;
+  for (size_t i = 0; sinks != NULL && i < sinks->count; ++i) {
+    if (sinks->sinks[i].severity < min_severity) {
+      min_severity = sinks->sinks[i].severity;
+    }
+  }
+  atomic_store(&g_rcutils_logging_sinks_min_severity, min_severity);
+  rcutils_logging_sinks_t * previous =
+    (rcutils_logging_sinks_t *)atomic_exchange(&g_rcutils_logging_sinks, (uintptr_t)sinks);
+  __rcutils_logging_epoch_synchronize(&g_rcutils_logging_sinks_epoch);
+  if (previous != NULL) {
+    g_rcutils_logging_allocator.deallocate(previous, g_rcutils_logging_allocator.state);
+  }
+}
+
+/// A snapshot of the levels of the loggers, which is never modified once it has been published.
+typedef struct rcutils_logging_levels_snapshot_t
+{
+  rcutils_logging_levels_t names;
+  // The levels of the logger name patterns, stored in the same kind of tree as the names.
+  rcutils_logging_levels_t patterns;
+} rcutils_logging_levels_snapshot_t;
+
+// The snapshot which is used before any level has been set, it doesn't need to be freed.
+static rcutils_logging_levels_snapshot_t g_rcutils_logging_levels_empty_snapshot;
+// The current snapshot, readers use it without locking while it's replaced by writers.
+static atomic_uintptr_t g_rcutils_logging_levels_snapshot = ATOMIC_VAR_INIT(0);
+// Serializes the writers, which copy the current snapshot to replace it.
+static rcutils_mutex_t g_rcutils_logging_levels_mutex = RCUTILS_MUTEX_INITIALIZER;
+// The snapshots which have been replaced are freed using epoch based reclamation.
+static rcutils_logging_epoch_t g_rcutils_logging_levels_epoch;
 
 // If this is false, attempts to use the severities map will be skipped.
-// This can happen if allocation of the map fails at initialization.
+// This is the case while the logging system isn't initialized.
 bool g_rcutils_logging_severities_map_valid = false;
 
+/// Start using the current snapshot, which stays valid until the matching leave.
+/**
+ * \param[out] epoch The epoch to pass to __rcutils_logging_levels_leave().
+ */
+static const rcutils_logging_levels_snapshot_t *
+__rcutils_logging_levels_enter(uint64_t * epoch)
+{
+  __rcutils_logging_epoch_enter(&g_rcutils_logging_levels_epoch, epoch);
+  return (const rcutils_logging_levels_snapshot_t *)atomic_load(
+    &g_rcutils_logging_levels_snapshot);
+}
+
+static void
+__rcutils_logging_levels_leave(uint64_t epoch)
+{
+  __rcutils_logging_epoch_leave(&g_rcutils_logging_levels_epoch, epoch);
+}
+
+/// Publish a snapshot and free the previous one once no reader uses it anymore.
+/**
+ * This must be called with the mutex of the writers locked.
+ *
+ * \param replaced The nodes of the previous snapshot which aren't part of the new one.
+ */
+static void
+__rcutils_logging_levels_publish(
+  rcutils_logging_levels_snapshot_t * snapshot, rcutils_logging_levels_node_t * replaced)
+{
+  rcutils_logging_levels_snapshot_t * previous =
+    (rcutils_logging_levels_snapshot_t *)atomic_exchange(
+    &g_rcutils_logging_levels_snapshot, (uintptr_t)snapshot);
+  __rcutils_logging_epoch_synchronize(&g_rcutils_logging_levels_epoch);
+  rcutils_logging_levels_free_replaced(replaced, g_rcutils_logging_allocator);
+  if (previous != &g_rcutils_logging_levels_empty_snapshot) {
+    g_rcutils_logging_allocator.deallocate(previous, g_rcutils_logging_allocator.state);
+  }
+}
+
 int g_rcutils_logging_default_logger_level = 0;
 
+static inline int __rcutils_logging_get_default_level(void)
+{
+#ifdef _WIN32
+  return *(volatile int *)&g_rcutils_logging_default_logger_level;
+#else
+  return __atomic_load_n(&g_rcutils_logging_default_logger_level, __ATOMIC_RELAXED);
+#endif  // _WIN32
+}
+
+static inline void __rcutils_logging_set_default_level(int level)
+{
+#ifdef _WIN32
+  InterlockedExchange((volatile LONG *)&g_rcutils_logging_default_logger_level, level);
+#else
+  __atomic_store_n(&g_rcutils_logging_default_logger_level, level, __ATOMIC_RELEASE);
+#endif  // _WIN32
+}
+
+// Incremented whenever logger levels change, invalidating the levels cached at the call sites.
+static atomic_uint_least64_t g_rcutils_logging_levels_generation = ATOMIC_VAR_INIT(1);
+
+static void __rcutils_logging_levels_changed(void)
+{
+  atomic_fetch_add_explicit(&g_rcutils_logging_levels_generation, 1, memory_order_release);
+}
+
+struct rcutils_logger_t
+{
+  // The level specified for the logger or its closest ancestor, which is tagged with the
+  // generation like the levels cached at the call sites, see __rcutils_logging_get_cached_level().
+  atomic_uint_least64_t cached_level;
+  // NULL if the name has no separator.
+  rcutils_logger_t * parent;
+  // The number of segments of the name, zero for the empty name.
+  size_t depth;
+  size_t hash;
+  char * name;
+  size_t name_length;
+};
+
+// The handles of the loggers in a hash table using open addressing and linear probing,
+// the number of entries is zero or a power of two.
+static rcutils_logger_t ** g_rcutils_logging_loggers = NULL;
+static size_t g_rcutils_logging_loggers_capacity = 0;
+static size_t g_rcutils_logging_loggers_size = 0;
+// Serializes the creation of the handles, which are never modified afterwards except for
+// their cached level.
+static rcutils_mutex_t g_rcutils_logging_loggers_mutex = RCUTILS_MUTEX_INITIALIZER;
+
+/// Free the handles of all loggers, which must not be used anymore.
+static void __rcutils_logging_free_loggers(void)
+{
+  rcutils_mutex_lock(&g_rcutils_logging_loggers_mutex);
+  for (size_t i = 0; i < g_rcutils_logging_loggers_capacity; ++i) {
+    rcutils_logger_t * logger = g_rcutils_logging_loggers[i];
+    if (logger) {
+      g_rcutils_logging_allocator.deallocate(logger->name, g_rcutils_logging_allocator.state);
+      g_rcutils_logging_allocator.deallocate(logger, g_rcutils_logging_allocator.state);
+    }
+  }
+  g_rcutils_logging_allocator.deallocate(
+    g_rcutils_logging_loggers, g_rcutils_logging_allocator.state);
+  g_rcutils_logging_loggers = NULL;
+  g_rcutils_logging_loggers_capacity = 0;
+  g_rcutils_logging_loggers_size = 0;
+  rcutils_mutex_unlock(&g_rcutils_logging_loggers_mutex);
+}
+
 bool g_force_stdout_line_buffered = false;
 bool g_stdout_flush_failure_reported = false;
+static bool g_rcutils_logging_console_output_writev = false;
+static bool g_rcutils_logging_write_failure_reported = false;
+
+#ifndef _WIN32
+// The number of pieces an output line is written with directly, output lines of formats with more
+// pieces are rendered into the scratch buffer first.
+#define RCUTILS_LOGGING_MAX_OUTPUT_IOVECS 32
+#endif
 
 
 rcutils_ret_t rcutils_logging_initialize(void)
@@ -83,7 +482,171 @@ rcutils_ret_t rcutils_logging_initialize(void)
   return rcutils_logging_initialize_with_allocator(rcutils_get_default_allocator());
 }
 
-rcutils_ret_t rcutils_logging_initialize_with_allocator(rcutils_allocator_t allocator)
+static void __rcutils_logging_release_scratch_buffer(rcutils_logging_scratch_buffer_t * buffer)
+{
+  if (buffer->data) {
+    buffer->allocator.deallocate(buffer->data, buffer->allocator.state);
+    buffer->data = NULL;
+    buffer->capacity = 0;
+  }
+}
+
+static void RCUTILS_THREAD_KEY_DESTRUCTOR_CALL
+__rcutils_logging_release_thread_scratch_buffers_at_exit(void * value)
+{
+  rcutils_logging_thread_scratch_buffers_t * buffers =
+    (rcutils_logging_thread_scratch_buffers_t *)value;
+  __rcutils_logging_release_scratch_buffer(&buffers->output);
+  __rcutils_logging_release_scratch_buffer(&buffers->user);
+  __rcutils_logging_release_scratch_buffer(&buffers->message);
+  buffers->registered = false;
+}
+
+/// Ensure that the scratch buffer has at least the given size, keeping its contents.
+/**
+ * \return true if successful, false if allocating memory failed.
+ */
+static bool __rcutils_logging_reserve_scratch_buffer(
+  rcutils_logging_scratch_buffer_t * buffer, size_t size)
+{
+  if (size <= buffer->capacity) {
+    return true;
+  }
+  size_t new_capacity = buffer->capacity;
+  if (new_capacity < RCUTILS_LOGGING_MIN_SCRATCH_BUFFER_SIZE) {
+    new_capacity = RCUTILS_LOGGING_MIN_SCRATCH_BUFFER_SIZE;
+  }
+  while (new_capacity < size) {
+    if (new_capacity > SIZE_MAX / 2) {
+      new_capacity = size;
+      break;
+    }
+    new_capacity *= 2;
+  }
+  char * new_data = NULL;
+  if (NULL == buffer->data) {
+    buffer->allocator = g_rcutils_logging_allocator;
+    new_data = buffer->allocator.allocate(new_capacity, buffer->allocator.state);
+  } else {
+    new_data = buffer->allocator.reallocate(
+      buffer->data, new_capacity, buffer->allocator.state);
+  }
+  if (NULL == new_data) {
+    return false;
+  }
+  buffer->data = new_data;
+  buffer->capacity = new_capacity;
+
+  rcutils_logging_thread_scratch_buffers_t * buffers = &g_rcutils_logging_thread_scratch_buffers;
+  if (!buffers->registered && g_rcutils_logging_thread_exit_key_created) {
+    // If this fails the buffers are only released at shutdown, if that happens on this thread.
+    buffers->registered =
+      rcutils_thread_key_set(g_rcutils_logging_thread_exit_key, buffers) == RCUTILS_RET_OK;
+  }
+  return true;
+}
+
+static void __rcutils_logging_add_output_format_literal(const char * literal, size_t length)
+{
+  if (g_rcutils_logging_output_format_ops_count > 0) {
+    rcutils_logging_output_format_op_t * previous_op =
+      &g_rcutils_logging_output_format_ops[g_rcutils_logging_output_format_ops_count - 1];
+    if (RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LITERAL == previous_op->type &&
+      previous_op->literal + previous_op->literal_length == literal)
+    {
+      // Extend the previous literal instead.
+      previous_op->literal_length += length;
+      return;
+    }
+  }
+  rcutils_logging_output_format_op_t * op =
+    &g_rcutils_logging_output_format_ops[g_rcutils_logging_output_format_ops_count++];
+  op->type = RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LITERAL;
+  op->literal = literal;
+  op->literal_length = length;
+}
+
+/// Compile the output format string into the operations used to render log messages.
+/**
+ * Tokens are the known token names enclosed in curly brackets, everything
+ * else is copied verbatim.
+ */
+static void __rcutils_logging_compile_output_format(void)
+{
+  static const struct
+  {
+    const char * name;
+    rcutils_logging_output_format_op_type_t type;
+  } tokens[] = {
+    {"severity", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_SEVERITY},
+    {"name", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_NAME},
+    {"message", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_MESSAGE},
+    {"function_name", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FUNCTION_NAME},
+    {"file_name", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FILE_NAME},
+    {"line_number", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LINE_NUMBER},
+    {"time", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME},
+    {"time_as_nanoseconds", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME_AS_NANOSECONDS},
+    {"thread_id", RCUTILS_LOGGING_OUTPUT_FORMAT_OP_THREAD_ID},
+  };
+  const char token_start_delimiter = '{';
+  const char token_end_delimiter = '}';
+  const char * str = g_rcutils_logging_output_format_string;
+  size_t size = strlen(g_rcutils_logging_output_format_string);
+  g_rcutils_logging_output_format_ops_count = 0;
+
+  size_t i = 0;
+  while (i < size) {
+    // Everything up to the next token start delimiter is a literal.
+    size_t chars_to_start_delim = rcutils_find(str + i, token_start_delimiter);
+    size_t remaining_chars = size - i;
+    if (chars_to_start_delim > 0) {
+      if (chars_to_start_delim > remaining_chars) {
+        // No start delimiters found; the rest of the format string is a literal.
+        chars_to_start_delim = remaining_chars;
+      }
+      __rcutils_logging_add_output_format_literal(str + i, chars_to_start_delim);
+      i += chars_to_start_delim;
+      if (i >= size) {
+        break;
+      }
+    }
+    // We are at a token start delimiter: determine if there's a known token or not.
+    size_t chars_to_end_delim = rcutils_find(str + i, token_end_delimiter);
+    remaining_chars = size - i;
+    if (chars_to_end_delim > remaining_chars) {
+      // No end delimiters found in the remainder of the format string;
+      // there won't be any more tokens so the rest is a literal.
+      __rcutils_logging_add_output_format_literal(str + i, remaining_chars);
+      break;
+    }
+    // Found what looks like a token; determine if it's recognized.
+    const char * token = str + i + 1;  // Skip the start delimiter.
+    size_t token_len = chars_to_end_delim - 1;  // Not including delimiters.
+    size_t j = 0;
+    for (; j < sizeof(tokens) / sizeof(tokens[0]); ++j) {
+      if (strlen(tokens[j].name) == token_len && memcmp(tokens[j].name, token, token_len) == 0) {
+        break;
+      }
+    }
+    if (j == sizeof(tokens) / sizeof(tokens[0])) {
+      // This wasn't a token; the start delimiter is a literal and the search continues as usual
+      // (the substring might contain more start delimiters).
+      __rcutils_logging_add_output_format_literal(str + i, 1);
+      i++;
+      continue;
+    }
+    rcutils_logging_output_format_op_t * op =
+      &g_rcutils_logging_output_format_ops[g_rcutils_logging_output_format_ops_count++];
+    op->type = tokens[j].type;
+    op->literal = NULL;
+    op->literal_length = 0;
+    // Skip ahead to avoid re-processing the token characters (including the 2 delimiters).
+    i += token_len + 2;
+  }
+}
+
+/// Initialize the logging system, with the initialization mutex locked.
+static rcutils_ret_t __rcutils_logging_initialize(rcutils_allocator_t allocator)
 {
   rcutils_ret_t ret = RCUTILS_RET_OK;
   if (!g_rcutils_logging_initialized) {
@@ -94,8 +657,15 @@ rcutils_ret_t rcutils_logging_initialize_with_allocator(rcutils_allocator_t allo
     }
     g_rcutils_logging_allocator = allocator;
 
-    g_rcutils_logging_output_handler = &rcutils_logging_console_output_handler;
-    g_rcutils_logging_default_logger_level = RCUTILS_LOG_SEVERITY_INFO;
+    __rcutils_logging_set_output_handler(&rcutils_logging_console_output_handler);
+
+    if (!g_rcutils_logging_thread_exit_key_created) {
+      // The key is never deleted, since other threads might still have scratch buffers.
+      g_rcutils_logging_thread_exit_key_created = rcutils_thread_key_create(
+        &g_rcutils_logging_thread_exit_key,
+        __rcutils_logging_release_thread_scratch_buffers_at_exit) == RCUTILS_RET_OK;
+    }
+    __rcutils_logging_set_default_level(RCUTILS_LOG_SEVERITY_INFO);
 
     // Check for the environment variable for custom output formatting
     const char * output_format;
@@ -118,73 +688,214 @@ rcutils_ret_t rcutils_logging_initialize_with_allocator(rcutils_allocator_t allo
       memcpy(g_rcutils_logging_output_format_string, g_rcutils_logging_default_output_format,
         strlen(g_rcutils_logging_default_output_format) + 1);
     }
+    __rcutils_logging_compile_output_format();
 
-    g_rcutils_logging_severities_map = rcutils_get_zero_initialized_string_map();
-    rcutils_ret_t string_map_ret = rcutils_string_map_init(
-      &g_rcutils_logging_severities_map, 0, g_rcutils_logging_allocator);
-    if (string_map_ret != RCUTILS_RET_OK) {
-      // If an error message was set it will have been overwritten by rcutils_string_map_init.
-      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-        g_rcutils_logging_allocator,
-        "Failed to initialize map for logger severities [%s]. Severities will not be configurable.",
-        rcutils_get_error_string_safe());
-      g_rcutils_logging_severities_map_valid = false;
-      ret = RCUTILS_RET_STRING_MAP_INVALID;
+    // Check for the environment variable to write to the file descriptors directly
+    const char * output_writev;
+    ret_str = rcutils_get_env("RCUTILS_CONSOLE_OUTPUT_WRITEV", &output_writev);
+    g_rcutils_logging_console_output_writev = false;
+    if (NULL == ret_str) {
+      if (strcmp(output_writev, "1") == 0) {
+        g_rcutils_logging_console_output_writev = true;
+      } else if (strcmp(output_writev, "0") != 0 && strcmp(output_writev, "") != 0) {
+        fprintf(stderr,
+          "Warning: unexpected value [%s] specified for RCUTILS_CONSOLE_OUTPUT_WRITEV. "
+          "Default value 0 will be used. Valid values are 1 or 0.\n",
+          output_writev);
+      }
     } else {
-      g_rcutils_logging_severities_map_valid = true;
+      fprintf(stderr, "Error getting env. variable "
+        "RCUTILS_CONSOLE_OUTPUT_WRITEV: %s\n", ret_str);
     }
 
-    g_rcutils_logging_initialized = true;
+    // The map only allocates memory once the first level is set.
+    rcutils_logging_levels_init(
+      &g_rcutils_logging_levels_empty_snapshot.names, g_rcutils_logging_allocator);
+    rcutils_logging_levels_init(
+      &g_rcutils_logging_levels_empty_snapshot.patterns, g_rcutils_logging_allocator);
+    atomic_store(
+      &g_rcutils_logging_levels_snapshot, (uintptr_t)&g_rcutils_logging_levels_empty_snapshot);
+    g_rcutils_logging_severities_map_valid = true;
+
+    __rcutils_logging_levels_changed();
+    // Publishes the initialized state to the threads which check it without the mutex.
+    __rcutils_logging_set_initialized(true);
   }
   return ret;
 }
 
-rcutils_ret_t rcutils_logging_shutdown(void)
+rcutils_ret_t rcutils_logging_initialize_with_allocator(rcutils_allocator_t allocator)
+{
+  if (RCUTILS_LOGGING_IS_INITIALIZED()) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_mutex_lock(&g_rcutils_logging_initialization_mutex);
+  rcutils_ret_t ret = __rcutils_logging_initialize(allocator);
+  rcutils_mutex_unlock(&g_rcutils_logging_initialization_mutex);
+  return ret;
+}
+
+/// Shut down the logging system, with the initialization mutex locked.
+static rcutils_ret_t __rcutils_logging_shutdown(void)
 {
   if (!g_rcutils_logging_initialized) {
     return RCUTILS_RET_OK;
   }
   rcutils_ret_t ret = RCUTILS_RET_OK;
+  // Write out the records which are still queued.
+  rcutils_ret_t async_ret = rcutils_logging_async_stop();
+  if (async_ret != RCUTILS_RET_OK) {
+    ret = async_ret;
+  }
+  rcutils_ret_t file_ret = rcutils_logging_file_close();
+  if (file_ret != RCUTILS_RET_OK) {
+    ret = file_ret;
+  }
+  rcutils_ret_t binary_ret = rcutils_logging_binary_close();
+  if (binary_ret != RCUTILS_RET_OK) {
+    ret = binary_ret;
+  }
+  rcutils_ret_t flight_recorder_ret = rcutils_logging_flight_recorder_stop();
+  if (flight_recorder_ret != RCUTILS_RET_OK) {
+    ret = flight_recorder_ret;
+  }
   if (g_rcutils_logging_severities_map_valid) {
-    rcutils_ret_t string_map_ret = rcutils_string_map_fini(&g_rcutils_logging_severities_map);
-    if (string_map_ret != RCUTILS_RET_OK) {
-      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-        g_rcutils_logging_allocator,
-        "Failed to finalize map for logger severities: %s",
-        rcutils_get_error_string_safe());
-      ret = RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID;
+    rcutils_mutex_lock(&g_rcutils_logging_levels_mutex);
+    rcutils_logging_levels_snapshot_t * snapshot =
+      (rcutils_logging_levels_snapshot_t *)atomic_exchange(
+      &g_rcutils_logging_levels_snapshot, (uintptr_t)&g_rcutils_logging_levels_empty_snapshot);
+    // Threads which are still checking a level may use the snapshot until they leave.
+    __rcutils_logging_epoch_synchronize(&g_rcutils_logging_levels_epoch);
+    rcutils_mutex_unlock(&g_rcutils_logging_levels_mutex);
+    if (snapshot != &g_rcutils_logging_levels_empty_snapshot) {
+      rcutils_logging_levels_fini(&snapshot->names);
+      rcutils_logging_levels_fini(&snapshot->patterns);
+      g_rcutils_logging_allocator.deallocate(snapshot, g_rcutils_logging_allocator.state);
     }
     g_rcutils_logging_severities_map_valid = false;
   }
-  g_rcutils_logging_initialized = false;
+  __rcutils_logging_free_loggers();
+  rcutils_mutex_lock(&g_rcutils_logging_sinks_mutex);
+  __rcutils_logging_publish_sinks(NULL);
+  rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+  // The scratch buffers of other threads are released when they exit.
+  rcutils_logging_release_thread_scratch_buffers();
+  __rcutils_logging_levels_changed();
+  __rcutils_logging_set_initialized(false);
+  return ret;
+}
+
+rcutils_ret_t rcutils_logging_shutdown(void)
+{
+  rcutils_mutex_lock(&g_rcutils_logging_initialization_mutex);
+  rcutils_ret_t ret = __rcutils_logging_shutdown();
+  rcutils_mutex_unlock(&g_rcutils_logging_initialization_mutex);
   return ret;
 }
 
 rcutils_logging_output_handler_t rcutils_logging_get_output_handler(void)
 {
   RCUTILS_LOGGING_AUTOINIT
-  return g_rcutils_logging_output_handler;
+  return __rcutils_logging_get_output_handler();
 }
 
 void rcutils_logging_set_output_handler(rcutils_logging_output_handler_t function)
 {
   // *INDENT-OFF* (prevent uncrustify from making unnecessary indents here)
   RCUTILS_LOGGING_AUTOINIT
-  g_rcutils_logging_output_handler = function;
+  __rcutils_logging_set_output_handler(function);
   // *INDENT-ON*
 }
 
+rcutils_ret_t rcutils_logging_add_sink(rcutils_logging_output_handler_t function, int severity)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (NULL == function) {
+    RCUTILS_SET_ERROR_MSG("Invalid output handler", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  rcutils_mutex_lock(&g_rcutils_logging_sinks_mutex);
+  const rcutils_logging_sinks_t * current =
+    (const rcutils_logging_sinks_t *)atomic_load(&g_rcutils_logging_sinks);
+  size_t count = current != NULL ? current->count : 0;
+  size_t i = 0;
+  while (i < count && current->sinks[i].output_handler != function) {
+    ++i;
+  }
+  if (RCUTILS_LOGGING_MAX_SINKS == i) {
+    rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+    RCUTILS_SET_ERROR_MSG("Too many logging sinks", g_rcutils_logging_allocator);
+    return RCUTILS_RET_ERROR;
+  }
+  rcutils_logging_sinks_t * sinks = g_rcutils_logging_allocator.allocate(
+    sizeof(rcutils_logging_sinks_t), g_rcutils_logging_allocator.state);
+  if (NULL == sinks) {
+    rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+    RCUTILS_SET_ERROR_MSG("Failed to allocate logging sinks", g_rcutils_logging_allocator);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  sinks->count = count;
+  if (count > 0) {
+    memcpy(sinks->sinks, current->sinks, count * sizeof(rcutils_logging_sink_t));
+  }
+  sinks->sinks[i].output_handler = function;
+  sinks->sinks[i].severity = severity;
+  if (i == count) {
+    ++sinks->count;
+  }
+  __rcutils_logging_publish_sinks(sinks);
+  rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t rcutils_logging_remove_sink(rcutils_logging_output_handler_t function)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  rcutils_mutex_lock(&g_rcutils_logging_sinks_mutex);
+  const rcutils_logging_sinks_t * current =
+    (const rcutils_logging_sinks_t *)atomic_load(&g_rcutils_logging_sinks);
+  size_t count = current != NULL ? current->count : 0;
+  size_t i = 0;
+  while (i < count && current->sinks[i].output_handler != function) {
+    ++i;
+  }
+  if (i == count) {
+    rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+    RCUTILS_SET_ERROR_MSG("Output handler is not a logging sink", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  rcutils_logging_sinks_t * sinks = NULL;
+  if (count > 1) {
+    sinks = g_rcutils_logging_allocator.allocate(
+      sizeof(rcutils_logging_sinks_t), g_rcutils_logging_allocator.state);
+    if (NULL == sinks) {
+      rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+      RCUTILS_SET_ERROR_MSG("Failed to allocate logging sinks", g_rcutils_logging_allocator);
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+    // Keep the order of the other sinks.
+    memcpy(sinks->sinks, current->sinks, i * sizeof(rcutils_logging_sink_t));
+    memcpy(
+      &sinks->sinks[i], &current->sinks[i + 1], (count - i - 1) * sizeof(rcutils_logging_sink_t));
+    sinks->count = count - 1;
+  }
+  __rcutils_logging_publish_sinks(sinks);
+  rcutils_mutex_unlock(&g_rcutils_logging_sinks_mutex);
+  return RCUTILS_RET_OK;
+}
+
 int rcutils_logging_get_default_logger_level(void)
 {
   RCUTILS_LOGGING_AUTOINIT
-  return g_rcutils_logging_default_logger_level;
+  return __rcutils_logging_get_default_level();
 }
 
 void rcutils_logging_set_default_logger_level(int level)
 {
   // *INDENT-OFF* (prevent uncrustify from making unnecessary indents here)
   RCUTILS_LOGGING_AUTOINIT
-  g_rcutils_logging_default_logger_level = level;
+  __rcutils_logging_set_default_level(level);
+  __rcutils_logging_levels_changed();
   // *INDENT-ON*
 }
 
@@ -204,41 +915,49 @@ int rcutils_logging_get_logger_leveln(const char * name, size_t name_length)
   // Skip the map lookup if the default was requested,
   // as it can still be used even if the severity map is invalid.
   if (0 == name_length) {
-    return g_rcutils_logging_default_logger_level;
+    return __rcutils_logging_get_default_level();
   }
   if (!g_rcutils_logging_severities_map_valid) {
     return RCUTILS_LOG_SEVERITY_UNSET;
   }
 
-  // TODO(dhood): replace string map with int map.
-  const char * severity_string = rcutils_string_map_getn(
-    &g_rcutils_logging_severities_map, name, name_length);
-  if (NULL == severity_string) {
-    if (rcutils_string_map_key_existsn(&g_rcutils_logging_severities_map, name, name_length)) {
-      // The level has been specified but couldn't be retrieved.
-      return -1;
-    }
-    return RCUTILS_LOG_SEVERITY_UNSET;
+  uint64_t epoch;
+  const rcutils_logging_levels_snapshot_t * snapshot = __rcutils_logging_levels_enter(&epoch);
+  int severity;
+  if (!rcutils_logging_levels_get(&snapshot->names, name, name_length, &severity)) {
+    severity = RCUTILS_LOG_SEVERITY_UNSET;
   }
+  __rcutils_logging_levels_leave(epoch);
+  return severity;
+}
 
-  // Determine the severity value matching the severity name.
-  int severity = -1;
-  for (size_t i = 0;
-    i < sizeof(g_rcutils_log_severity_names) / sizeof(g_rcutils_log_severity_names[0]);
-    ++i)
-  {
-    const char * severity_string_i = g_rcutils_log_severity_names[i];
-    if (severity_string_i && strcmp(severity_string_i, severity_string) == 0) {
-      severity = (enum RCUTILS_LOG_SEVERITY)i;
-      break;
-    }
+/// Get the level of the logger or its closest ancestor which has a level set.
+/**
+ * \return The level, or
+ * \return `RCUTILS_LOG_SEVERITY_UNSET` if the default level applies.
+ */
+static int __rcutils_logging_get_logger_specified_level(const char * name)
+{
+  if (!g_rcutils_logging_severities_map_valid) {
+    return RCUTILS_LOG_SEVERITY_UNSET;
   }
+  size_t name_length = strlen(name);
+  int severity = RCUTILS_LOG_SEVERITY_UNSET;
+  size_t depth = 0;
+  uint64_t epoch;
+  const rcutils_logging_levels_snapshot_t * snapshot = __rcutils_logging_levels_enter(&epoch);
+  rcutils_logging_levels_get_effective(&snapshot->names, name, name_length, &severity, &depth);
 
-  if (severity < 0) {
-    fprintf(
-      stderr,
-      "Logger has an invalid severity level: %s\n", severity_string);
-    return -1;
+  // A pattern only applies if it matches a deeper logger than the closest ancestor with a level.
+  int pattern_severity;
+  size_t pattern_depth;
+  rcutils_ret_t ret = rcutils_logging_levels_match(
+    &snapshot->patterns, name, name_length, &pattern_severity, &pattern_depth);
+  __rcutils_logging_levels_leave(epoch);
+  if (ret != RCUTILS_RET_OK) {
+    fprintf(stderr, "Error matching the level patterns for logger '%s'\n", name);
+  } else if (pattern_severity != RCUTILS_LOG_SEVERITY_UNSET && pattern_depth > depth) {
+    severity = pattern_severity;
   }
   return severity;
 }
@@ -249,43 +968,68 @@ int rcutils_logging_get_logger_effective_level(const char * name)
   if (NULL == name) {
     return -1;
   }
-  size_t substring_length = strlen(name);
-  while (true) {
-    int severity = rcutils_logging_get_logger_leveln(name, substring_length);
-    if (-1 == severity) {
-      fprintf(
-        stderr,
-        "Error getting effective level of logger '%s'\n", name);
-      return -1;
-    }
-    if (severity != RCUTILS_LOG_SEVERITY_UNSET) {
-      return severity;
-    }
-    // Determine the next ancestor's FQN by removing the child's name.
-    size_t index_last_separator = rcutils_find_lastn(
-      name, RCUTILS_LOGGING_SEPARATOR_CHAR, substring_length);
-    if (SIZE_MAX == index_last_separator) {
-      // There are no more separators in the substring.
-      // The name we just checked was the last that we needed to, and it was unset.
-      break;
-    }
-    // Shorten the substring to be the name of the ancestor (excluding the separator).
-    substring_length = index_last_separator;
+  int severity = __rcutils_logging_get_logger_specified_level(name);
+  if (RCUTILS_LOG_SEVERITY_UNSET == severity) {
+    // Neither the logger nor its ancestors have had their level specified.
+    return __rcutils_logging_get_default_level();
   }
-  // Neither the logger nor its ancestors have had their level specified.
-  return g_rcutils_logging_default_logger_level;
+  return severity;
 }
 
-rcutils_ret_t rcutils_logging_set_logger_level(const char * name, int level)
+/// Only the levels which have a name can be set.
+static bool __rcutils_logging_is_valid_level(int level)
+{
+  const int count =
+    (int)(sizeof(g_rcutils_log_severity_names) / sizeof(g_rcutils_log_severity_names[0]));
+  return level >= 0 && level < count && NULL != g_rcutils_log_severity_names[level];
+}
+
+/// Lock the mutex of the writers and copy the current snapshot to update it.
+/**
+ * The copy shares the trees with the current snapshot, setting levels in the
+ * copy replaces the nodes which are changed.
+ *
+ * \return The copy, or NULL if allocating memory failed.
+ */
+static rcutils_logging_levels_snapshot_t * __rcutils_logging_levels_begin_update(void)
+{
+  rcutils_logging_levels_snapshot_t * update = g_rcutils_logging_allocator.allocate(
+    sizeof(rcutils_logging_levels_snapshot_t), g_rcutils_logging_allocator.state);
+  if (NULL == update) {
+    RCUTILS_SET_ERROR_MSG(
+      "Failed to allocate memory for the logger levels", g_rcutils_logging_allocator);
+    return NULL;
+  }
+  rcutils_mutex_lock(&g_rcutils_logging_levels_mutex);
+  *update = *(const rcutils_logging_levels_snapshot_t *)atomic_load(
+    &g_rcutils_logging_levels_snapshot);
+  return update;
+}
+
+/// Publish an updated snapshot and unlock the mutex of the writers.
+static void __rcutils_logging_levels_end_update(
+  rcutils_logging_levels_snapshot_t * update, rcutils_logging_levels_node_t * replaced)
+{
+  __rcutils_logging_levels_publish(update, replaced);
+  rcutils_mutex_unlock(&g_rcutils_logging_levels_mutex);
+}
+
+/// Set the level of a logger without notifying the cached levels about the change.
+/**
+ * The level is set in the update, which is begun when the first level is set.
+ */
+static rcutils_ret_t __rcutils_logging_set_logger_level(
+  rcutils_logging_levels_snapshot_t ** update, rcutils_logging_levels_node_t ** replaced,
+  const char * name, int level)
 {
-  RCUTILS_LOGGING_AUTOINIT
   if (NULL == name) {
     RCUTILS_SET_ERROR_MSG(
       "Invalid logger name", g_rcutils_logging_allocator);
     return RCUTILS_RET_INVALID_ARGUMENT;
   }
-  if (strlen(name) == 0) {
-    g_rcutils_logging_default_logger_level = level;
+  size_t name_length = strlen(name);
+  if (name_length == 0) {
+    __rcutils_logging_set_default_level(level);
     return RCUTILS_RET_OK;
   }
   if (!g_rcutils_logging_severities_map_valid) {
@@ -294,38 +1038,151 @@ rcutils_ret_t rcutils_logging_set_logger_level(const char * name, int level)
     return RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID;
   }
 
-  // Convert the severity value into a string for storage.
-  // TODO(dhood): replace string map with int map.
-  if (level < 0 ||
-    level >=
-    (int)(sizeof(g_rcutils_log_severity_names) / sizeof(g_rcutils_log_severity_names[0])))
-  {
+  if (!__rcutils_logging_is_valid_level(level)) {
     RCUTILS_SET_ERROR_MSG(
       "Invalid severity level specified for logger", g_rcutils_logging_allocator);
     return RCUTILS_RET_INVALID_ARGUMENT;
   }
-  const char * severity_string = g_rcutils_log_severity_names[level];
-  if (NULL == severity_string) {
+  if (NULL == *update) {
+    *update = __rcutils_logging_levels_begin_update();
+    if (NULL == *update) {
+      return RCUTILS_RET_ERROR;
+    }
+  }
+  rcutils_ret_t levels_ret = rcutils_logging_levels_set(
+    &(*update)->names, name, name_length, level, &(*update)->names, replaced);
+  if (levels_ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      g_rcutils_logging_allocator,
+      "Error setting severity level for logger named '%s': failed to allocate memory",
+      name);
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t rcutils_logging_set_logger_level(const char * name, int level)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  return rcutils_logging_set_logger_levels(&name, &level, 1);
+}
+
+rcutils_ret_t rcutils_logging_set_logger_levels(
+  const char * const * names, const int * levels, size_t count)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (count > 0 && (NULL == names || NULL == levels)) {
+    RCUTILS_SET_ERROR_MSG(
+      "Invalid logger names or levels", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  rcutils_logging_levels_snapshot_t * update = NULL;
+  rcutils_logging_levels_node_t * replaced = NULL;
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  for (size_t i = 0; i < count && RCUTILS_RET_OK == ret; ++i) {
+    ret = __rcutils_logging_set_logger_level(&update, &replaced, names[i], levels[i]);
+  }
+  // Some levels might have been set even if an error occurred.
+  if (update) {
+    __rcutils_logging_levels_end_update(update, replaced);
+  }
+  __rcutils_logging_levels_changed();
+  return ret;
+}
+
+rcutils_ret_t rcutils_logging_set_logger_level_pattern(const char * pattern, int level)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (NULL == pattern || '\0' == pattern[0]) {
     RCUTILS_SET_ERROR_MSG(
-      "Unable to determine severity_string for severity", g_rcutils_logging_allocator);
+      "Invalid logger name pattern", g_rcutils_logging_allocator);
     return RCUTILS_RET_INVALID_ARGUMENT;
   }
-  rcutils_ret_t string_map_ret = rcutils_string_map_set(
-    &g_rcutils_logging_severities_map, name, severity_string);
-  if (string_map_ret != RCUTILS_RET_OK) {
+  if (!g_rcutils_logging_severities_map_valid) {
+    RCUTILS_SET_ERROR_MSG(
+      "Logger severity level map is invalid", g_rcutils_logging_allocator);
+    return RCUTILS_RET_LOGGING_SEVERITY_MAP_INVALID;
+  }
+  if (!__rcutils_logging_is_valid_level(level)) {
+    RCUTILS_SET_ERROR_MSG(
+      "Invalid severity level specified for logger name pattern", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  rcutils_logging_levels_snapshot_t * update = __rcutils_logging_levels_begin_update();
+  if (NULL == update) {
+    return RCUTILS_RET_ERROR;
+  }
+  rcutils_logging_levels_node_t * replaced = NULL;
+  rcutils_ret_t levels_ret = rcutils_logging_levels_set(
+    &update->patterns, pattern, strlen(pattern), level, &update->patterns, &replaced);
+  if (levels_ret != RCUTILS_RET_OK) {
+    rcutils_mutex_unlock(&g_rcutils_logging_levels_mutex);
+    g_rcutils_logging_allocator.deallocate(update, g_rcutils_logging_allocator.state);
     RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
       g_rcutils_logging_allocator,
-      "Error setting severity level for logger named '%s': %s",
-      name, rcutils_get_error_string_safe());
+      "Error setting severity level for logger name pattern '%s': failed to allocate memory",
+      pattern);
     return RCUTILS_RET_ERROR;
   }
+  __rcutils_logging_levels_end_update(update, replaced);
+  __rcutils_logging_levels_changed();
   return RCUTILS_RET_OK;
 }
 
-bool rcutils_logging_logger_is_enabled_for(const char * name, int severity)
+rcutils_ret_t rcutils_logging_get_thread_scratch_buffer(
+  size_t size, char ** buffer, size_t * buffer_size)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (NULL == buffer || NULL == buffer_size) {
+    RCUTILS_SET_ERROR_MSG(
+      "Invalid buffer or buffer size", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  rcutils_logging_scratch_buffer_t * scratch_buffer =
+    &g_rcutils_logging_thread_scratch_buffers.user;
+  if (!__rcutils_logging_reserve_scratch_buffer(scratch_buffer, size)) {
+    RCUTILS_SET_ERROR_MSG(
+      "Failed to allocate memory for the scratch buffer", g_rcutils_logging_allocator);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  *buffer = scratch_buffer->data;
+  *buffer_size = scratch_buffer->capacity;
+  return RCUTILS_RET_OK;
+}
+
+char * rcutils_logging_reserve_output_scratch_buffer(size_t size, size_t * capacity)
+{
+  rcutils_logging_scratch_buffer_t * scratch_buffer =
+    &g_rcutils_logging_thread_scratch_buffers.output;
+  if (!__rcutils_logging_reserve_scratch_buffer(scratch_buffer, size)) {
+    return NULL;
+  }
+  *capacity = scratch_buffer->capacity;
+  return scratch_buffer->data;
+}
+
+void rcutils_logging_release_thread_scratch_buffers(void)
+{
+  __rcutils_logging_release_scratch_buffer(&g_rcutils_logging_thread_scratch_buffers.output);
+  __rcutils_logging_release_scratch_buffer(&g_rcutils_logging_thread_scratch_buffers.user);
+  __rcutils_logging_release_scratch_buffer(&g_rcutils_logging_thread_scratch_buffers.message);
+}
+
+/// Whether the flight recorder records messages of the severity.
+static inline bool __rcutils_logging_is_recorded(int severity)
+{
+  return severity >= atomic_load_explicit(
+    &g_rcutils_logging_flight_recorder_severity, memory_order_relaxed);
+}
+
+/// Determine if a logger is enabled for a severity, without considering the flight recorder.
+static bool __rcutils_logging_logger_is_enabled_for(const char * name, int severity)
 {
   RCUTILS_LOGGING_AUTOINIT
-  int logger_level = g_rcutils_logging_default_logger_level;
+  if (__rcutils_logging_is_discarded(severity)) {
+    return false;
+  }
+  int logger_level = __rcutils_logging_get_default_level();
   if (name) {
     logger_level = rcutils_logging_get_logger_effective_level(name);
     if (-1 == logger_level) {
@@ -338,73 +1195,986 @@ bool rcutils_logging_logger_is_enabled_for(const char * name, int severity)
   return severity >= logger_level;
 }
 
+bool rcutils_logging_logger_is_enabled_for(const char * name, int severity)
+{
+  return __rcutils_logging_is_recorded(severity) ||
+         __rcutils_logging_logger_is_enabled_for(name, severity);
+}
+
+/// Identify a logger name by its contents, with its length in the upper 16 bits and a hash.
+static uint64_t __rcutils_logging_get_name_key(const char * name)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  size_t length = 0;
+  for (; name[length] != '\0'; ++length) {
+    hash ^= (unsigned char)name[length];
+    hash *= 1099511628211ULL;
+  }
+  uint64_t key = ((uint64_t)length << 48) | (hash & 0xffffffffffffULL);
+  // Zero marks a cache which isn't bound to a name yet.
+  return 0 == key ? 1 : key;
+}
+
+/// Get the level in the cache if it is still valid for the logger name.
+static bool __rcutils_logging_get_cached_level(
+  const rcutils_log_level_cache_t * cache, uint64_t name_key, uint64_t generation, int * level)
+{
+  uint64_t cached_name = atomic_load_explicit(
+    (atomic_uint_least64_t *)&cache->logger_name, memory_order_relaxed);
+  if (cached_name != name_key) {
+    return false;
+  }
+  // The upper half holds the generation, the lower half the level.
+  uint64_t cached_level = atomic_load_explicit(
+    (atomic_uint_least64_t *)&cache->logger_level, memory_order_relaxed);
+  if (0 == cached_level || (cached_level >> 32) != (generation & UINT32_MAX)) {
+    return false;
+  }
+  if (RCUTILS_LOGGING_CACHED_DEFAULT_LEVEL == (uint32_t)cached_level) {
+    *level = __rcutils_logging_get_default_level();
+  } else {
+    *level = (int)(uint32_t)cached_level;
+  }
+  return true;
+}
+
+/// Determine if a logger is enabled for a severity using the cache, see
+/// __rcutils_logging_logger_is_enabled_for().
+static bool __rcutils_logging_logger_is_enabled_for_cache(
+  rcutils_log_level_cache_t * cache, const char * name, int severity)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (NULL == cache || NULL == name) {
+    return __rcutils_logging_logger_is_enabled_for(name, severity);
+  }
+  if (__rcutils_logging_is_discarded(severity)) {
+    return false;
+  }
+  uint64_t generation = atomic_load_explicit(
+    &g_rcutils_logging_levels_generation, memory_order_acquire);
+  uint64_t name_key = __rcutils_logging_get_name_key(name);
+  int logger_level;
+  if (__rcutils_logging_get_cached_level(cache, name_key, generation, &logger_level)) {
+    return severity >= logger_level;
+  }
+
+  logger_level = __rcutils_logging_get_logger_specified_level(name);
+  // Bind the cache to the first logger name it is used with.
+  uint64_t cached_name = 0;
+  if (atomic_compare_exchange_strong(
+      (atomic_uint_least64_t *)&cache->logger_name, &cached_name, name_key) ||
+    cached_name == name_key)
+  {
+    uint32_t cached_level = RCUTILS_LOG_SEVERITY_UNSET == logger_level ?
+      RCUTILS_LOGGING_CACHED_DEFAULT_LEVEL : (uint32_t)logger_level;
+    atomic_store_explicit(
+      (atomic_uint_least64_t *)&cache->logger_level,
+      ((generation & UINT32_MAX) << 32) | cached_level, memory_order_relaxed);
+  }
+  if (RCUTILS_LOG_SEVERITY_UNSET == logger_level) {
+    logger_level = __rcutils_logging_get_default_level();
+  }
+  return severity >= logger_level;
+}
+
+bool rcutils_logging_logger_is_enabled_for_cache(
+  rcutils_log_level_cache_t * cache, const char * name, int severity)
+{
+  // The flight recorder receives the messages below the levels of their loggers as well.
+  return __rcutils_logging_is_recorded(severity) ||
+         __rcutils_logging_logger_is_enabled_for_cache(cache, name, severity);
+}
+
+/// Find the handle of a logger, or the unused entry where it would be added.
+static rcutils_logger_t ** __rcutils_logging_find_logger(
+  const char * name, size_t name_length, size_t hash)
+{
+  size_t mask = g_rcutils_logging_loggers_capacity - 1;
+  size_t index = hash & mask;
+  while (true) {
+    rcutils_logger_t ** entry = &g_rcutils_logging_loggers[index];
+    if (NULL == *entry ||
+      ((*entry)->hash == hash && (*entry)->name_length == name_length &&
+      memcmp((*entry)->name, name, name_length) == 0))
+    {
+      return entry;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+/// Make sure that one more handle can be added without exceeding a load factor of 0.5.
+static bool __rcutils_logging_reserve_logger(void)
+{
+  if ((g_rcutils_logging_loggers_size + 1) * 2 <= g_rcutils_logging_loggers_capacity) {
+    return true;
+  }
+  size_t capacity = g_rcutils_logging_loggers_capacity ?
+    g_rcutils_logging_loggers_capacity * 2 : 16;
+  if (capacity > SIZE_MAX / sizeof(rcutils_logger_t *)) {
+    return false;
+  }
+  rcutils_logger_t ** loggers = g_rcutils_logging_allocator.zero_allocate(
+    capacity, sizeof(rcutils_logger_t *), g_rcutils_logging_allocator.state);
+  if (NULL == loggers) {
+    return false;
+  }
+  rcutils_logger_t ** previous = g_rcutils_logging_loggers;
+  size_t previous_capacity = g_rcutils_logging_loggers_capacity;
+  g_rcutils_logging_loggers = loggers;
+  g_rcutils_logging_loggers_capacity = capacity;
+  for (size_t i = 0; i < previous_capacity; ++i) {
+    rcutils_logger_t * logger = previous[i];
+    if (logger) {
+      *__rcutils_logging_find_logger(logger->name, logger->name_length, logger->hash) = logger;
+    }
+  }
+  g_rcutils_logging_allocator.deallocate(previous, g_rcutils_logging_allocator.state);
+  return true;
+}
+
+/// Get the handle of a logger, creating it and the handles of its ancestors if necessary.
+/**
+ * This must be called with the mutex of the handles locked.
+ *
+ * \return The handle, or NULL if allocating memory failed.
+ */
+static rcutils_logger_t * __rcutils_logging_intern_logger(const char * name, size_t name_length)
+{
+  size_t hash = rcutils_hash_string(name, name_length);
+  if (g_rcutils_logging_loggers_size > 0) {
+    rcutils_logger_t * logger = *__rcutils_logging_find_logger(name, name_length, hash);
+    if (logger) {
+      return logger;
+    }
+  }
+
+  rcutils_logger_t * parent = NULL;
+  size_t parent_length = name_length;
+  while (parent_length > 0 && name[parent_length - 1] != RCUTILS_LOGGING_SEPARATOR_CHAR) {
+    --parent_length;
+  }
+  if (parent_length > 0) {
+    // The parent is interned first, since adding it might resize the table.
+    parent = __rcutils_logging_intern_logger(name, parent_length - 1);
+    if (NULL == parent) {
+      return NULL;
+    }
+  }
+  if (!__rcutils_logging_reserve_logger()) {
+    return NULL;
+  }
+  rcutils_allocator_t allocator = g_rcutils_logging_allocator;
+  rcutils_logger_t * logger = allocator.zero_allocate(1, sizeof(rcutils_logger_t), allocator.state);
+  if (NULL == logger) {
+    return NULL;
+  }
+  logger->name = allocator.allocate(name_length + 1, allocator.state);
+  if (NULL == logger->name) {
+    allocator.deallocate(logger, allocator.state);
+    return NULL;
+  }
+  memcpy(logger->name, name, name_length);
+  logger->name[name_length] = '\0';
+  logger->name_length = name_length;
+  logger->hash = hash;
+  logger->parent = parent;
+  // The empty name of the parent of e.g. `.x` is a segment, but has no segments on its own.
+  logger->depth = parent ? (parent->name_length > 0 ? parent->depth : 1) + 1 :
+    (name_length > 0 ? 1 : 0);
+  atomic_init(&logger->cached_level, 0);
+  *__rcutils_logging_find_logger(name, name_length, hash) = logger;
+  ++g_rcutils_logging_loggers_size;
+  return logger;
+}
+
+rcutils_logger_t * rcutils_logging_get_logger(const char * name)
+{
+  RCUTILS_LOGGING_AUTOINIT
+  if (NULL == name) {
+    RCUTILS_SET_ERROR_MSG(
+      "Invalid logger name", g_rcutils_logging_allocator);
+    return NULL;
+  }
+  rcutils_mutex_lock(&g_rcutils_logging_loggers_mutex);
+  rcutils_logger_t * logger = __rcutils_logging_intern_logger(name, strlen(name));
+  rcutils_mutex_unlock(&g_rcutils_logging_loggers_mutex);
+  if (NULL == logger) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      g_rcutils_logging_allocator,
+      "Error creating the handle of logger named '%s': failed to allocate memory", name);
+  }
+  return logger;
+}
+
+const char * rcutils_logger_get_name(const rcutils_logger_t * logger)
+{
+  return logger ? logger->name : NULL;
+}
+
+rcutils_logger_t * rcutils_logger_get_parent(const rcutils_logger_t * logger)
+{
+  return logger ? logger->parent : NULL;
+}
+
+/// Get the level specified for a logger or its closest ancestor, using the levels cached in
+/// the handles, see __rcutils_logging_get_logger_specified_level().
+static int __rcutils_logging_get_logger_handle_specified_level(
+  rcutils_logger_t * logger, uint64_t generation)
+{
+  uint64_t cached_level = atomic_load_explicit(&logger->cached_level, memory_order_relaxed);
+  if (cached_level != 0 && (cached_level >> 32) == (generation & UINT32_MAX)) {
+    return RCUTILS_LOGGING_CACHED_DEFAULT_LEVEL == (uint32_t)cached_level ?
+           RCUTILS_LOG_SEVERITY_UNSET : (int)(uint32_t)cached_level;
+  }
+
+  int level = RCUTILS_LOG_SEVERITY_UNSET;
+  if (logger->depth > 0 && g_rcutils_logging_severities_map_valid) {
+    uint64_t epoch;
+    const rcutils_logging_levels_snapshot_t * snapshot = __rcutils_logging_levels_enter(&epoch);
+    // A pattern only applies if no level is set for the name which it matches.
+    if (!rcutils_logging_levels_get(
+        &snapshot->names, logger->name, logger->name_length, &level))
+    {
+      int pattern_level;
+      size_t pattern_depth;
+      rcutils_ret_t ret = rcutils_logging_levels_match(
+        &snapshot->patterns, logger->name, logger->name_length, &pattern_level, &pattern_depth);
+      if (ret != RCUTILS_RET_OK) {
+        fprintf(stderr, "Error matching the level patterns for logger '%s'\n", logger->name);
+      } else if (pattern_level != RCUTILS_LOG_SEVERITY_UNSET && pattern_depth == logger->depth) {
+        // Patterns matching only an ancestor are taken into account by the ancestor.
+        level = pattern_level;
+      }
+    }
+    __rcutils_logging_levels_leave(epoch);
+  }
+  if (RCUTILS_LOG_SEVERITY_UNSET == level && logger->parent) {
+    level = __rcutils_logging_get_logger_handle_specified_level(logger->parent, generation);
+  }
+
+  uint32_t level_to_cache = RCUTILS_LOG_SEVERITY_UNSET == level ?
+    RCUTILS_LOGGING_CACHED_DEFAULT_LEVEL : (uint32_t)level;
+  atomic_store_explicit(
+    &logger->cached_level, ((generation & UINT32_MAX) << 32) | level_to_cache,
+    memory_order_relaxed);
+  return level;
+}
+
+static inline int __rcutils_logging_get_logger_handle_effective_level(rcutils_logger_t * logger)
+{
+  int level = __rcutils_logging_get_logger_handle_specified_level(
+    logger, atomic_load_explicit(&g_rcutils_logging_levels_generation, memory_order_acquire));
+  if (RCUTILS_LOG_SEVERITY_UNSET == level) {
+    // Neither the logger nor its ancestors have had their level specified.
+    return __rcutils_logging_get_default_level();
+  }
+  return level;
+}
+
+int rcutils_logger_get_effective_level(rcutils_logger_t * logger)
+{
+  if (NULL == logger) {
+    return -1;
+  }
+  return __rcutils_logging_get_logger_handle_effective_level(logger);
+}
+
+/// Determine if a logger is enabled for a severity, without considering the flight recorder.
+static bool __rcutils_logging_logger_handle_is_enabled_for(
+  rcutils_logger_t * logger, int severity)
+{
+  if (NULL == logger) {
+    fprintf(stderr, "Error determining if logger is enabled for severity '%d'\n", severity);
+    return false;
+  }
+  if (__rcutils_logging_is_discarded(severity)) {
+    return false;
+  }
+  return severity >= __rcutils_logging_get_logger_handle_effective_level(logger);
+}
+
+bool rcutils_logger_is_enabled_for(rcutils_logger_t * logger, int severity)
+{
+  return __rcutils_logging_is_recorded(severity) ||
+         __rcutils_logging_logger_handle_is_enabled_for(logger, severity);
+}
+
+// The process wide log volume budget, see rcutils_logging_set_volume_budget().
+static atomic_bool g_rcutils_logging_volume_budget_enabled = ATOMIC_VAR_INIT(false);
+static atomic_uint_least64_t g_rcutils_logging_volume_lines_per_second = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t g_rcutils_logging_volume_bytes_per_second = ATOMIC_VAR_INIT(0);
+// The volume is measured in windows of one second, identified by the steady time in seconds.
+static atomic_int_least64_t g_rcutils_logging_volume_window = ATOMIC_VAR_INIT(0);
+static atomic_int_least64_t g_rcutils_logging_volume_raised_window = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t g_rcutils_logging_volume_lines = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t g_rcutils_logging_volume_bytes = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t g_rcutils_logging_volume_shed_lines = ATOMIC_VAR_INIT(0);
+// Messages with a severity below this one are shed, it is at most WARN.
+static atomic_int g_rcutils_logging_volume_shed_severity =
+  ATOMIC_VAR_INIT(RCUTILS_LOG_SEVERITY_DEBUG);
+static atomic_uint_least64_t g_rcutils_logging_volume_shed_debug_count = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t g_rcutils_logging_volume_shed_info_count = ATOMIC_VAR_INIT(0);
+
+void rcutils_logging_set_volume_budget(uint64_t lines_per_second, uint64_t bytes_per_second)
+{
+  atomic_store(&g_rcutils_logging_volume_budget_enabled, false);
+  atomic_store(&g_rcutils_logging_volume_lines_per_second, lines_per_second);
+  atomic_store(&g_rcutils_logging_volume_bytes_per_second, bytes_per_second);
+  atomic_store(&g_rcutils_logging_volume_window, 0);
+  atomic_store(&g_rcutils_logging_volume_raised_window, 0);
+  atomic_store(&g_rcutils_logging_volume_lines, 0);
+  atomic_store(&g_rcutils_logging_volume_bytes, 0);
+  atomic_store(&g_rcutils_logging_volume_shed_lines, 0);
+  atomic_store(&g_rcutils_logging_volume_shed_severity, RCUTILS_LOG_SEVERITY_DEBUG);
+  atomic_store(&g_rcutils_logging_volume_shed_debug_count, 0);
+  atomic_store(&g_rcutils_logging_volume_shed_info_count, 0);
+  atomic_store(
+    &g_rcutils_logging_volume_budget_enabled, lines_per_second > 0 || bytes_per_second > 0);
+}
+
+rcutils_ret_t rcutils_logging_get_volume_statistics(
+  rcutils_logging_volume_statistics_t * statistics)
+{
+  if (NULL == statistics) {
+    RCUTILS_SET_ERROR_MSG("statistics argument is null", g_rcutils_logging_allocator);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  statistics->shed_severity = (int)atomic_load(&g_rcutils_logging_volume_shed_severity);
+  statistics->shed_debug_count = atomic_load(&g_rcutils_logging_volume_shed_debug_count);
+  statistics->shed_info_count = atomic_load(&g_rcutils_logging_volume_shed_info_count);
+  return RCUTILS_RET_OK;
+}
+
+void rcutils_logging_add_output_volume(size_t bytes)
+{
+  if (atomic_load_explicit(&g_rcutils_logging_volume_budget_enabled, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&g_rcutils_logging_volume_bytes, bytes, memory_order_relaxed);
+  }
+}
+
+static bool __rcutils_logging_volume_exceeds_budget(uint64_t lines, uint64_t bytes)
+{
+  uint64_t lines_per_second = atomic_load_explicit(
+    &g_rcutils_logging_volume_lines_per_second, memory_order_relaxed);
+  uint64_t bytes_per_second = atomic_load_explicit(
+    &g_rcutils_logging_volume_bytes_per_second, memory_order_relaxed);
+  return (lines_per_second > 0 && lines > lines_per_second) ||
+         (bytes_per_second > 0 && bytes > bytes_per_second);
+}
+
+static void __rcutils_logging_close_volume_window(bool consecutive)
+{
+  uint64_t lines = atomic_exchange(&g_rcutils_logging_volume_lines, 0);
+  uint64_t bytes = atomic_exchange(&g_rcutils_logging_volume_bytes, 0);
+  uint64_t shed_lines = atomic_exchange(&g_rcutils_logging_volume_shed_lines, 0);
+  int shed_severity = (int)atomic_load(&g_rcutils_logging_volume_shed_severity);
+  if (RCUTILS_LOG_SEVERITY_DEBUG == shed_severity) {
+    return;
+  }
+  // Estimate the volume without shedding from the average size of the lines which were output.
+  uint64_t shed_bytes = lines > 0 ? shed_lines * (bytes / lines) : 0;
+  if (!consecutive || !__rcutils_logging_volume_exceeds_budget(
+      lines + shed_lines, bytes + shed_bytes))
+  {
+    // The load has subsided, lower the threshold one step or entirely after an idle window.
+    atomic_store(
+      &g_rcutils_logging_volume_shed_severity,
+      consecutive && RCUTILS_LOG_SEVERITY_WARN == shed_severity ?
+      RCUTILS_LOG_SEVERITY_INFO : RCUTILS_LOG_SEVERITY_DEBUG);
+  }
+  if (shed_lines > 0) {
+    rcutils_log_unchecked(
+      NULL, RCUTILS_LOG_SEVERITY_WARN, "rcutils",
+      "%llu messages with a severity below %s were dropped by the log volume budget",
+      (unsigned long long)shed_lines,
+      g_rcutils_log_severity_names[shed_severity]);
+  }
+}
+
+/// Account a message against the log volume budget, return false if it is shed.
+static bool __rcutils_logging_admit_volume(int severity)
+{
+  if (!atomic_load_explicit(&g_rcutils_logging_volume_budget_enabled, memory_order_relaxed)) {
+    return true;
+  }
+  rcutils_time_point_value_t now;
+  if (rcutils_steady_time_now(&now) != RCUTILS_RET_OK) {
+    return true;
+  }
+  int64_t window = now / RCUTILS_S_TO_NS(1);
+  int64_t previous_window = atomic_load_explicit(
+    &g_rcutils_logging_volume_window, memory_order_relaxed);
+  if (window != previous_window && atomic_compare_exchange_strong(
+      &g_rcutils_logging_volume_window, &previous_window, window))
+  {
+    __rcutils_logging_close_volume_window(window == previous_window + 1);
+  }
+
+  int shed_severity = (int)atomic_load_explicit(
+    &g_rcutils_logging_volume_shed_severity, memory_order_relaxed);
+  if (severity < shed_severity) {
+    atomic_fetch_add_explicit(&g_rcutils_logging_volume_shed_lines, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(
+      severity < RCUTILS_LOG_SEVERITY_INFO ?
+      &g_rcutils_logging_volume_shed_debug_count : &g_rcutils_logging_volume_shed_info_count,
+      1, memory_order_relaxed);
+    return false;
+  }
+  uint64_t lines = atomic_fetch_add_explicit(
+    &g_rcutils_logging_volume_lines, 1, memory_order_relaxed) + 1;
+  uint64_t bytes = atomic_load_explicit(&g_rcutils_logging_volume_bytes, memory_order_relaxed);
+  if (shed_severity < RCUTILS_LOG_SEVERITY_WARN &&
+    __rcutils_logging_volume_exceeds_budget(lines, bytes))
+  {
+    // Raise the threshold one step, at most once per window to see the effect.
+    int64_t raised_window = atomic_load(&g_rcutils_logging_volume_raised_window);
+    if (raised_window != window && atomic_compare_exchange_strong(
+        &g_rcutils_logging_volume_raised_window, &raised_window, window))
+    {
+      atomic_store(
+        &g_rcutils_logging_volume_shed_severity,
+        RCUTILS_LOG_SEVERITY_DEBUG == shed_severity ?
+        RCUTILS_LOG_SEVERITY_INFO : RCUTILS_LOG_SEVERITY_WARN);
+    }
+  }
+  return true;
+}
+
+/// Call an output handler with the arguments following the format.
+static void __rcutils_logging_call_output_handler(
+  rcutils_logging_output_handler_t output_handler, const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  (*output_handler)(location, severity, name, format, &args);
+  va_end(args);
+}
+
+/// Pass a message to the output handler and the sinks which receive its severity.
+/**
+ * If more than one of them receives the message, it is formatted once into a
+ * scratch buffer of the thread which is passed to all of them.
+ */
+static void __rcutils_logging_dispatch(
+  const rcutils_log_location_t * location, int severity, const char * name,
+  const char * format, va_list * args)
+{
+  rcutils_logging_output_handler_t output_handler = __rcutils_logging_get_output_handler();
+  rcutils_logging_output_handler_t receiver = output_handler;
+  rcutils_logging_output_handler_t sinks[RCUTILS_LOGGING_MAX_SINKS];
+  size_t sinks_count = __rcutils_logging_get_sinks(severity, sinks);
+  size_t receivers = (output_handler != NULL ? 1 : 0) + sinks_count;
+  if (sinks_count > 0) {
+    receiver = sinks[sinks_count - 1];
+  }
+  if (receivers <= 1) {
+    if (receiver != NULL) {
+      (*receiver)(location, severity, name, format, args);
+    }
+    return;
+  }
+
+  // The message buffer is in use if a receiver logs itself, then every receiver formats.
+  rcutils_logging_thread_scratch_buffers_t * buffers = &g_rcutils_logging_thread_scratch_buffers;
+  rcutils_logging_scratch_buffer_t * message = &buffers->message;
+  int length = -1;
+  if (!buffers->dispatching && __rcutils_logging_reserve_scratch_buffer(message, 1)) {
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    length = vsnprintf(message->data, message->capacity, format, args_clone);
+    va_end(args_clone);
+    if (length >= 0 && (size_t)length >= message->capacity) {
+      if (__rcutils_logging_reserve_scratch_buffer(message, (size_t)length + 1)) {
+        va_copy(args_clone, *args);
+        length = vsnprintf(message->data, message->capacity, format, args_clone);
+        va_end(args_clone);
+      } else {
+        length = -1;
+      }
+    }
+  }
+
+  if (length >= 0) {
+    buffers->dispatching = true;
+    if (output_handler != NULL) {
+      __rcutils_logging_call_output_handler(
+        output_handler, location, severity, name, "%s", message->data);
+    }
+    for (size_t i = 0; i < sinks_count; ++i) {
+      __rcutils_logging_call_output_handler(
+        sinks[i], location, severity, name, "%s", message->data);
+    }
+    buffers->dispatching = false;
+    return;
+  }
+  if (output_handler != NULL) {
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    (*output_handler)(location, severity, name, format, &args_clone);
+    va_end(args_clone);
+  }
+  for (size_t i = 0; i < sinks_count; ++i) {
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    (*sinks[i])(location, severity, name, format, &args_clone);
+    va_end(args_clone);
+  }
+}
+
 void rcutils_log(
   const rcutils_log_location_t * location,
   int severity, const char * name, const char * format, ...)
 {
-  if (!rcutils_logging_logger_is_enabled_for(name, severity)) {
+  va_list args;
+  if (__rcutils_logging_is_recorded(severity)) {
+    va_start(args, format);
+    rcutils_logging_flight_recorder_capture(location, severity, name ? name : "", format, &args);
+    va_end(args);
+  }
+  if (!__rcutils_logging_logger_is_enabled_for(name, severity)) {
     return;
   }
-  rcutils_logging_output_handler_t output_handler = g_rcutils_logging_output_handler;
-  if (output_handler != NULL) {
-    va_list args;
+  if (!__rcutils_logging_admit_volume(severity)) {
+    return;
+  }
+  va_start(args, format);
+  __rcutils_logging_dispatch(location, severity, name ? name : "", format, &args);
+  va_end(args);
+}
+
+bool rcutils_logging_condition_once(uint64_t * once)
+{
+  atomic_uint_least64_t * state = (atomic_uint_least64_t *)once;
+  // Avoid the read-modify-write on the shared cache line once the condition has passed.
+  if (atomic_load_explicit(state, memory_order_relaxed) != 0) {
+    return false;
+  }
+  uint64_t expected = 0;
+  return atomic_compare_exchange_strong(state, &expected, 1);
+}
+
+bool rcutils_logging_condition_throttle(
+  rcutils_time_point_value_t * last_logged, rcutils_duration_value_t duration,
+  rcutils_time_point_value_t now)
+{
+  atomic_int_least64_t * state = (atomic_int_least64_t *)last_logged;
+  int64_t last = atomic_load_explicit(state, memory_order_relaxed);
+  // Zero means that nothing has been logged yet, even if the time is less than the duration.
+  if (last != 0 && now < last + duration) {
+    return false;
+  }
+  // Only the thread which replaces the time it has seen passes, the others see the new time.
+  return atomic_compare_exchange_strong(state, &last, now);
+}
+
+bool rcutils_logging_condition_rate_limit(
+  rcutils_logging_rate_limit_t * rate_limit, uint64_t burst, rcutils_duration_value_t period,
+  rcutils_time_point_value_t now, uint64_t * suppressed)
+{
+  atomic_int_least64_t * full_time = (atomic_int_least64_t *)&rate_limit->full_time;
+  atomic_uint_least64_t * suppressed_count = (atomic_uint_least64_t *)&rate_limit->suppressed;
+  if (period < 0) {
+    period = 0;
+  }
+  // A message passes as long as the bucket is full again at most this long after now.
+  int64_t tolerance = 0;
+  if (burst > 1 && period > 0) {
+    tolerance = burst - 1 > (uint64_t)(INT64_MAX / period) ?
+      INT64_MAX : (int64_t)(burst - 1) * period;
+  }
+  int64_t expected = atomic_load_explicit(full_time, memory_order_relaxed);
+  int64_t desired;
+  do {
+    if (expected > now && expected - now > tolerance) {
+      atomic_fetch_add_explicit(suppressed_count, 1, memory_order_relaxed);
+      return false;
+    }
+    desired = (expected > now ? expected : now) + period;
+  } while (!atomic_compare_exchange_weak(full_time, &expected, desired));
+  *suppressed = atomic_exchange(suppressed_count, 0);
+  return true;
+}
+
+void rcutils_log_unchecked(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, ...)
+{
+  va_list args;
+  if (__rcutils_logging_is_recorded(severity)) {
+    va_start(args, format);
+    rcutils_logging_flight_recorder_capture(location, severity, name ? name : "", format, &args);
+    va_end(args);
+    // The level hasn't been checked if the message was only enabled for the flight recorder.
+    if (!__rcutils_logging_logger_is_enabled_for(name, severity)) {
+      return;
+    }
+  }
+  if (!__rcutils_logging_admit_volume(severity)) {
+    return;
+  }
+  va_start(args, format);
+  __rcutils_logging_dispatch(location, severity, name ? name : "", format, &args);
+  va_end(args);
+}
+
+void rcutils_log_logger_unchecked(
+  const rcutils_log_location_t * location,
+  int severity, rcutils_logger_t * logger, const char * format, ...)
+{
+  if (NULL == logger) {
+    return;
+  }
+  va_list args;
+  if (__rcutils_logging_is_recorded(severity)) {
     va_start(args, format);
-    (*output_handler)(location, severity, name ? name : "", format, &args);
+    rcutils_logging_flight_recorder_capture(location, severity, logger->name, format, &args);
     va_end(args);
+    // The level hasn't been checked if the message was only enabled for the flight recorder.
+    if (!__rcutils_logging_logger_handle_is_enabled_for(logger, severity)) {
+      return;
+    }
+  }
+  if (!__rcutils_logging_admit_volume(severity)) {
+    return;
   }
+  va_start(args, format);
+  __rcutils_logging_dispatch(location, severity, logger->name, format, &args);
+  va_end(args);
 }
 
-/// Ensure that the logging buffer is large enough.
+/// An output line which is written into a scratch buffer.
+typedef struct rcutils_logging_output_buffer_t
+{
+  rcutils_logging_scratch_buffer_t * storage;
+  // The number of characters written, not including the null terminator.
+  size_t length;
+} rcutils_logging_output_buffer_t;
+
+/// Ensure that the output buffer has space for n additional characters and a null terminator.
+/**
+ * \return true if successful, false if allocating memory failed.
+ */
+static bool __rcutils_logging_ensure_large_enough_buffer(
+  rcutils_logging_output_buffer_t * buffer, size_t n)
+{
+  if (n > SIZE_MAX - buffer->length - 1 ||
+    !__rcutils_logging_reserve_scratch_buffer(buffer->storage, buffer->length + n + 1))
+  {
+    fprintf(stderr, "failed to allocate buffer for logging output\n");
+    return false;
+  }
+  return true;
+}
+
+/// Append n characters to the output buffer, keeping it null terminated.
+static bool __rcutils_logging_append(
+  rcutils_logging_output_buffer_t * buffer, const char * str, size_t n)
+{
+  if (!__rcutils_logging_ensure_large_enough_buffer(buffer, n)) {
+    return false;
+  }
+  memcpy(buffer->storage->data + buffer->length, str, n);
+  buffer->length += n;
+  buffer->storage->data[buffer->length] = '\0';
+  return true;
+}
+
+/// Append n characters from the given offset of the output buffer itself.
+static bool __rcutils_logging_append_from_self(
+  rcutils_logging_output_buffer_t * buffer, size_t offset, size_t n)
+{
+  // Ensure the space first, since growing the buffer might move the characters to copy.
+  if (!__rcutils_logging_ensure_large_enough_buffer(buffer, n)) {
+    return false;
+  }
+  memcpy(buffer->storage->data + buffer->length, buffer->storage->data + offset, n);
+  buffer->length += n;
+  buffer->storage->data[buffer->length] = '\0';
+  return true;
+}
+
+/// Format the message directly into the output buffer.
+/**
+ * The message is only formatted a second time if it doesn't fit into the
+ * remaining space of the buffer, after growing the buffer as needed.
+ *
+ * \return true if successful, false if formatting or allocating memory failed.
+ */
+static bool __rcutils_logging_append_formatted(
+  rcutils_logging_output_buffer_t * buffer, const char * format, va_list * args)
+{
+  int written;
+  {
+    // use copy of args to keep args for potential later user
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    written = vsnprintf(
+      buffer->storage->data + buffer->length, buffer->storage->capacity - buffer->length,
+      format, args_clone);
+    va_end(args_clone);
+  }
+  if (written < 0) {
+    fprintf(stderr, "failed to format message: '%s'\n", format);
+    // Restore the null terminator in case the partial output overwrote it.
+    buffer->storage->data[buffer->length] = '\0';
+    return false;
+  }
+  if ((size_t)written >= buffer->storage->capacity - buffer->length) {
+    // write was incomplete, grow the buffer to the necessary size and format again
+    if (!__rcutils_logging_ensure_large_enough_buffer(buffer, (size_t)written)) {
+      buffer->storage->data[buffer->length] = '\0';
+      return false;
+    }
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    int rewritten = vsnprintf(
+      buffer->storage->data + buffer->length, buffer->storage->capacity - buffer->length,
+      format, args_clone);
+    va_end(args_clone);
+    if (rewritten != written) {
+      fprintf(
+        stderr,
+        "failed to format message (using dynamically allocated memory): '%s'\n",
+        format);
+      buffer->storage->data[buffer->length] = '\0';
+      return false;
+    }
+  }
+  buffer->length += (size_t)written;
+  return true;
+}
+
+/// The values the tokens of one output line are expanded from.
+typedef struct rcutils_logging_token_context_t
+{
+  const char * severity_string;
+  const char * name;
+  const rcutils_log_location_t * location;
+  // The time of the output line, which is only taken if a time token is used.
+  rcutils_time_point_value_t time;
+  bool has_time;
+  char line_number_expansion[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  // Room for the decimal point as well.
+  char time_expansion[RCUTILS_FORMAT_INT64_MAX_LENGTH + 2];
+  char time_as_nanoseconds_expansion[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+} rcutils_logging_token_context_t;
+
+static void __rcutils_logging_init_token_context(
+  rcutils_logging_token_context_t * context,
+  const char * severity_string, const char * name, const rcutils_log_location_t * location)
+{
+  context->severity_string = severity_string;
+  context->name = name;
+  context->location = location;
+  context->has_time = false;
+}
+
+/// Expand the time in seconds, with or without the decimal point before the nanoseconds.
 /**
- * Macro for (re)allocating a dynamic buffer if the ouput buffer doesn't have
- * enough space for an additional n characters and null terminator.
- * Whether to allocate or re-allocate is determined by if the output_buffer
- * points to the original static_output_buffer or not.
- * If a new buffer is allocated it will be null-terminated.
+ * Only the nanoseconds are rendered for each output line, the digits of the
+ * seconds are cached by each thread until the seconds change.
  *
- * /param n Number of characters requiring space (not including null terminator)
- * /param output_buffer_size Size allocated for the output buffer
- * /param output_buffer The output buffer to ensure has enough space
- * /param static_output_buffer The static buffer initially used as the output
+ * \return the null-terminated expansion, or NULL if getting the time failed.
+ */
+static const char * __rcutils_logging_expand_time(
+  rcutils_logging_token_context_t * context, bool decimal_point, char * expansion)
+{
+  if (!context->has_time) {
+    if (rcutils_system_time_now(&context->time) != RCUTILS_RET_OK) {
+      fprintf(stderr, "failed to get the time: %s\n", rcutils_get_error_string_safe());
+      rcutils_reset_error();
+      return NULL;
+    }
+    context->has_time = true;
+  }
+  size_t length = 0;
+  uint64_t magnitude;
+  if (context->time < 0) {
+    // Times before the epoch aren't worth caching, the sign applies to the nanoseconds as well.
+    magnitude = 0 - (uint64_t)context->time;
+    expansion[length++] = '-';
+    length += rcutils_format_uint64(magnitude / RCUTILS_S_TO_NS(1), expansion + length);
+  } else {
+    magnitude = (uint64_t)context->time;
+    rcutils_logging_thread_token_cache_t * cache = &g_rcutils_logging_thread_token_cache;
+    int64_t seconds = context->time / RCUTILS_S_TO_NS(1);
+    if (0 == cache->seconds_digits_length || seconds != cache->seconds) {
+      cache->seconds = seconds;
+      cache->seconds_digits_length = rcutils_format_int64(seconds, cache->seconds_digits);
+    }
+    length = cache->seconds_digits_length;
+    memcpy(expansion, cache->seconds_digits, length);
+  }
+  if (decimal_point) {
+    expansion[length++] = '.';
+  }
+  rcutils_format_uint64_fixed(magnitude % RCUTILS_S_TO_NS(1), 9, expansion + length);
+  expansion[length + 9] = '\0';
+  return expansion;
+}
+
+/// Expand a token which isn't a literal or the message.
+/**
+ * \return the null-terminated expansion, or NULL if formatting the token failed.
+ */
+static const char * __rcutils_logging_expand_token(
+  const rcutils_logging_output_format_op_t * op, rcutils_logging_token_context_t * context)
+{
+  const rcutils_log_location_t * location = context->location;
+  switch (op->type) {
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_SEVERITY:
+      return context->severity_string;
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_NAME:
+      return context->name;
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FUNCTION_NAME:
+      return location ? location->function_name : "\"\"";
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_FILE_NAME:
+      return location ? location->file_name : "\"\"";
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LINE_NUMBER:
+      if (location) {
+        rcutils_format_uint64(location->line_number, context->line_number_expansion);
+        return context->line_number_expansion;
+      }
+      return "0";
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME:
+      return __rcutils_logging_expand_time(context, true, context->time_expansion);
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_TIME_AS_NANOSECONDS:
+      return __rcutils_logging_expand_time(
+        context, false, context->time_as_nanoseconds_expansion);
+    case RCUTILS_LOGGING_OUTPUT_FORMAT_OP_THREAD_ID:
+      if ('\0' == g_rcutils_logging_thread_token_cache.thread_id[0]) {
+        rcutils_format_uint64(
+          rcutils_thread_get_id(), g_rcutils_logging_thread_token_cache.thread_id);
+      }
+      return g_rcutils_logging_thread_token_cache.thread_id;
+    default:
+      return NULL;
+  }
+}
+
+#ifndef _WIN32
+/// Write all pieces to the file descriptor, with a single system call unless it is interrupted.
+static void __rcutils_logging_writev(int fd, struct iovec * iov, int iovcnt)
+{
+  while (iovcnt > 0) {
+    ssize_t written = writev(fd, iov, iovcnt);
+    if (written < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      if (!g_rcutils_logging_write_failure_reported) {
+        g_rcutils_logging_write_failure_reported = true;
+        fprintf(stderr, "Error: failed to write log output, errno is: %d\n", errno);
+      }
+      return;
+    }
+    // Skip the pieces which were written completely and continue within a partially written one.
+    while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+      written -= (ssize_t)iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = (char *)iov->iov_base + written;
+      iov->iov_len -= (size_t)written;
+    }
+  }
+}
+#endif  // _WIN32
+
+/// Get the name of the severity level, or report that it is unknown.
+static const char * __rcutils_logging_get_severity_string(int severity)
+{
+  if (severity < 0 ||
+    severity >=
+    (int)(sizeof(g_rcutils_log_severity_names) / sizeof(g_rcutils_log_severity_names[0])) ||
+    NULL == g_rcutils_log_severity_names[severity])
+  {
+    fprintf(stderr, "couldn't determine name for severity level: %d\n", severity);
+    return NULL;
+  }
+  return g_rcutils_log_severity_names[severity];
+}
+
+/// Start an empty output line in the scratch buffer of the calling thread.
+/**
+ * The scratch buffer is grown as needed and reused for the following output lines.
  */
-#define RCUTILS_LOGGING_ENSURE_LARGE_ENOUGH_BUFFER( \
-    n, \
-    output_buffer_size, \
-    output_buffer, \
-    static_output_buffer \
-) \
-  size_t old_output_buffer_len = strlen(output_buffer); \
-  size_t required_output_buffer_size = old_output_buffer_len + n + 1; \
-  if (required_output_buffer_size > output_buffer_size) { \
-    do { \
-      output_buffer_size *= 2; \
-    } while (required_output_buffer_size > output_buffer_size); \
-    if (output_buffer == static_output_buffer) { \
-      void * dynamic_output_buffer = g_rcutils_logging_allocator.allocate( \
-        output_buffer_size, g_rcutils_logging_allocator.state); \
-      if (NULL == dynamic_output_buffer) { \
-        fprintf(stderr, "failed to allocate buffer for logging output\n"); \
-        goto cleanup; \
-      } \
-      memcpy(dynamic_output_buffer, output_buffer, old_output_buffer_len); \
-      output_buffer = (char *)dynamic_output_buffer; \
-    } else { \
-      void * new_dynamic_output_buffer = g_rcutils_logging_allocator.reallocate( \
-        output_buffer, output_buffer_size, g_rcutils_logging_allocator.state); \
-      if (NULL == new_dynamic_output_buffer) { \
-        fprintf(stderr, "failed to reallocate buffer for logging output\n"); \
-        goto cleanup; \
-      } \
-      output_buffer = (char *)new_dynamic_output_buffer; \
-    } \
-    output_buffer[old_output_buffer_len] = '\0'; \
+static bool __rcutils_logging_init_output_buffer(rcutils_logging_output_buffer_t * output_buffer)
+{
+  output_buffer->storage = &g_rcutils_logging_thread_scratch_buffers.output;
+  output_buffer->length = 0;
+  if (!__rcutils_logging_ensure_large_enough_buffer(output_buffer, 0)) {
+    return false;
+  }
+  output_buffer->storage->data[0] = '\0';
+  return true;
+}
+
+bool rcutils_logging_render_output_line(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args,
+  const char ** line, size_t * line_length)
+{
+  const char * severity_string = __rcutils_logging_get_severity_string(severity);
+  if (NULL == severity_string) {
+    return false;
+  }
+  rcutils_logging_output_buffer_t output_buffer;
+  if (!__rcutils_logging_init_output_buffer(&output_buffer)) {
+    return false;
+  }
+  rcutils_logging_token_context_t token_context;
+  __rcutils_logging_init_token_context(&token_context, severity_string, name, location);
+
+  // The message is formatted in place the first time the message token is expanded, subsequent
+  // expansions copy it from there.
+  size_t message_offset = 0;
+  size_t message_length = 0;
+  bool message_formatted = false;
+
+  // Render the compiled output format, expanding the tokens.
+  for (size_t i = 0; i < g_rcutils_logging_output_format_ops_count; ++i) {
+    const rcutils_logging_output_format_op_t * op = &g_rcutils_logging_output_format_ops[i];
+    if (RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LITERAL == op->type) {
+      if (!__rcutils_logging_append(&output_buffer, op->literal, op->literal_length)) {
+        return false;
+      }
+    } else if (RCUTILS_LOGGING_OUTPUT_FORMAT_OP_MESSAGE == op->type) {
+      if (message_formatted) {
+        if (!__rcutils_logging_append_from_self(&output_buffer, message_offset, message_length)) {
+          return false;
+        }
+        continue;
+      }
+      message_offset = output_buffer.length;
+      if (!__rcutils_logging_append_formatted(&output_buffer, format, args)) {
+        return false;
+      }
+      message_length = output_buffer.length - message_offset;
+      message_formatted = true;
+    } else {
+      // The resulting token_expansion string must always be null-terminated.
+      const char * token_expansion = __rcutils_logging_expand_token(op, &token_context);
+      if (NULL == token_expansion ||
+        !__rcutils_logging_append(&output_buffer, token_expansion, strlen(token_expansion)))
+      {
+        return false;
+      }
+    }
   }
+  *line = output_buffer.storage->data;
+  *line_length = output_buffer.length;
+  return true;
+}
 
 void rcutils_logging_console_output_handler(
   const rcutils_log_location_t * location,
   int severity, const char * name, const char * format, va_list * args)
 {
-  if (!g_rcutils_logging_initialized) {
+  if (!RCUTILS_LOGGING_IS_INITIALIZED()) {
     fprintf(
       stderr,
       "logging system isn't initialized: " \
@@ -412,7 +2182,6 @@ void rcutils_logging_console_output_handler(
     return;
   }
   FILE * stream = NULL;
-  const char * severity_string = "";
   switch (severity) {
     case RCUTILS_LOG_SEVERITY_DEBUG:
       stream = stdout;
@@ -433,151 +2202,89 @@ void rcutils_logging_console_output_handler(
       fprintf(stderr, "unknown severity level: %d\n", severity);
       return;
   }
-  severity_string = g_rcutils_log_severity_names[severity];
-  if (NULL == severity_string) {
-    fprintf(stderr, "couldn't determine name for severity level: %d\n", severity);
-    return;
-  }
-
-  // Declare variables that will be needed for cleanup ahead of time.
-  char static_output_buffer[1024];
-  char * output_buffer = NULL;
-
-  // Start with a fixed size message buffer and if during message formatting we need longer, we'll
-  // dynamically allocate space.
-  char static_message_buffer[1024];
-  char * message_buffer = static_message_buffer;
-
-  int written;
+#ifndef _WIN32
+  int fd = stream == stdout ? STDOUT_FILENO : STDERR_FILENO;
+  if (g_rcutils_logging_console_output_writev &&
+    g_rcutils_logging_output_format_ops_count < RCUTILS_LOGGING_MAX_OUTPUT_IOVECS)
   {
-    // use copy of args to keep args for potential later user
-    va_list args_clone;
-    va_copy(args_clone, *args);
-    written = vsnprintf(static_message_buffer, sizeof(static_message_buffer), format, args_clone);
-    va_end(args_clone);
-  }
-  if (written < 0) {
-    fprintf(stderr, "failed to format message: '%s'\n", format);
-    return;
-  }
-  if ((size_t)written >= sizeof(static_message_buffer)) {
-    // write was incomplete, allocate necessary memory dynamically
-    size_t message_buffer_size = written + 1;
-    void * dynamic_message_buffer = g_rcutils_logging_allocator.allocate(
-      message_buffer_size, g_rcutils_logging_allocator.state);
-    if (NULL == dynamic_message_buffer) {
-      fprintf(stderr, "failed to allocate buffer for message\n");
+    const char * severity_string = __rcutils_logging_get_severity_string(severity);
+    if (NULL == severity_string) {
       return;
     }
-    written = vsnprintf(dynamic_message_buffer, message_buffer_size, format, *args);
-    message_buffer = (char *)dynamic_message_buffer;
-    if (written < 0 || (size_t)written >= message_buffer_size) {
-      fprintf(
-        stderr,
-        "failed to format message (using dynamically allocated memory): '%s'\n",
-        format);
-      goto cleanup;
-    }
-  }
-
-  // Process the format string looking for known tokens.
-  const char token_start_delimiter = '{';
-  const char token_end_delimiter = '}';
-  // Start with a fixed size output buffer and if during token expansion we need longer, we'll
-  // dynamically allocate space.
-  output_buffer = static_output_buffer;
-  output_buffer[0] = '\0';
-  size_t output_buffer_size = sizeof(static_output_buffer);
-  const char * str = g_rcutils_logging_output_format_string;
-  size_t size = strlen(g_rcutils_logging_output_format_string);
-
-  // Walk through the format string and expand tokens when they're encountered.
-  size_t i = 0;
-  while (i < size) {
-    // Print everything up to the next token start delimiter.
-    size_t chars_to_start_delim = rcutils_find(str + i, token_start_delimiter);
-    size_t remaining_chars = size - i;
-    if (chars_to_start_delim > 0) {
-      if (chars_to_start_delim > remaining_chars) {
-        // No start delimiters found; don't allow printing more of than what's left if.
-        chars_to_start_delim = remaining_chars;
-      }
-      RCUTILS_LOGGING_ENSURE_LARGE_ENOUGH_BUFFER(
-        chars_to_start_delim, output_buffer_size, output_buffer, static_output_buffer)
-      memcpy(output_buffer + old_output_buffer_len, str + i, chars_to_start_delim);
-      output_buffer[old_output_buffer_len + chars_to_start_delim] = '\0';
-      i += chars_to_start_delim;
-      if (i >= size) {
-        break;
-      }
-    }
-    // We are at a token start delimiter: determine if there's a known token or not.
-    // Potential tokens can't possibly be longer than the format string itself.
-    char token[RCUTILS_LOGGING_MAX_OUTPUT_FORMAT_LEN];
-    // Look for a token end delimiter.
-    size_t chars_to_end_delim = rcutils_find(str + i, token_end_delimiter);
-    remaining_chars = size - i;
-    if (chars_to_end_delim > remaining_chars) {
-      // No end delimiters found in the remainder of the format string;
-      // there won't be any more tokens so shortcut the rest of the checking.
-      RCUTILS_LOGGING_ENSURE_LARGE_ENOUGH_BUFFER(
-        remaining_chars, output_buffer_size, output_buffer, static_output_buffer)
-      memcpy(output_buffer + old_output_buffer_len, str + i, remaining_chars + 1);
-      break;
+    rcutils_logging_output_buffer_t output_buffer;
+    if (!__rcutils_logging_init_output_buffer(&output_buffer)) {
+      return;
     }
-    // Found what looks like a token; determine if it's recognized.
-    size_t token_len = chars_to_end_delim - 1;  // Not including delimiters.
-    memcpy(token, str + i + 1, token_len);  // Skip the start delimiter.
-    token[token_len] = '\0';
-    // Expand known tokens into their content strings.
-    // The resulting token_expansion string must always be null-terminated.
-    const char * token_expansion = NULL;
-    // Allow 9 digits for the expansion of the line number (otherwise, truncate).
-    char line_number_expansion[10];
-    if (strcmp("severity", token) == 0) {
-      token_expansion = severity_string;
-    } else if (strcmp("name", token) == 0) {
-      token_expansion = name;
-    } else if (strcmp("message", token) == 0) {
-      token_expansion = message_buffer;
-    } else if (strcmp("function_name", token) == 0) {
-      token_expansion = location ? location->function_name : "\"\"";
-    } else if (strcmp("file_name", token) == 0) {
-      token_expansion = location ? location->file_name : "\"\"";
-    } else if (strcmp("line_number", token) == 0) {
-      if (location) {
-        // Even in the case of truncation the result will still be null-terminated.
-        written = rcutils_snprintf(
-          line_number_expansion, sizeof(line_number_expansion), "%zu", location->line_number);
-        if (written < 0) {
-          fprintf(
-            stderr,
-            "failed to format line number: '%zu'\n",
-            location->line_number);
-          goto cleanup;
+    rcutils_logging_token_context_t token_context;
+    __rcutils_logging_init_token_context(&token_context, severity_string, name, location);
+    // Write the pieces of the output line directly, only the message is formatted into the
+    // scratch buffer.
+    struct iovec iov[RCUTILS_LOGGING_MAX_OUTPUT_IOVECS];
+    int iovcnt = 0;
+    bool message_formatted = false;
+    for (size_t i = 0; i < g_rcutils_logging_output_format_ops_count; ++i) {
+      const rcutils_logging_output_format_op_t * op = &g_rcutils_logging_output_format_ops[i];
+      if (RCUTILS_LOGGING_OUTPUT_FORMAT_OP_LITERAL == op->type) {
+        iov[iovcnt].iov_base = (void *)op->literal;
+        iov[iovcnt].iov_len = op->literal_length;
+      } else if (RCUTILS_LOGGING_OUTPUT_FORMAT_OP_MESSAGE == op->type) {
+        // Nothing else is written into the scratch buffer, so the message doesn't move.
+        if (!message_formatted &&
+          !__rcutils_logging_append_formatted(&output_buffer, format, args))
+        {
+          return;
         }
-        token_expansion = line_number_expansion;
+        message_formatted = true;
+        iov[iovcnt].iov_base = output_buffer.storage->data;
+        iov[iovcnt].iov_len = output_buffer.length;
       } else {
-        token_expansion = "0";
+        const char * token_expansion = __rcutils_logging_expand_token(op, &token_context);
+        if (NULL == token_expansion) {
+          return;
+        }
+        iov[iovcnt].iov_base = (void *)token_expansion;
+        iov[iovcnt].iov_len = strlen(token_expansion);
       }
-    } else {
-      // This wasn't a token; print the start delimiter and continue the search as usual
-      // (the substring might contain more start delimiters).
-      RCUTILS_LOGGING_ENSURE_LARGE_ENOUGH_BUFFER(
-        1, output_buffer_size, output_buffer, static_output_buffer)
-      memcpy(output_buffer + old_output_buffer_len, str + i, 1);
-      output_buffer[old_output_buffer_len + 1] = '\0';
-      i++;
-      continue;
+      ++iovcnt;
     }
-    size_t n = strlen(token_expansion);
-    RCUTILS_LOGGING_ENSURE_LARGE_ENOUGH_BUFFER(
-      n, output_buffer_size, output_buffer, static_output_buffer)
-    memcpy(output_buffer + old_output_buffer_len, token_expansion, n + 1);
-    // Skip ahead to avoid re-processing the token characters (including the 2 delimiters).
-    i += token_len + 2;
+    iov[iovcnt].iov_base = "\n";
+    iov[iovcnt].iov_len = 1;
+    ++iovcnt;
+    // The pieces are advanced in place by a partial write, so count them before writing.
+    size_t bytes = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+      bytes += iov[i].iov_len;
+    }
+    rcutils_logging_add_output_volume(bytes);
+    __rcutils_logging_writev(fd, iov, iovcnt);
+    return;
+  }
+#endif  // _WIN32
+
+  // Render the whole output line into the scratch buffer.
+  const char * line = NULL;
+  size_t line_length = 0;
+  if (!rcutils_logging_render_output_line(
+      location, severity, name, format, args, &line, &line_length))
+  {
+    return;
   }
-  fprintf(stream, "%s\n", output_buffer);
+  rcutils_logging_add_output_volume(line_length + 1);
+
+#ifndef _WIN32
+  if (g_rcutils_logging_console_output_writev) {
+    // The format has too many pieces to write them directly, write the rendered line instead.
+    struct iovec iov[2];
+    iov[0].iov_base = (void *)line;
+    iov[0].iov_len = line_length;
+    iov[1].iov_base = "\n";
+    iov[1].iov_len = 1;
+    __rcutils_logging_writev(fd, iov, 2);
+    return;
+  }
+#endif  // _WIN32
+
+  fprintf(stream, "%s\n", line);
 
   if (g_force_stdout_line_buffered && stream == stdout) {
     int flush_result = fflush(stream);
@@ -587,15 +2294,6 @@ void rcutils_logging_console_output_handler(
         flush_result);
     }
   }
-
-cleanup:
-  if (message_buffer && message_buffer != static_message_buffer) {
-    g_rcutils_logging_allocator.deallocate(message_buffer, g_rcutils_logging_allocator.state);
-  }
-
-  if (output_buffer && output_buffer != static_output_buffer) {
-    g_rcutils_logging_allocator.deallocate(output_buffer, g_rcutils_logging_allocator.state);
-  }
 }
 
 #if __cplusplus
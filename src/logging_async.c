@@ -0,0 +1,502 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "./common.h"
+#include "./stdatomic_helper.h"
+#include "./thread_helper.h"
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_async.h"
+#include "rcutils/macros.h"
+
+/// A record in the queue, the logger name and message are stored separately.
+/**
+ * The queue is the bounded multi-producer multi-consumer queue described by
+ * Dmitry Vyukov: each record has a sequence number which tells producers and
+ * consumers whether the record is free for the position they claimed or not.
+ */
+typedef struct rcutils_logging_async_record_t
+{
+  atomic_size_t sequence;
+  rcutils_log_location_t location;
+  bool has_location;
+  int severity;
+} rcutils_logging_async_record_t;
+
+typedef struct rcutils_logging_async_queue_t
+{
+  rcutils_logging_async_record_t * records;
+  // The logger names and messages of all records, each taking `record_data_size` bytes.
+  char * record_data;
+  size_t record_data_size;
+  size_t mask;
+  size_t max_name_length;
+  size_t max_message_length;
+  rcutils_logging_async_overflow_policy_t overflow_policy;
+  rcutils_allocator_t allocator;
+
+  atomic_size_t enqueue_position;
+  atomic_size_t dequeue_position;
+
+  // Records are only queued while this is true.
+  atomic_bool enabled;
+  // The drain thread keeps running while this is true.
+  atomic_bool running;
+  // The number of threads currently inside the output handler.
+  atomic_size_t active_producers;
+
+  // The drain thread waits for records while the queue is empty, and producers of the
+  // blocking overflow policy wait for room while it is full. Waking a thread takes the mutex,
+  // which is only done if the flag or counter below says that a thread waits.
+  rcutils_mutex_t mutex;
+  rcutils_condition_t not_empty;
+  rcutils_condition_t not_full;
+  atomic_bool drain_waiting;
+  atomic_size_t blocked_producers;
+
+  rcutils_logging_output_handler_t output_handler;
+  rcutils_thread_t drain_thread;
+  // Storage for the record currently being written by the drain thread.
+  rcutils_logging_async_record_t drain_record;
+  char * drain_record_data;
+
+  atomic_uint_least64_t enqueued;
+  atomic_uint_least64_t written;
+  atomic_uint_least64_t dropped;
+  atomic_uint_least64_t truncated;
+} rcutils_logging_async_queue_t;
+
+static rcutils_logging_async_queue_t g_rcutils_logging_async_queue;
+static bool g_rcutils_logging_async_started = false;
+static RCUTILS_THREAD_LOCAL bool g_rcutils_logging_async_is_drain_thread = false;
+
+rcutils_logging_async_options_t
+rcutils_logging_async_get_default_options(void)
+{
+  rcutils_logging_async_options_t options;
+  options.queue_capacity = 1024;
+  options.max_message_length = 1023;
+  options.max_name_length = 255;
+  options.overflow_policy = RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST;
+  options.allocator = rcutils_get_default_allocator();
+  return options;
+}
+
+static bool
+__rcutils_logging_async_try_enqueue(
+  rcutils_logging_async_queue_t * queue,
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args)
+{
+  rcutils_logging_async_record_t * record;
+  size_t position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+  while (true) {
+    record = &queue->records[position & queue->mask];
+    size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+    if (0 == difference) {
+      // The record is free, try to claim it.
+      if (atomic_compare_exchange_weak_explicit(
+          &queue->enqueue_position, &position, position + 1,
+          memory_order_relaxed, memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // The record still holds the entry of the previous lap, the queue is full.
+      return false;
+    } else {
+      // Another producer claimed this position first.
+      position = atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    }
+  }
+
+  bool truncated = false;
+  record->has_location = (NULL != location);
+  if (location) {
+    record->location = *location;
+  }
+  record->severity = severity;
+  char * name_buffer = queue->record_data + (position & queue->mask) * queue->record_data_size;
+  size_t name_length = strlen(name);
+  if (name_length > queue->max_name_length) {
+    name_length = queue->max_name_length;
+    truncated = true;
+  }
+  memcpy(name_buffer, name, name_length);
+  name_buffer[name_length] = '\0';
+  char * message_buffer = name_buffer + queue->max_name_length + 1;
+  int written = vsnprintf(message_buffer, queue->max_message_length + 1, format, *args);
+  if (written < 0) {
+    fprintf(stderr, "failed to format message: '%s'\n", format);
+    message_buffer[0] = '\0';
+  } else if ((size_t)written > queue->max_message_length) {
+    truncated = true;
+  }
+  if (truncated) {
+    atomic_fetch_add_explicit(&queue->truncated, 1, memory_order_relaxed);
+  }
+
+  // Publish the record to the consumers.
+  atomic_store_explicit(&record->sequence, position + 1, memory_order_release);
+  return true;
+}
+
+/// Remove the oldest record from the queue, copying it into the drain record if requested.
+static bool
+__rcutils_logging_async_try_dequeue(rcutils_logging_async_queue_t * queue, bool copy)
+{
+  rcutils_logging_async_record_t * record;
+  size_t position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+  while (true) {
+    record = &queue->records[position & queue->mask];
+    size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+    intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+    if (0 == difference) {
+      // The record has been published, try to claim it.
+      if (atomic_compare_exchange_weak_explicit(
+          &queue->dequeue_position, &position, position + 1,
+          memory_order_relaxed, memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // The record hasn't been published yet, the queue is empty.
+      return false;
+    } else {
+      // Another consumer claimed this position first.
+      position = atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    }
+  }
+
+  if (copy) {
+    queue->drain_record.location = record->location;
+    queue->drain_record.has_location = record->has_location;
+    queue->drain_record.severity = record->severity;
+    char * data = queue->record_data + (position & queue->mask) * queue->record_data_size;
+    size_t name_length = strlen(data) + 1;
+    memcpy(queue->drain_record_data, data, name_length);
+    char * message = data + queue->max_name_length + 1;
+    memcpy(
+      queue->drain_record_data + queue->max_name_length + 1, message, strlen(message) + 1);
+  }
+
+  // Hand the record back to the producers for the next lap.
+  atomic_store_explicit(&record->sequence, position + queue->mask + 1, memory_order_release);
+  return true;
+}
+
+/// Whether the record at the dequeue position hasn't been published yet.
+static bool
+__rcutils_logging_async_is_empty(rcutils_logging_async_queue_t * queue)
+{
+  size_t position = atomic_load(&queue->dequeue_position);
+  return atomic_load(&queue->records[position & queue->mask].sequence) != position + 1;
+}
+
+/// Whether the record at the enqueue position still holds the entry of the previous lap.
+static bool
+__rcutils_logging_async_is_full(rcutils_logging_async_queue_t * queue)
+{
+  size_t position = atomic_load(&queue->enqueue_position);
+  return atomic_load(&queue->records[position & queue->mask].sequence) != position;
+}
+
+/// Call an output handler with a message which has already been formatted.
+static void
+__rcutils_logging_async_call_output_handler(
+  rcutils_logging_output_handler_t output_handler,
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  (*output_handler)(location, severity, name, format, &args);
+  va_end(args);
+}
+
+static void
+__rcutils_logging_async_drain(void * arg)
+{
+  rcutils_logging_async_queue_t * queue = (rcutils_logging_async_queue_t *)arg;
+  g_rcutils_logging_async_is_drain_thread = true;
+  while (true) {
+    // Once this is false, all producers left and the records they queued can be dequeued.
+    bool running = atomic_load(&queue->running);
+    if (__rcutils_logging_async_try_dequeue(queue, true)) {
+      if (queue->output_handler) {
+        __rcutils_logging_async_call_output_handler(
+          queue->output_handler,
+          queue->drain_record.has_location ? &queue->drain_record.location : NULL,
+          queue->drain_record.severity,
+          queue->drain_record_data,
+          "%s", queue->drain_record_data + queue->max_name_length + 1);
+      }
+      atomic_fetch_add_explicit(&queue->written, 1, memory_order_relaxed);
+      // Pairs with the fence of the producers which register as blocked before checking for room.
+      atomic_thread_fence(memory_order_seq_cst);
+      if (atomic_load(&queue->blocked_producers) != 0) {
+        rcutils_mutex_lock(&queue->mutex);
+        rcutils_condition_broadcast(&queue->not_full);
+        rcutils_mutex_unlock(&queue->mutex);
+      }
+      continue;
+    }
+    // The queue is empty, stop once there are no more producers, otherwise wait for more records.
+    if (!running) {
+      break;
+    }
+    rcutils_mutex_lock(&queue->mutex);
+    atomic_store(&queue->drain_waiting, true);
+    // Pairs with the fence of the producers which check the flag after publishing a record.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&queue->running) && __rcutils_logging_async_is_empty(queue)) {
+      rcutils_condition_wait(&queue->not_empty, &queue->mutex);
+    }
+    atomic_store(&queue->drain_waiting, false);
+    rcutils_mutex_unlock(&queue->mutex);
+  }
+}
+
+void rcutils_logging_async_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args)
+{
+  rcutils_logging_async_queue_t * queue = &g_rcutils_logging_async_queue;
+  atomic_fetch_add(&queue->active_producers, 1);
+  if (!atomic_load(&queue->enabled) || g_rcutils_logging_async_is_drain_thread) {
+    // Not logging asynchronously (anymore), or logging from within the wrapped output handler
+    // which must not wait for itself.
+    atomic_fetch_sub(&queue->active_producers, 1);
+    rcutils_logging_output_handler_t output_handler = queue->output_handler;
+    if (output_handler && output_handler != rcutils_logging_async_output_handler) {
+      (*output_handler)(location, severity, name, format, args);
+    }
+    return;
+  }
+
+  while (!__rcutils_logging_async_try_enqueue(queue, location, severity, name, format, args)) {
+    if (RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST == queue->overflow_policy) {
+      atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+      atomic_fetch_sub(&queue->active_producers, 1);
+      return;
+    }
+    if (RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_OLDEST == queue->overflow_policy) {
+      if (__rcutils_logging_async_try_dequeue(queue, false)) {
+        atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+      }
+    } else {
+      // The drain thread keeps running until all producers left, so it will make room eventually.
+      rcutils_mutex_lock(&queue->mutex);
+      atomic_fetch_add(&queue->blocked_producers, 1);
+      atomic_thread_fence(memory_order_seq_cst);
+      if (__rcutils_logging_async_is_full(queue)) {
+        rcutils_condition_wait(&queue->not_full, &queue->mutex);
+      }
+      atomic_fetch_sub(&queue->blocked_producers, 1);
+      rcutils_mutex_unlock(&queue->mutex);
+    }
+  }
+  atomic_fetch_add_explicit(&queue->enqueued, 1, memory_order_relaxed);
+  // Only wake the drain thread if it waits for the queue to become non-empty.
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load(&queue->drain_waiting)) {
+    rcutils_mutex_lock(&queue->mutex);
+    rcutils_condition_signal(&queue->not_empty);
+    rcutils_mutex_unlock(&queue->mutex);
+  }
+  atomic_fetch_sub(&queue->active_producers, 1);
+}
+
+rcutils_ret_t
+rcutils_logging_async_start(const rcutils_logging_async_options_t * options)
+{
+  rcutils_logging_async_options_t default_options = rcutils_logging_async_get_default_options();
+  if (NULL == options) {
+    options = &default_options;
+  }
+  RCUTILS_CHECK_ALLOCATOR_WITH_MSG(
+    &options->allocator, "invalid allocator", return RCUTILS_RET_INVALID_ARGUMENT)
+  rcutils_allocator_t allocator = options->allocator;
+  if (0 == options->queue_capacity || options->queue_capacity > (SIZE_MAX >> 2)) {
+    RCUTILS_SET_ERROR_MSG("invalid queue capacity", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (options->overflow_policy != RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST &&
+    options->overflow_policy != RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_OLDEST &&
+    options->overflow_policy != RCUTILS_LOGGING_ASYNC_OVERFLOW_BLOCK)
+  {
+    RCUTILS_SET_ERROR_MSG("invalid overflow policy", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (g_rcutils_logging_async_started) {
+    RCUTILS_SET_ERROR_MSG("already logging asynchronously", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+
+  // The algorithm of the queue requires a power of two for the capacity, and at least 2 records.
+  size_t capacity = 2;
+  while (capacity < options->queue_capacity) {
+    capacity <<= 1;
+  }
+  rcutils_logging_async_queue_t * queue = &g_rcutils_logging_async_queue;
+  queue->mask = capacity - 1;
+  queue->max_name_length = options->max_name_length;
+  queue->max_message_length = options->max_message_length;
+  queue->record_data_size = options->max_name_length + 1 + options->max_message_length + 1;
+  queue->overflow_policy = options->overflow_policy;
+  queue->allocator = allocator;
+  queue->records = allocator.allocate(
+    capacity * sizeof(rcutils_logging_async_record_t), allocator.state);
+  queue->record_data = allocator.allocate(capacity * queue->record_data_size, allocator.state);
+  queue->drain_record_data = allocator.allocate(queue->record_data_size, allocator.state);
+  if (NULL == queue->records || NULL == queue->record_data || NULL == queue->drain_record_data) {
+    allocator.deallocate(queue->records, allocator.state);
+    allocator.deallocate(queue->record_data, allocator.state);
+    allocator.deallocate(queue->drain_record_data, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for the logging queue", allocator)
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  if (rcutils_mutex_init(&queue->mutex) != RCUTILS_RET_OK) {
+    allocator.deallocate(queue->records, allocator.state);
+    allocator.deallocate(queue->record_data, allocator.state);
+    allocator.deallocate(queue->drain_record_data, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the mutex of the logging queue", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  if (rcutils_condition_init(&queue->not_empty) != RCUTILS_RET_OK) {
+    rcutils_mutex_fini(&queue->mutex);
+    allocator.deallocate(queue->records, allocator.state);
+    allocator.deallocate(queue->record_data, allocator.state);
+    allocator.deallocate(queue->drain_record_data, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the conditions of the logging queue", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  if (rcutils_condition_init(&queue->not_full) != RCUTILS_RET_OK) {
+    rcutils_condition_fini(&queue->not_empty);
+    rcutils_mutex_fini(&queue->mutex);
+    allocator.deallocate(queue->records, allocator.state);
+    allocator.deallocate(queue->record_data, allocator.state);
+    allocator.deallocate(queue->drain_record_data, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the conditions of the logging queue", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  for (size_t i = 0; i < capacity; ++i) {
+    atomic_init(&queue->records[i].sequence, i);
+  }
+  atomic_init(&queue->enqueue_position, 0);
+  atomic_init(&queue->dequeue_position, 0);
+  atomic_init(&queue->active_producers, 0);
+  atomic_init(&queue->drain_waiting, false);
+  atomic_init(&queue->blocked_producers, 0);
+  atomic_init(&queue->enqueued, 0);
+  atomic_init(&queue->written, 0);
+  atomic_init(&queue->dropped, 0);
+  atomic_init(&queue->truncated, 0);
+  queue->output_handler = rcutils_logging_get_output_handler();
+
+  atomic_store(&queue->running, true);
+  atomic_store(&queue->enabled, true);
+  if (rcutils_thread_create(
+      &queue->drain_thread, __rcutils_logging_async_drain, queue) != RCUTILS_RET_OK)
+  {
+    atomic_store(&queue->enabled, false);
+    atomic_store(&queue->running, false);
+    rcutils_condition_fini(&queue->not_full);
+    rcutils_condition_fini(&queue->not_empty);
+    rcutils_mutex_fini(&queue->mutex);
+    allocator.deallocate(queue->records, allocator.state);
+    allocator.deallocate(queue->record_data, allocator.state);
+    allocator.deallocate(queue->drain_record_data, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to start the logging drain thread", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  g_rcutils_logging_async_started = true;
+  rcutils_logging_set_output_handler(rcutils_logging_async_output_handler);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_async_stop(void)
+{
+  if (!g_rcutils_logging_async_started) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_async_queue_t * queue = &g_rcutils_logging_async_queue;
+  rcutils_allocator_t allocator = queue->allocator;
+  if (rcutils_logging_get_output_handler() == rcutils_logging_async_output_handler) {
+    rcutils_logging_set_output_handler(queue->output_handler);
+  }
+
+  // Stop accepting records and wait for the producers which are still queueing,
+  // the drain thread keeps running in the meantime so that blocked producers can finish.
+  atomic_store(&queue->enabled, false);
+  while (atomic_load(&queue->active_producers) != 0) {
+    rcutils_thread_yield();
+  }
+  rcutils_mutex_lock(&queue->mutex);
+  atomic_store(&queue->running, false);
+  rcutils_condition_signal(&queue->not_empty);
+  rcutils_mutex_unlock(&queue->mutex);
+  if (rcutils_thread_join(&queue->drain_thread) != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG("failed to join the logging drain thread", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  g_rcutils_logging_async_started = false;
+
+  rcutils_condition_fini(&queue->not_full);
+  rcutils_condition_fini(&queue->not_empty);
+  rcutils_mutex_fini(&queue->mutex);
+
+  allocator.deallocate(queue->records, allocator.state);
+  queue->records = NULL;
+  allocator.deallocate(queue->record_data, allocator.state);
+  queue->record_data = NULL;
+  allocator.deallocate(queue->drain_record_data, allocator.state);
+  queue->drain_record_data = NULL;
+  return RCUTILS_RET_OK;
+}
+
+bool
+rcutils_logging_async_is_enabled(void)
+{
+  return atomic_load(&g_rcutils_logging_async_queue.enabled);
+}
+
+rcutils_ret_t
+rcutils_logging_async_get_stats(rcutils_logging_async_stats_t * stats)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(
+    stats, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
+  rcutils_logging_async_queue_t * queue = &g_rcutils_logging_async_queue;
+  stats->enqueued = atomic_load_explicit(&queue->enqueued, memory_order_relaxed);
+  stats->written = atomic_load_explicit(&queue->written, memory_order_relaxed);
+  stats->dropped = atomic_load_explicit(&queue->dropped, memory_order_relaxed);
+  stats->truncated = atomic_load_explicit(&queue->truncated, memory_order_relaxed);
+  return RCUTILS_RET_OK;
+}
+
+#if __cplusplus
+}
+#endif
@@ -0,0 +1,1427 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "./hash_helper.h"
+#include "./logging_binary_format.h"
+#include "./logging_output.h"
+#include "./stdatomic_helper.h"
+#include "./thread_helper.h"
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_binary.h"
+#include "rcutils/strdup.h"
+#include "rcutils/time.h"
+
+// Encoded null string arguments have this length.
+#define RCUTILS_LOGGING_BINARY_NULL_STRING UINT32_MAX
+
+#define RCUTILS_LOGGING_BINARY_MIN_TABLE_CAPACITY 64
+
+// The kinds of arguments a conversion specification consumes.
+typedef enum rcutils_logging_binary_argument_type_t
+{
+  RCUTILS_LOGGING_BINARY_ARGUMENT_NONE,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_DOUBLE,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_STRING,
+  RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER,
+} rcutils_logging_binary_argument_type_t;
+
+// The length modifiers which change how an argument is read.
+typedef enum rcutils_logging_binary_length_t
+{
+  RCUTILS_LOGGING_BINARY_LENGTH_DEFAULT,
+  RCUTILS_LOGGING_BINARY_LENGTH_CHAR,
+  RCUTILS_LOGGING_BINARY_LENGTH_SHORT,
+  RCUTILS_LOGGING_BINARY_LENGTH_LONG,
+  RCUTILS_LOGGING_BINARY_LENGTH_LONG_LONG,
+  RCUTILS_LOGGING_BINARY_LENGTH_INTMAX,
+  RCUTILS_LOGGING_BINARY_LENGTH_SIZE,
+  RCUTILS_LOGGING_BINARY_LENGTH_PTRDIFF,
+  RCUTILS_LOGGING_BINARY_LENGTH_LONG_DOUBLE,
+} rcutils_logging_binary_length_t;
+
+// A parsed conversion specification of a format string.
+typedef struct rcutils_logging_binary_spec_t
+{
+  // The flags, width and precision, which may contain '*'.
+  const char * options;
+  size_t options_length;
+  bool star_width;
+  bool star_precision;
+  // The precision if it is given in the format string, or -1.
+  int precision;
+  rcutils_logging_binary_length_t length;
+  char conversion;
+  rcutils_logging_binary_argument_type_t argument_type;
+} rcutils_logging_binary_spec_t;
+
+/// Parse the conversion specification starting after a '%'.
+/**
+ * \return the position after the specification, or NULL if it isn't supported.
+ */
+static const char *
+__rcutils_logging_binary_parse_spec(const char * position, rcutils_logging_binary_spec_t * spec)
+{
+  spec->options = position;
+  spec->star_width = false;
+  spec->star_precision = false;
+  spec->precision = -1;
+  spec->length = RCUTILS_LOGGING_BINARY_LENGTH_DEFAULT;
+  while ('\0' != *position && strchr("-+ #0", *position)) {
+    ++position;
+  }
+  if ('*' == *position) {
+    spec->star_width = true;
+    ++position;
+  } else {
+    while (*position >= '0' && *position <= '9') {
+      ++position;
+    }
+  }
+  if ('$' == *position) {
+    // Positional arguments can't be read in order.
+    return NULL;
+  }
+  if ('.' == *position) {
+    ++position;
+    if ('*' == *position) {
+      spec->star_precision = true;
+      ++position;
+    } else {
+      spec->precision = 0;
+      while (*position >= '0' && *position <= '9') {
+        if (spec->precision < INT_MAX / 10) {
+          spec->precision = spec->precision * 10 + (*position - '0');
+        }
+        ++position;
+      }
+    }
+  }
+  spec->options_length = (size_t)(position - spec->options);
+  switch (*position) {
+    case 'h':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_SHORT;
+      if ('h' == *position) {
+        ++position;
+        spec->length = RCUTILS_LOGGING_BINARY_LENGTH_CHAR;
+      }
+      break;
+    case 'l':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_LONG;
+      if ('l' == *position) {
+        ++position;
+        spec->length = RCUTILS_LOGGING_BINARY_LENGTH_LONG_LONG;
+      }
+      break;
+    case 'q':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_LONG_LONG;
+      break;
+    case 'j':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_INTMAX;
+      break;
+    case 'z':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_SIZE;
+      break;
+    case 't':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_PTRDIFF;
+      break;
+    case 'L':
+      ++position;
+      spec->length = RCUTILS_LOGGING_BINARY_LENGTH_LONG_DOUBLE;
+      break;
+    default:
+      break;
+  }
+  spec->conversion = *position;
+  switch (spec->conversion) {
+    case 'd':
+    case 'i':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED;
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED;
+      break;
+    case 'c':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR;
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_DOUBLE;
+      break;
+    case 's':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_STRING;
+      break;
+    case 'p':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER;
+      break;
+    case '%':
+      spec->argument_type = RCUTILS_LOGGING_BINARY_ARGUMENT_NONE;
+      break;
+    default:
+      // Includes %n and the end of the format string.
+      return NULL;
+  }
+  // Long doubles and wide characters and strings aren't supported.
+  if (RCUTILS_LOGGING_BINARY_LENGTH_LONG_DOUBLE == spec->length) {
+    return NULL;
+  }
+  if (RCUTILS_LOGGING_BINARY_LENGTH_DEFAULT != spec->length &&
+    (RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR == spec->argument_type ||
+    RCUTILS_LOGGING_BINARY_ARGUMENT_STRING == spec->argument_type ||
+    RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER == spec->argument_type))
+  {
+    return NULL;
+  }
+  return position + 1;
+}
+
+/// Append bytes to an encoded record, growing the scratch buffer if needed.
+typedef struct rcutils_logging_binary_encoder_t
+{
+  char * data;
+  size_t capacity;
+  size_t size;
+} rcutils_logging_binary_encoder_t;
+
+static bool
+__rcutils_logging_binary_encode(
+  rcutils_logging_binary_encoder_t * encoder, const void * data, size_t size)
+{
+  if (encoder->size + size > encoder->capacity) {
+    encoder->data = rcutils_logging_reserve_output_scratch_buffer(
+      encoder->size + size, &encoder->capacity);
+    if (NULL == encoder->data) {
+      return false;
+    }
+  }
+  memcpy(encoder->data + encoder->size, data, size);
+  encoder->size += size;
+  return true;
+}
+
+static bool
+__rcutils_logging_binary_encode_string(
+  rcutils_logging_binary_encoder_t * encoder, const char * string, int precision)
+{
+  uint32_t length = RCUTILS_LOGGING_BINARY_NULL_STRING;
+  if (string) {
+    // With a precision the string doesn't have to be null terminated.
+    size_t string_length = 0;
+    while ((precision < 0 || string_length < (size_t)precision) && string[string_length]) {
+      ++string_length;
+    }
+    if (string_length >= RCUTILS_LOGGING_BINARY_NULL_STRING) {
+      return false;
+    }
+    length = (uint32_t)string_length;
+  }
+  if (!__rcutils_logging_binary_encode(encoder, &length, sizeof(length))) {
+    return false;
+  }
+  return RCUTILS_LOGGING_BINARY_NULL_STRING == length ||
+         __rcutils_logging_binary_encode(encoder, string, length);
+}
+
+/// Encode the arguments of the format string, which must be supported.
+/**
+ * Integers are stored as 64 bit values after applying their length modifier,
+ * `*` widths and precisions as 64 bit values, doubles as they are, pointers as
+ * 64 bit values and strings as their 32 bit length and their characters.
+ */
+static bool
+__rcutils_logging_binary_encode_arguments(
+  rcutils_logging_binary_encoder_t * encoder, const char * format, va_list * args)
+{
+  while (true) {
+    format = strchr(format, '%');
+    if (NULL == format) {
+      return true;
+    }
+    rcutils_logging_binary_spec_t spec;
+    format = __rcutils_logging_binary_parse_spec(format + 1, &spec);
+    if (NULL == format) {
+      return false;
+    }
+    int64_t star_value;
+    if (spec.star_width) {
+      star_value = va_arg(*args, int);
+      if (!__rcutils_logging_binary_encode(encoder, &star_value, sizeof(star_value))) {
+        return false;
+      }
+    }
+    int precision = spec.precision;
+    if (spec.star_precision) {
+      precision = va_arg(*args, int);
+      star_value = precision;
+      if (!__rcutils_logging_binary_encode(encoder, &star_value, sizeof(star_value))) {
+        return false;
+      }
+    }
+    int64_t signed_value;
+    uint64_t unsigned_value;
+    double double_value;
+    bool encoded = true;
+    switch (spec.argument_type) {
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_NONE:
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED:
+        switch (spec.length) {
+          case RCUTILS_LOGGING_BINARY_LENGTH_CHAR:
+            signed_value = (signed char)va_arg(*args, int);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_SHORT:
+            signed_value = (short)va_arg(*args, int);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_LONG:
+            signed_value = va_arg(*args, long);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_LONG_LONG:
+            signed_value = va_arg(*args, long long);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_INTMAX:
+            signed_value = va_arg(*args, intmax_t);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_SIZE:
+            // The signed type corresponding to size_t.
+            signed_value = (ptrdiff_t)va_arg(*args, size_t);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_PTRDIFF:
+            signed_value = va_arg(*args, ptrdiff_t);
+            break;
+          default:
+            signed_value = va_arg(*args, int);
+            break;
+        }
+        encoded = __rcutils_logging_binary_encode(encoder, &signed_value, sizeof(signed_value));
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED:
+        switch (spec.length) {
+          case RCUTILS_LOGGING_BINARY_LENGTH_CHAR:
+            unsigned_value = (unsigned char)va_arg(*args, unsigned int);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_SHORT:
+            unsigned_value = (unsigned short)va_arg(*args, unsigned int);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_LONG:
+            unsigned_value = va_arg(*args, unsigned long);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_LONG_LONG:
+            unsigned_value = va_arg(*args, unsigned long long);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_INTMAX:
+            unsigned_value = va_arg(*args, uintmax_t);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_SIZE:
+            unsigned_value = va_arg(*args, size_t);
+            break;
+          case RCUTILS_LOGGING_BINARY_LENGTH_PTRDIFF:
+            // The unsigned type corresponding to ptrdiff_t.
+            unsigned_value = (size_t)va_arg(*args, ptrdiff_t);
+            break;
+          default:
+            unsigned_value = va_arg(*args, unsigned int);
+            break;
+        }
+        encoded = __rcutils_logging_binary_encode(
+          encoder, &unsigned_value, sizeof(unsigned_value));
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR:
+        signed_value = va_arg(*args, int);
+        encoded = __rcutils_logging_binary_encode(encoder, &signed_value, sizeof(signed_value));
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_DOUBLE:
+        double_value = va_arg(*args, double);
+        encoded = __rcutils_logging_binary_encode(encoder, &double_value, sizeof(double_value));
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_STRING:
+        encoded = __rcutils_logging_binary_encode_string(
+          encoder, va_arg(*args, const char *), precision);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER:
+        unsigned_value = (uintptr_t)va_arg(*args, void *);
+        encoded = __rcutils_logging_binary_encode(
+          encoder, &unsigned_value, sizeof(unsigned_value));
+        break;
+    }
+    if (!encoded) {
+      return false;
+    }
+  }
+}
+
+const char *
+rcutils_logging_binary_encode_message(const char ** format, va_list * args, size_t * size)
+{
+  rcutils_logging_binary_encoder_t encoder = {NULL, 0, 0};
+  va_list args_clone;
+  va_copy(args_clone, *args);
+  bool encoded = __rcutils_logging_binary_encode_arguments(&encoder, *format, &args_clone);
+  va_end(args_clone);
+  if (encoded) {
+    *size = encoder.size;
+    // Messages without arguments don't need the buffer.
+    return encoder.data ? encoder.data : "";
+  }
+
+  // Fall back to formatting the message right away.
+  encoder.size = 0;
+  va_copy(args_clone, *args);
+  int length = vsnprintf(encoder.data, encoder.capacity, *format, args_clone);
+  va_end(args_clone);
+  if (length >= 0 && (size_t)length + 1 > encoder.capacity) {
+    encoder.data = rcutils_logging_reserve_output_scratch_buffer(
+      (size_t)length + 1, &encoder.capacity);
+    if (encoder.data) {
+      va_copy(args_clone, *args);
+      length = vsnprintf(encoder.data, encoder.capacity, *format, args_clone);
+      va_end(args_clone);
+    }
+  }
+  if (length < 0 || NULL == encoder.data) {
+    return NULL;
+  }
+  // Encode the message as a single string argument, its length goes in front of it.
+  uint32_t length32 = (uint32_t)length;
+  encoder.size = (size_t)length;
+  if (!__rcutils_logging_binary_encode(&encoder, &length32, sizeof(length32))) {
+    return NULL;
+  }
+  memmove(encoder.data + sizeof(length32), encoder.data, (size_t)length);
+  memcpy(encoder.data, &length32, sizeof(length32));
+  *size = sizeof(length32) + (size_t)length;
+  *format = "%s";
+  return encoder.data;
+}
+
+// An interned string, the characters are owned by the table.
+typedef struct rcutils_logging_binary_string_t
+{
+  char * string;
+  size_t length;
+  size_t hash;
+  uint32_t id;
+} rcutils_logging_binary_string_t;
+
+// An interned call site, the strings are the ones of the location.
+typedef struct rcutils_logging_binary_call_site_t
+{
+  const rcutils_log_location_t * location;
+  const char * function_name;
+  const char * file_name;
+  size_t line_number;
+  uint32_t id;
+} rcutils_logging_binary_call_site_t;
+
+typedef struct rcutils_logging_binary_t
+{
+  // Protects everything below which isn't atomic.
+  rcutils_mutex_t mutex;
+  FILE * file;
+  char * buffer;
+  size_t buffer_size;
+  size_t buffered;
+  bool write_failure_reported;
+  rcutils_allocator_t allocator;
+
+  // Open addressing hash tables, an id of 0 marks an empty slot.
+  rcutils_logging_binary_string_t * strings;
+  size_t strings_capacity;
+  size_t strings_count;
+  rcutils_logging_binary_call_site_t * call_sites;
+  size_t call_sites_capacity;
+  size_t call_sites_count;
+
+  // Records are only written while this is true.
+  atomic_bool enabled;
+  // The number of threads currently inside the output handler.
+  atomic_size_t active_writers;
+} rcutils_logging_binary_t;
+
+static rcutils_logging_binary_t g_rcutils_logging_binary;
+static bool g_rcutils_logging_binary_opened = false;
+
+rcutils_logging_binary_options_t
+rcutils_logging_binary_get_default_options(void)
+{
+  rcutils_logging_binary_options_t options;
+  options.file_path = NULL;
+  options.buffer_size = 1024 * 1024;
+  options.allocator = rcutils_get_default_allocator();
+  return options;
+}
+
+static void
+__rcutils_logging_binary_report_write_failure(rcutils_logging_binary_t * binary)
+{
+  if (!binary->write_failure_reported) {
+    binary->write_failure_reported = true;
+    fprintf(stderr, "Error: failed to write to the binary log file\n");
+  }
+}
+
+/// Write the buffered entries, the mutex must be held.
+static bool
+__rcutils_logging_binary_flush_locked(rcutils_logging_binary_t * binary)
+{
+  if (0 == binary->buffered || NULL == binary->file) {
+    return true;
+  }
+  size_t buffered = binary->buffered;
+  // The buffered entries are discarded even if writing them failed.
+  binary->buffered = 0;
+  if (fwrite(binary->buffer, 1, buffered, binary->file) != buffered) {
+    __rcutils_logging_binary_report_write_failure(binary);
+    return false;
+  }
+  return true;
+}
+
+/// Add the given bytes to the buffer, the mutex must be held.
+static void
+__rcutils_logging_binary_write_locked(
+  rcutils_logging_binary_t * binary, const void * data, size_t size)
+{
+  if (binary->buffered + size > binary->buffer_size) {
+    __rcutils_logging_binary_flush_locked(binary);
+  }
+  if (size > binary->buffer_size) {
+    // The data doesn't fit into the buffer at all, write it directly.
+    if (binary->file && fwrite(data, 1, size, binary->file) != size) {
+      __rcutils_logging_binary_report_write_failure(binary);
+    }
+    return;
+  }
+  memcpy(binary->buffer + binary->buffered, data, size);
+  binary->buffered += size;
+}
+
+/// Allocate an empty hash table, or return NULL after reporting the failure.
+static void *
+__rcutils_logging_binary_allocate_table(
+  rcutils_logging_binary_t * binary, size_t capacity, size_t entry_size)
+{
+  void * table = binary->allocator.zero_allocate(capacity, entry_size, binary->allocator.state);
+  if (NULL == table) {
+    __rcutils_logging_binary_report_write_failure(binary);
+  }
+  return table;
+}
+
+static bool
+__rcutils_logging_binary_grow_strings_locked(rcutils_logging_binary_t * binary)
+{
+  size_t capacity = binary->strings_capacity * 2;
+  rcutils_logging_binary_string_t * strings = __rcutils_logging_binary_allocate_table(
+    binary, capacity, sizeof(rcutils_logging_binary_string_t));
+  if (NULL == strings) {
+    return false;
+  }
+  for (size_t i = 0; i < binary->strings_capacity; ++i) {
+    rcutils_logging_binary_string_t * entry = &binary->strings[i];
+    if (0 == entry->id) {
+      continue;
+    }
+    size_t slot = entry->hash & (capacity - 1);
+    while (strings[slot].id != 0) {
+      slot = (slot + 1) & (capacity - 1);
+    }
+    strings[slot] = *entry;
+  }
+  binary->allocator.deallocate(binary->strings, binary->allocator.state);
+  binary->strings = strings;
+  binary->strings_capacity = capacity;
+  return true;
+}
+
+/// Return the id of the string, writing it to the file if it is new, or 0 on failure.
+static uint32_t
+__rcutils_logging_binary_intern_string_locked(
+  rcutils_logging_binary_t * binary, const char * string)
+{
+  size_t length = strlen(string);
+  size_t hash = rcutils_hash_string(string, length);
+  size_t slot = hash & (binary->strings_capacity - 1);
+  while (binary->strings[slot].id != 0) {
+    rcutils_logging_binary_string_t * entry = &binary->strings[slot];
+    if (entry->hash == hash && entry->length == length &&
+      memcmp(entry->string, string, length) == 0)
+    {
+      return entry->id;
+    }
+    slot = (slot + 1) & (binary->strings_capacity - 1);
+  }
+  if (length >= UINT32_MAX) {
+    return 0;
+  }
+  // Keep the table at most half full.
+  if ((binary->strings_count + 1) * 2 > binary->strings_capacity) {
+    if (!__rcutils_logging_binary_grow_strings_locked(binary)) {
+      return 0;
+    }
+    slot = hash & (binary->strings_capacity - 1);
+    while (binary->strings[slot].id != 0) {
+      slot = (slot + 1) & (binary->strings_capacity - 1);
+    }
+  }
+  char * copy = rcutils_strdup(string, binary->allocator);
+  if (NULL == copy) {
+    __rcutils_logging_binary_report_write_failure(binary);
+    return 0;
+  }
+  rcutils_logging_binary_string_t * entry = &binary->strings[slot];
+  entry->string = copy;
+  entry->length = length;
+  entry->hash = hash;
+  entry->id = (uint32_t)(binary->strings_count + binary->call_sites_count + 1);
+  ++binary->strings_count;
+
+  char header[RCUTILS_LOGGING_BINARY_STRING_HEADER_SIZE];
+  uint32_t length32 = (uint32_t)length;
+  header[0] = RCUTILS_LOGGING_BINARY_ENTRY_STRING;
+  memcpy(header + 1, &entry->id, 4);
+  memcpy(header + 5, &length32, 4);
+  __rcutils_logging_binary_write_locked(binary, header, sizeof(header));
+  __rcutils_logging_binary_write_locked(binary, string, length);
+  return entry->id;
+}
+
+static size_t
+__rcutils_logging_binary_hash_location(const rcutils_log_location_t * location)
+{
+  uintptr_t address = (uintptr_t)location;
+  return rcutils_hash_string((const char *)&address, sizeof(address));
+}
+
+static bool
+__rcutils_logging_binary_grow_call_sites_locked(rcutils_logging_binary_t * binary)
+{
+  size_t capacity = binary->call_sites_capacity * 2;
+  rcutils_logging_binary_call_site_t * call_sites = __rcutils_logging_binary_allocate_table(
+    binary, capacity, sizeof(rcutils_logging_binary_call_site_t));
+  if (NULL == call_sites) {
+    return false;
+  }
+  for (size_t i = 0; i < binary->call_sites_capacity; ++i) {
+    rcutils_logging_binary_call_site_t * entry = &binary->call_sites[i];
+    if (0 == entry->id) {
+      continue;
+    }
+    size_t slot = __rcutils_logging_binary_hash_location(entry->location) & (capacity - 1);
+    while (call_sites[slot].id != 0) {
+      slot = (slot + 1) & (capacity - 1);
+    }
+    call_sites[slot] = *entry;
+  }
+  binary->allocator.deallocate(binary->call_sites, binary->allocator.state);
+  binary->call_sites = call_sites;
+  binary->call_sites_capacity = capacity;
+  return true;
+}
+
+/// Return the id of the call site, writing it to the file if it is new, or 0 on failure.
+static uint32_t
+__rcutils_logging_binary_intern_call_site_locked(
+  rcutils_logging_binary_t * binary, const rcutils_log_location_t * location)
+{
+  size_t hash = __rcutils_logging_binary_hash_location(location);
+  size_t slot = hash & (binary->call_sites_capacity - 1);
+  while (binary->call_sites[slot].id != 0) {
+    rcutils_logging_binary_call_site_t * entry = &binary->call_sites[slot];
+    // The location struct may be on the stack, so its contents are compared as well.
+    if (entry->location == location && entry->function_name == location->function_name &&
+      entry->file_name == location->file_name && entry->line_number == location->line_number)
+    {
+      return entry->id;
+    }
+    slot = (slot + 1) & (binary->call_sites_capacity - 1);
+  }
+  uint32_t function_name_id = __rcutils_logging_binary_intern_string_locked(
+    binary, location->function_name ? location->function_name : "");
+  uint32_t file_name_id = __rcutils_logging_binary_intern_string_locked(
+    binary, location->file_name ? location->file_name : "");
+  if (0 == function_name_id || 0 == file_name_id) {
+    return 0;
+  }
+  if ((binary->call_sites_count + 1) * 2 > binary->call_sites_capacity) {
+    if (!__rcutils_logging_binary_grow_call_sites_locked(binary)) {
+      return 0;
+    }
+  }
+  // The slot is searched again, a changed location may have reused the address of an old one.
+  slot = hash & (binary->call_sites_capacity - 1);
+  while (binary->call_sites[slot].id != 0) {
+    slot = (slot + 1) & (binary->call_sites_capacity - 1);
+  }
+  rcutils_logging_binary_call_site_t * entry = &binary->call_sites[slot];
+  entry->location = location;
+  entry->function_name = location->function_name;
+  entry->file_name = location->file_name;
+  entry->line_number = location->line_number;
+  entry->id = (uint32_t)(binary->strings_count + binary->call_sites_count + 1);
+  ++binary->call_sites_count;
+
+  char data[RCUTILS_LOGGING_BINARY_CALL_SITE_SIZE];
+  uint64_t line_number = location->line_number;
+  data[0] = RCUTILS_LOGGING_BINARY_ENTRY_CALL_SITE;
+  memcpy(data + 1, &entry->id, 4);
+  memcpy(data + 5, &function_name_id, 4);
+  memcpy(data + 9, &file_name_id, 4);
+  memcpy(data + 13, &line_number, 8);
+  __rcutils_logging_binary_write_locked(binary, data, sizeof(data));
+  return entry->id;
+}
+
+void rcutils_logging_binary_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args)
+{
+  rcutils_logging_binary_t * binary = &g_rcutils_logging_binary;
+  atomic_fetch_add(&binary->active_writers, 1);
+  if (!atomic_load(&binary->enabled)) {
+    atomic_fetch_sub(&binary->active_writers, 1);
+    return;
+  }
+  rcutils_time_point_value_t timestamp;
+  if (rcutils_system_time_now(&timestamp) != RCUTILS_RET_OK) {
+    timestamp = 0;
+  }
+
+  // The arguments are encoded before taking the lock, into a buffer of the calling thread.
+  size_t arguments_size;
+  const char * arguments = rcutils_logging_binary_encode_message(&format, args, &arguments_size);
+  if (NULL == arguments) {
+    fprintf(stderr, "Error: failed to format the binary log message\n");
+    atomic_fetch_sub(&binary->active_writers, 1);
+    return;
+  }
+
+  rcutils_mutex_lock(&binary->mutex);
+  uint32_t name_id = __rcutils_logging_binary_intern_string_locked(binary, name);
+  uint32_t format_id = __rcutils_logging_binary_intern_string_locked(binary, format);
+  uint32_t call_site_id = 0;
+  if (location) {
+    call_site_id = __rcutils_logging_binary_intern_call_site_locked(binary, location);
+  }
+  if (0 == name_id || 0 == format_id || (location && 0 == call_site_id) ||
+    arguments_size > UINT32_MAX)
+  {
+    __rcutils_logging_binary_report_write_failure(binary);
+  } else {
+    char header[RCUTILS_LOGGING_BINARY_RECORD_HEADER_SIZE];
+    int32_t severity32 = severity;
+    uint32_t arguments_size32 = (uint32_t)arguments_size;
+    header[0] = RCUTILS_LOGGING_BINARY_ENTRY_RECORD;
+    memcpy(header + 1, &timestamp, 8);
+    memcpy(header + 9, &severity32, 4);
+    memcpy(header + 13, &name_id, 4);
+    memcpy(header + 17, &call_site_id, 4);
+    memcpy(header + 21, &format_id, 4);
+    memcpy(header + 25, &arguments_size32, 4);
+    __rcutils_logging_binary_write_locked(binary, header, sizeof(header));
+    __rcutils_logging_binary_write_locked(binary, arguments, arguments_size);
+  }
+  rcutils_mutex_unlock(&binary->mutex);
+  rcutils_logging_add_output_volume(RCUTILS_LOGGING_BINARY_RECORD_HEADER_SIZE + arguments_size);
+  atomic_fetch_sub(&binary->active_writers, 1);
+}
+
+static void
+__rcutils_logging_binary_free_tables(rcutils_logging_binary_t * binary)
+{
+  rcutils_allocator_t allocator = binary->allocator;
+  if (binary->strings) {
+    for (size_t i = 0; i < binary->strings_capacity; ++i) {
+      allocator.deallocate(binary->strings[i].string, allocator.state);
+    }
+  }
+  allocator.deallocate(binary->strings, allocator.state);
+  binary->strings = NULL;
+  allocator.deallocate(binary->call_sites, allocator.state);
+  binary->call_sites = NULL;
+  allocator.deallocate(binary->buffer, allocator.state);
+  binary->buffer = NULL;
+}
+
+rcutils_ret_t
+rcutils_logging_binary_open(const rcutils_logging_binary_options_t * options)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(
+    options, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
+  RCUTILS_CHECK_ALLOCATOR_WITH_MSG(
+    &options->allocator, "invalid allocator", return RCUTILS_RET_INVALID_ARGUMENT)
+  rcutils_allocator_t allocator = options->allocator;
+  if (NULL == options->file_path || '\0' == options->file_path[0]) {
+    RCUTILS_SET_ERROR_MSG("invalid file path", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (0 == options->buffer_size) {
+    RCUTILS_SET_ERROR_MSG("invalid buffer size", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (g_rcutils_logging_binary_opened) {
+    RCUTILS_SET_ERROR_MSG("a binary log file is open already", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+
+  rcutils_logging_binary_t * binary = &g_rcutils_logging_binary;
+  binary->allocator = allocator;
+  binary->buffer_size = options->buffer_size;
+  binary->buffered = 0;
+  binary->write_failure_reported = false;
+  binary->strings_capacity = RCUTILS_LOGGING_BINARY_MIN_TABLE_CAPACITY;
+  binary->strings_count = 0;
+  binary->call_sites_capacity = RCUTILS_LOGGING_BINARY_MIN_TABLE_CAPACITY;
+  binary->call_sites_count = 0;
+  binary->buffer = allocator.allocate(options->buffer_size, allocator.state);
+  binary->strings = allocator.zero_allocate(
+    binary->strings_capacity, sizeof(rcutils_logging_binary_string_t), allocator.state);
+  binary->call_sites = allocator.zero_allocate(
+    binary->call_sites_capacity, sizeof(rcutils_logging_binary_call_site_t), allocator.state);
+  if (NULL == binary->buffer || NULL == binary->strings || NULL == binary->call_sites) {
+    __rcutils_logging_binary_free_tables(binary);
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for the binary log file", allocator)
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  if (rcutils_mutex_init(&binary->mutex) != RCUTILS_RET_OK) {
+    __rcutils_logging_binary_free_tables(binary);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the binary log file mutex", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  binary->file = fopen(options->file_path, "wb");
+  if (NULL == binary->file) {
+    rcutils_mutex_fini(&binary->mutex);
+    __rcutils_logging_binary_free_tables(binary);
+    RCUTILS_SET_ERROR_MSG("failed to open the binary log file", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  // The entries are buffered already, so each write should result in a single system call.
+  setvbuf(binary->file, NULL, _IONBF, 0);
+
+  char header[RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4 + 4];
+  uint32_t version = RCUTILS_LOGGING_BINARY_VERSION;
+  uint32_t byte_order_marker = RCUTILS_LOGGING_BINARY_BYTE_ORDER_MARKER;
+  memcpy(header, RCUTILS_LOGGING_BINARY_MAGIC, RCUTILS_LOGGING_BINARY_MAGIC_LENGTH);
+  memcpy(header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH, &version, 4);
+  memcpy(header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4, &byte_order_marker, 4);
+  __rcutils_logging_binary_write_locked(binary, header, sizeof(header));
+
+  atomic_init(&binary->active_writers, 0);
+  g_rcutils_logging_binary_opened = true;
+  atomic_store(&binary->enabled, true);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_binary_flush(void)
+{
+  if (!g_rcutils_logging_binary_opened) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_binary_t * binary = &g_rcutils_logging_binary;
+  rcutils_mutex_lock(&binary->mutex);
+  bool flushed = __rcutils_logging_binary_flush_locked(binary);
+  rcutils_mutex_unlock(&binary->mutex);
+  if (!flushed) {
+    RCUTILS_SET_ERROR_MSG("failed to write to the binary log file", binary->allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_binary_close(void)
+{
+  if (!g_rcutils_logging_binary_opened) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_binary_t * binary = &g_rcutils_logging_binary;
+  rcutils_allocator_t allocator = binary->allocator;
+
+  // Stop accepting records and wait for the ones which are being written.
+  atomic_store(&binary->enabled, false);
+  while (atomic_load(&binary->active_writers) != 0) {
+    rcutils_thread_yield();
+  }
+  g_rcutils_logging_binary_opened = false;
+
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  if (!__rcutils_logging_binary_flush_locked(binary)) {
+    RCUTILS_SET_ERROR_MSG("failed to write to the binary log file", allocator)
+    ret = RCUTILS_RET_ERROR;
+  }
+  if (fclose(binary->file) != 0) {
+    RCUTILS_SET_ERROR_MSG("failed to close the binary log file", allocator)
+    ret = RCUTILS_RET_ERROR;
+  }
+  binary->file = NULL;
+  rcutils_mutex_fini(&binary->mutex);
+  __rcutils_logging_binary_free_tables(binary);
+  return ret;
+}
+
+// A growable buffer the decoder renders messages into.
+typedef struct rcutils_logging_binary_text_t
+{
+  char * data;
+  size_t capacity;
+  size_t length;
+  rcutils_allocator_t allocator;
+} rcutils_logging_binary_text_t;
+
+static bool
+__rcutils_logging_binary_text_reserve(rcutils_logging_binary_text_t * text, size_t size)
+{
+  if (text->length + size + 1 <= text->capacity) {
+    return true;
+  }
+  size_t capacity = text->capacity ? text->capacity : 256;
+  while (capacity < text->length + size + 1) {
+    capacity *= 2;
+  }
+  char * data = text->allocator.reallocate(text->data, capacity, text->allocator.state);
+  if (NULL == data) {
+    return false;
+  }
+  text->data = data;
+  text->capacity = capacity;
+  return true;
+}
+
+static bool
+__rcutils_logging_binary_text_append(
+  rcutils_logging_binary_text_t * text, const char * string, size_t length)
+{
+  if (!__rcutils_logging_binary_text_reserve(text, length)) {
+    return false;
+  }
+  memcpy(text->data + text->length, string, length);
+  text->length += length;
+  text->data[text->length] = '\0';
+  return true;
+}
+
+// The arguments of a record which are consumed while decoding it.
+typedef struct rcutils_logging_binary_decoder_t
+{
+  const char * data;
+  size_t size;
+} rcutils_logging_binary_decoder_t;
+
+static bool
+__rcutils_logging_binary_decode(rcutils_logging_binary_decoder_t * decoder, void * data, size_t size)
+{
+  if (decoder->size < size) {
+    return false;
+  }
+  memcpy(data, decoder->data, size);
+  decoder->data += size;
+  decoder->size -= size;
+  return true;
+}
+
+/// Append a width or precision to a conversion specification.
+/**
+ * \param capacity The number of characters which can be used, including the null terminator.
+ * \return false if the number doesn't fit.
+ */
+static bool
+__rcutils_logging_binary_append_spec_number(
+  char * spec_format, size_t capacity, size_t * spec_length, int64_t value)
+{
+  int written = snprintf(
+    spec_format + *spec_length, capacity - *spec_length, "%lld", (long long)value);
+  if (written < 0 || (size_t)written >= capacity - *spec_length) {
+    return false;
+  }
+  *spec_length += (size_t)written;
+  return true;
+}
+
+/// Append the conversion specification with its argument to the message.
+static bool
+__rcutils_logging_binary_decode_spec(
+  const rcutils_logging_binary_spec_t * spec,
+  rcutils_logging_binary_decoder_t * decoder, rcutils_logging_binary_text_t * text)
+{
+  // The specification is rebuilt with the values of '*' and a length modifier for 64 bit values.
+  char spec_format[128];
+  // The length modifier and the conversion are appended after the options.
+  const size_t spec_capacity = sizeof(spec_format) - 3;
+  size_t spec_length = 0;
+  int64_t width = 0;
+  int64_t precision = -1;
+  if (spec->star_width && !__rcutils_logging_binary_decode(decoder, &width, sizeof(width))) {
+    return false;
+  }
+  if (spec->star_precision &&
+    !__rcutils_logging_binary_decode(decoder, &precision, sizeof(precision)))
+  {
+    return false;
+  }
+  // The values were passed as int, but the file might not have been written by the encoder.
+  if (width < -INT_MAX || width > INT_MAX) {
+    width = width < 0 ? -INT_MAX : INT_MAX;
+  }
+  if (precision > INT_MAX) {
+    precision = INT_MAX;
+  }
+  if (spec->options_length + 1 >= spec_capacity) {
+    return false;
+  }
+  spec_format[spec_length++] = '%';
+  bool in_precision = false;
+  for (size_t i = 0; i < spec->options_length; ++i) {
+    char c = spec->options[i];
+    if ('*' != c) {
+      in_precision = in_precision || '.' == c;
+      if (spec_length + 1 >= spec_capacity) {
+        return false;
+      }
+      spec_format[spec_length++] = c;
+    } else if (!in_precision) {
+      // A negative width is taken as the '-' flag.
+      if (width < 0) {
+        if (spec_length + 1 >= spec_capacity) {
+          return false;
+        }
+        spec_format[spec_length++] = '-';
+        width = -width;
+      }
+      if (!__rcutils_logging_binary_append_spec_number(
+          spec_format, spec_capacity, &spec_length, width))
+      {
+        return false;
+      }
+    } else if (precision >= 0) {
+      if (!__rcutils_logging_binary_append_spec_number(
+          spec_format, spec_capacity, &spec_length, precision))
+      {
+        return false;
+      }
+    } else {
+      // A negative precision is taken as if it was omitted.
+      --spec_length;
+    }
+  }
+  if (RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED == spec->argument_type ||
+    RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED == spec->argument_type)
+  {
+    spec_format[spec_length++] = 'l';
+    spec_format[spec_length++] = 'l';
+  }
+  spec_format[spec_length++] = spec->conversion;
+  spec_format[spec_length] = '\0';
+
+  int64_t signed_value = 0;
+  uint64_t unsigned_value = 0;
+  double double_value = 0.0;
+  uint32_t string_length = 0;
+  const char * string = NULL;
+  char * string_copy = NULL;
+  switch (spec->argument_type) {
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_NONE:
+      return __rcutils_logging_binary_text_append(text, "%", 1);
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED:
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR:
+      if (!__rcutils_logging_binary_decode(decoder, &signed_value, sizeof(signed_value))) {
+        return false;
+      }
+      break;
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED:
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER:
+      if (!__rcutils_logging_binary_decode(decoder, &unsigned_value, sizeof(unsigned_value))) {
+        return false;
+      }
+      break;
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_DOUBLE:
+      if (!__rcutils_logging_binary_decode(decoder, &double_value, sizeof(double_value))) {
+        return false;
+      }
+      break;
+    case RCUTILS_LOGGING_BINARY_ARGUMENT_STRING:
+      if (!__rcutils_logging_binary_decode(decoder, &string_length, sizeof(string_length))) {
+        return false;
+      }
+      if (RCUTILS_LOGGING_BINARY_NULL_STRING == string_length) {
+        string = "(null)";
+        break;
+      }
+      if (decoder->size < string_length) {
+        return false;
+      }
+      string_copy = text->allocator.allocate(string_length + 1u, text->allocator.state);
+      if (NULL == string_copy) {
+        return false;
+      }
+      memcpy(string_copy, decoder->data, string_length);
+      string_copy[string_length] = '\0';
+      decoder->data += string_length;
+      decoder->size -= string_length;
+      string = string_copy;
+      break;
+  }
+
+  // Format the specification into the text, growing it once if needed.
+  bool formatted = false;
+  size_t available = text->capacity - text->length;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    char * destination = text->data ? text->data + text->length : NULL;
+    int length = -1;
+    switch (spec->argument_type) {
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_SIGNED:
+        length = snprintf(destination, available, spec_format, (long long)signed_value);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_CHAR:
+        length = snprintf(destination, available, spec_format, (int)signed_value);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_UNSIGNED:
+        length = snprintf(destination, available, spec_format, (unsigned long long)unsigned_value);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_POINTER:
+        length = snprintf(
+          destination, available, spec_format, (void *)(uintptr_t)unsigned_value);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_DOUBLE:
+        length = snprintf(destination, available, spec_format, double_value);
+        break;
+      case RCUTILS_LOGGING_BINARY_ARGUMENT_STRING:
+        length = snprintf(destination, available, spec_format, string);
+        break;
+      default:
+        break;
+    }
+    if (length < 0) {
+      break;
+    }
+    if ((size_t)length < available) {
+      text->length += (size_t)length;
+      formatted = true;
+      break;
+    }
+    if (!__rcutils_logging_binary_text_reserve(text, (size_t)length)) {
+      break;
+    }
+    available = text->capacity - text->length;
+  }
+  text->allocator.deallocate(string_copy, text->allocator.state);
+  return formatted;
+}
+
+/// Render the message of a record from its format string and encoded arguments.
+static bool
+__rcutils_logging_binary_decode_message(
+  const char * format, rcutils_logging_binary_decoder_t * decoder,
+  rcutils_logging_binary_text_t * text)
+{
+  while (true) {
+    const char * next = strchr(format, '%');
+    size_t literal_length = next ? (size_t)(next - format) : strlen(format);
+    if (!__rcutils_logging_binary_text_append(text, format, literal_length)) {
+      return false;
+    }
+    if (NULL == next) {
+      return true;
+    }
+    rcutils_logging_binary_spec_t spec;
+    format = __rcutils_logging_binary_parse_spec(next + 1, &spec);
+    if (NULL == format || !__rcutils_logging_binary_decode_spec(&spec, decoder, text)) {
+      return false;
+    }
+  }
+}
+
+// The strings and call sites read from a binary log file, indexed by their id.
+typedef struct rcutils_logging_binary_entries_t
+{
+  char ** strings;
+  // Call sites store the ids of their function and file name and their line number.
+  uint64_t (* call_sites)[3];
+  size_t capacity;
+  rcutils_allocator_t allocator;
+} rcutils_logging_binary_entries_t;
+
+static bool
+__rcutils_logging_binary_entries_reserve(rcutils_logging_binary_entries_t * entries, uint32_t id)
+{
+  if (id < entries->capacity) {
+    return true;
+  }
+  size_t capacity = entries->capacity ? entries->capacity : 64;
+  while (capacity <= id) {
+    capacity *= 2;
+  }
+  rcutils_allocator_t allocator = entries->allocator;
+  char ** strings = allocator.zero_allocate(capacity, sizeof(char *), allocator.state);
+  uint64_t (* call_sites)[3] = allocator.zero_allocate(
+    capacity, sizeof(*call_sites), allocator.state);
+  if (NULL == strings || NULL == call_sites) {
+    allocator.deallocate(strings, allocator.state);
+    allocator.deallocate(call_sites, allocator.state);
+    return false;
+  }
+  if (entries->capacity) {
+    memcpy(strings, entries->strings, entries->capacity * sizeof(char *));
+    memcpy(call_sites, entries->call_sites, entries->capacity * sizeof(*call_sites));
+  }
+  allocator.deallocate(entries->strings, allocator.state);
+  allocator.deallocate(entries->call_sites, allocator.state);
+  entries->strings = strings;
+  entries->call_sites = call_sites;
+  entries->capacity = capacity;
+  return true;
+}
+
+static const char *
+__rcutils_logging_binary_entries_string(rcutils_logging_binary_entries_t * entries, uint64_t id)
+{
+  return id < entries->capacity ? entries->strings[id] : NULL;
+}
+
+static rcutils_ret_t
+__rcutils_logging_binary_decode_entries(
+  FILE * input, FILE * output, bool with_location, rcutils_logging_binary_entries_t * entries,
+  rcutils_logging_binary_text_t * text)
+{
+  rcutils_allocator_t allocator = entries->allocator;
+  char header[RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4 + 4];
+  uint32_t version;
+  uint32_t byte_order_marker;
+  if (fread(header, 1, sizeof(header), input) != sizeof(header) ||
+    memcmp(header, RCUTILS_LOGGING_BINARY_MAGIC, RCUTILS_LOGGING_BINARY_MAGIC_LENGTH) != 0)
+  {
+    RCUTILS_SET_ERROR_MSG("not a binary log file", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  memcpy(&version, header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH, 4);
+  memcpy(&byte_order_marker, header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4, 4);
+  if (byte_order_marker != RCUTILS_LOGGING_BINARY_BYTE_ORDER_MARKER) {
+    RCUTILS_SET_ERROR_MSG("the binary log file was written with a different byte order", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  if (version != RCUTILS_LOGGING_BINARY_VERSION) {
+    RCUTILS_SET_ERROR_MSG("unsupported binary log file version", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+
+  // The end of the file bounds the lengths of the strings, unless the input can't seek.
+  long end = -1;
+  long position = ftell(input);
+  if (position >= 0 && fseek(input, 0, SEEK_END) == 0) {
+    end = ftell(input);
+    if (fseek(input, position, SEEK_SET) != 0) {
+      RCUTILS_SET_ERROR_MSG("failed to seek in the binary log file", allocator)
+      return RCUTILS_RET_ERROR;
+    }
+  }
+
+  char * arguments = NULL;
+  size_t arguments_capacity = 0;
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  int type;
+  while (RCUTILS_RET_OK == ret && (type = fgetc(input)) != EOF) {
+    if (RCUTILS_LOGGING_BINARY_ENTRY_STRING == type) {
+      uint32_t values[2];
+      if (fread(values, 4, 2, input) != 2) {
+        break;
+      }
+      if (0 == values[0] || RCUTILS_LOGGING_BINARY_NULL_STRING == values[1] ||
+        (end >= 0 && (position = ftell(input)) >= 0 && values[1] > (uint64_t)(end - position)))
+      {
+        RCUTILS_SET_ERROR_MSG("the binary log file contains an invalid string", allocator)
+        ret = RCUTILS_RET_ERROR;
+        break;
+      }
+      if (!__rcutils_logging_binary_entries_reserve(entries, values[0])) {
+        ret = RCUTILS_RET_BAD_ALLOC;
+        break;
+      }
+      char * string = allocator.allocate((size_t)values[1] + 1, allocator.state);
+      if (NULL == string) {
+        ret = RCUTILS_RET_BAD_ALLOC;
+        break;
+      }
+      if (fread(string, 1, values[1], input) != values[1]) {
+        allocator.deallocate(string, allocator.state);
+        break;
+      }
+      string[values[1]] = '\0';
+      allocator.deallocate(entries->strings[values[0]], allocator.state);
+      entries->strings[values[0]] = string;
+    } else if (RCUTILS_LOGGING_BINARY_ENTRY_CALL_SITE == type) {
+      uint32_t ids[3];
+      uint64_t line_number;
+      if (fread(ids, 4, 3, input) != 3 || fread(&line_number, 8, 1, input) != 1) {
+        break;
+      }
+      if (0 == ids[0]) {
+        RCUTILS_SET_ERROR_MSG("the binary log file contains an invalid call site", allocator)
+        ret = RCUTILS_RET_ERROR;
+        break;
+      }
+      if (!__rcutils_logging_binary_entries_reserve(entries, ids[0])) {
+        ret = RCUTILS_RET_BAD_ALLOC;
+        break;
+      }
+      entries->call_sites[ids[0]][0] = ids[1];
+      entries->call_sites[ids[0]][1] = ids[2];
+      entries->call_sites[ids[0]][2] = line_number;
+    } else if (RCUTILS_LOGGING_BINARY_ENTRY_RECORD == type) {
+      char record[RCUTILS_LOGGING_BINARY_RECORD_HEADER_SIZE - 1];
+      if (fread(record, 1, sizeof(record), input) != sizeof(record)) {
+        break;
+      }
+      int64_t timestamp;
+      int32_t severity;
+      uint32_t name_id, call_site_id, format_id, arguments_size;
+      memcpy(&timestamp, record, 8);
+      memcpy(&severity, record + 8, 4);
+      memcpy(&name_id, record + 12, 4);
+      memcpy(&call_site_id, record + 16, 4);
+      memcpy(&format_id, record + 20, 4);
+      memcpy(&arguments_size, record + 24, 4);
+      if (arguments_size > arguments_capacity) {
+        char * new_arguments = allocator.reallocate(arguments, arguments_size, allocator.state);
+        if (NULL == new_arguments) {
+          ret = RCUTILS_RET_BAD_ALLOC;
+          break;
+        }
+        arguments = new_arguments;
+        arguments_capacity = arguments_size;
+      }
+      if (fread(arguments, 1, arguments_size, input) != arguments_size) {
+        break;
+      }
+      const char * name = __rcutils_logging_binary_entries_string(entries, name_id);
+      const char * format = __rcutils_logging_binary_entries_string(entries, format_id);
+      if (NULL == name || NULL == format) {
+        RCUTILS_SET_ERROR_MSG("a record references an unknown string", allocator)
+        ret = RCUTILS_RET_ERROR;
+        break;
+      }
+      const char * severity_string = "UNKNOWN";
+      if (severity >= 0 && severity <= RCUTILS_LOG_SEVERITY_FATAL &&
+        g_rcutils_log_severity_names[severity])
+      {
+        severity_string = g_rcutils_log_severity_names[severity];
+      }
+      rcutils_logging_binary_decoder_t decoder = {arguments, arguments_size};
+      text->length = 0;
+      if (!__rcutils_logging_binary_text_append(text, "", 0) ||
+        !__rcutils_logging_binary_decode_message(format, &decoder, text))
+      {
+        RCUTILS_SET_ERROR_MSG("failed to decode the message of a record", allocator)
+        ret = RCUTILS_RET_ERROR;
+        break;
+      }
+      int64_t seconds = timestamp / RCUTILS_S_TO_NS(1);
+      int64_t nanoseconds = timestamp % RCUTILS_S_TO_NS(1);
+      if (nanoseconds < 0) {
+        --seconds;
+        nanoseconds += RCUTILS_S_TO_NS(1);
+      }
+      int written = fprintf(
+        output, "[%s] [%lld.%09lld] [%s]: %s", severity_string, (long long)seconds,
+        (long long)nanoseconds, name, text->data);
+      if (written >= 0 && with_location && call_site_id != 0) {
+        const char * function_name = NULL;
+        const char * file_name = NULL;
+        uint64_t line_number = 0;
+        if (call_site_id < entries->capacity) {
+          function_name = __rcutils_logging_binary_entries_string(
+            entries, entries->call_sites[call_site_id][0]);
+          file_name = __rcutils_logging_binary_entries_string(
+            entries, entries->call_sites[call_site_id][1]);
+          line_number = entries->call_sites[call_site_id][2];
+        }
+        if (NULL == function_name || NULL == file_name) {
+          RCUTILS_SET_ERROR_MSG("a record references an unknown call site", allocator)
+          ret = RCUTILS_RET_ERROR;
+          break;
+        }
+        written = fprintf(
+          output, " (%s() at %s:%llu)", function_name, file_name,
+          (unsigned long long)line_number);
+      }
+      if (written < 0 || fputc('\n', output) == EOF) {
+        RCUTILS_SET_ERROR_MSG("failed to write the decoded records", allocator)
+        ret = RCUTILS_RET_ERROR;
+      }
+    } else {
+      RCUTILS_SET_ERROR_MSG("the binary log file contains an unknown entry", allocator)
+      ret = RCUTILS_RET_ERROR;
+    }
+  }
+  // The last entry may be incomplete if the process was killed while logging.
+  if (RCUTILS_RET_BAD_ALLOC == ret) {
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for decoding the binary log file", allocator)
+  }
+  allocator.deallocate(arguments, allocator.state);
+  return ret;
+}
+
+rcutils_ret_t
+rcutils_logging_binary_decode(
+  FILE * input, FILE * output, bool with_location, rcutils_allocator_t allocator)
+{
+  RCUTILS_CHECK_ALLOCATOR_WITH_MSG(
+    &allocator, "invalid allocator", return RCUTILS_RET_INVALID_ARGUMENT)
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(input, RCUTILS_RET_INVALID_ARGUMENT, allocator)
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(output, RCUTILS_RET_INVALID_ARGUMENT, allocator)
+
+  rcutils_logging_binary_entries_t entries = {NULL, NULL, 0, allocator};
+  rcutils_logging_binary_text_t text = {NULL, 0, 0, allocator};
+  rcutils_ret_t ret = __rcutils_logging_binary_decode_entries(
+    input, output, with_location, &entries, &text);
+  for (size_t i = 0; i < entries.capacity; ++i) {
+    allocator.deallocate(entries.strings[i], allocator.state);
+  }
+  allocator.deallocate(entries.strings, allocator.state);
+  allocator.deallocate(entries.call_sites, allocator.state);
+  allocator.deallocate(text.data, allocator.state);
+  return ret;
+}
+
+#if __cplusplus
+}
+#endif
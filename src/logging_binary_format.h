@@ -0,0 +1,71 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOGGING_BINARY_FORMAT_H_
+#define LOGGING_BINARY_FORMAT_H_
+
+// The format of binary log files, shared by the writers of such files.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "rcutils/visibility_control.h"
+
+// The file starts with the magic, the version and a marker to detect the byte order.
+// All values are stored in the byte order of the machine which wrote the file.
+#define RCUTILS_LOGGING_BINARY_MAGIC "RCUTILSB"
+#define RCUTILS_LOGGING_BINARY_MAGIC_LENGTH 8
+#define RCUTILS_LOGGING_BINARY_VERSION 1u
+#define RCUTILS_LOGGING_BINARY_BYTE_ORDER_MARKER 0x01020304u
+
+// The header is followed by entries, each starting with one byte for its type.
+// A string: u32 id, u32 length, the characters without a null terminator.
+#define RCUTILS_LOGGING_BINARY_ENTRY_STRING 1
+// A call site: u32 id, u32 id of the function name, u32 id of the file name, u64 line number.
+#define RCUTILS_LOGGING_BINARY_ENTRY_CALL_SITE 2
+// A record: i64 timestamp, i32 severity, u32 id of the logger name, u32 id of the call site
+// or 0, u32 id of the format string, u32 size of the arguments, the encoded arguments.
+#define RCUTILS_LOGGING_BINARY_ENTRY_RECORD 3
+
+#define RCUTILS_LOGGING_BINARY_STRING_HEADER_SIZE (1 + 4 + 4)
+#define RCUTILS_LOGGING_BINARY_CALL_SITE_SIZE (1 + 4 + 4 + 4 + 8)
+#define RCUTILS_LOGGING_BINARY_RECORD_HEADER_SIZE (1 + 8 + 4 + 4 + 4 + 4 + 4)
+
+/// Encode the arguments of a message the way they are stored in a record.
+/**
+ * The arguments are encoded into the output scratch buffer of the calling
+ * thread, which is only valid until the next use on the same thread.
+ * If the format string isn't supported, the message is formatted right away
+ * and encoded as the only argument of the format `"%s"`, which is stored in
+ * `format` instead.
+ *
+ * \param format The format string, which may be replaced by `"%s"`.
+ * \param args The arguments of the format string, which are not consumed.
+ * \param size The size of the encoded arguments is stored here.
+ * \return the encoded arguments, or NULL if formatting or allocating memory failed.
+ */
+RCUTILS_LOCAL
+const char *
+rcutils_logging_binary_encode_message(const char ** format, va_list * args, size_t * size);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // LOGGING_BINARY_FORMAT_H_
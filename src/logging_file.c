@@ -0,0 +1,462 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "./logging_output.h"
+#include "./stdatomic_helper.h"
+#include "./thread_helper.h"
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/format_string.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_file.h"
+#include "rcutils/strdup.h"
+#include "rcutils/time.h"
+
+// How long output lines are dropped after reopening the file failed, before it's tried again.
+#define RCUTILS_LOGGING_FILE_REOPEN_PERIOD_NS (100 * 1000 * 1000)
+
+typedef struct rcutils_logging_file_t
+{
+  // Protects everything below which isn't atomic.
+  rcutils_mutex_t mutex;
+  // Signaled when output lines are buffered or flushed and when closing, for the flush thread.
+  rcutils_condition_t condition;
+  FILE * file;
+  char * file_path;
+  // The number of bytes written to the current file, not including the buffered ones.
+  size_t file_size;
+  char * buffer;
+  size_t buffer_size;
+  size_t buffered;
+  // When the first of the currently buffered output lines was logged.
+  rcutils_time_point_value_t first_buffered_time;
+  bool write_failure_reported;
+  // When reopening the file failed the last time, while the file is NULL.
+  rcutils_time_point_value_t reopen_failure_time;
+
+  int64_t flush_period_ns;
+  int flush_severity;
+  size_t max_file_size;
+  size_t max_rotated_files;
+  rcutils_allocator_t allocator;
+
+  // Output lines are only written while this is true.
+  atomic_bool enabled;
+  // The number of threads currently inside the output handler.
+  atomic_size_t active_writers;
+  // The flush thread keeps running while this is true.
+  atomic_bool running;
+  bool has_flush_thread;
+  rcutils_thread_t flush_thread;
+} rcutils_logging_file_t;
+
+static rcutils_logging_file_t g_rcutils_logging_file;
+static bool g_rcutils_logging_file_opened = false;
+
+rcutils_logging_file_options_t
+rcutils_logging_file_get_default_options(void)
+{
+  rcutils_logging_file_options_t options;
+  options.file_path = NULL;
+  options.buffer_size = 1024 * 1024;
+  options.flush_period_ns = RCUTILS_S_TO_NS(1);
+  options.flush_severity = RCUTILS_LOG_SEVERITY_ERROR;
+  options.max_file_size = 100 * 1024 * 1024;
+  options.max_rotated_files = 5;
+  options.allocator = rcutils_get_default_allocator();
+  return options;
+}
+
+/// Open the log file for appending, without any buffering by stdio.
+static bool
+__rcutils_logging_file_open_file(rcutils_logging_file_t * file)
+{
+  file->file = fopen(file->file_path, "ab");
+  if (NULL == file->file) {
+    return false;
+  }
+  // The output lines are buffered already, so each write should result in a single system call.
+  setvbuf(file->file, NULL, _IONBF, 0);
+  file->file_size = 0;
+  if (fseek(file->file, 0, SEEK_END) == 0) {
+    long position = ftell(file->file);
+    if (position > 0) {
+      file->file_size = (size_t)position;
+    }
+  }
+  return true;
+}
+
+static void
+__rcutils_logging_file_report_write_failure(rcutils_logging_file_t * file)
+{
+  if (!file->write_failure_reported) {
+    file->write_failure_reported = true;
+    fprintf(stderr, "Error: failed to write to the log file [%s]\n", file->file_path);
+  }
+}
+
+/// Write the buffered output lines, the mutex must be held.
+static bool
+__rcutils_logging_file_flush_locked(rcutils_logging_file_t * file)
+{
+  if (0 == file->buffered) {
+    return true;
+  }
+  size_t buffered = file->buffered;
+  // The buffered output lines are discarded even if writing them failed.
+  file->buffered = 0;
+  if (file->has_flush_thread) {
+    rcutils_condition_signal(&file->condition);
+  }
+  if (NULL == file->file) {
+    __rcutils_logging_file_report_write_failure(file);
+    return false;
+  }
+  size_t written = fwrite(file->buffer, 1, buffered, file->file);
+  file->file_size += written;
+  if (written != buffered) {
+    __rcutils_logging_file_report_write_failure(file);
+    return false;
+  }
+  return true;
+}
+
+/// Rename the log file and the rotated files to the next number and start a new file.
+static void
+__rcutils_logging_file_rotate_locked(rcutils_logging_file_t * file)
+{
+  if (file->file) {
+    fclose(file->file);
+    file->file = NULL;
+  }
+  rcutils_allocator_t allocator = file->allocator;
+  if (0 == file->max_rotated_files) {
+    remove(file->file_path);
+  } else {
+    char * oldest_path = rcutils_format_string(
+      allocator, "%s.%zu", file->file_path, file->max_rotated_files);
+    if (oldest_path) {
+      remove(oldest_path);
+      allocator.deallocate(oldest_path, allocator.state);
+    }
+    for (size_t i = file->max_rotated_files - 1; i > 0; --i) {
+      char * from_path = rcutils_format_string(allocator, "%s.%zu", file->file_path, i);
+      char * to_path = rcutils_format_string(allocator, "%s.%zu", file->file_path, i + 1);
+      if (from_path && to_path) {
+        rename(from_path, to_path);
+      }
+      allocator.deallocate(from_path, allocator.state);
+      allocator.deallocate(to_path, allocator.state);
+    }
+    char * newest_path = rcutils_format_string(allocator, "%s.1", file->file_path);
+    if (newest_path) {
+      rename(file->file_path, newest_path);
+      allocator.deallocate(newest_path, allocator.state);
+    }
+  }
+  if (!__rcutils_logging_file_open_file(file)) {
+    __rcutils_logging_file_report_write_failure(file);
+    // The output lines are dropped until the file can be opened again.
+    file->file_size = 0;
+    if (rcutils_steady_time_now(&file->reopen_failure_time) != RCUTILS_RET_OK) {
+      file->reopen_failure_time = 0;
+    }
+  }
+}
+
+/// Open the file again if it couldn't be reopened and enough time has passed since.
+/**
+ * \return true if the file is open, false if the output line should be dropped.
+ */
+static bool
+__rcutils_logging_file_reopen_locked(rcutils_logging_file_t * file)
+{
+  if (file->file) {
+    return true;
+  }
+  rcutils_time_point_value_t now;
+  if (rcutils_steady_time_now(&now) != RCUTILS_RET_OK ||
+    now - file->reopen_failure_time < RCUTILS_LOGGING_FILE_REOPEN_PERIOD_NS)
+  {
+    return false;
+  }
+  if (!__rcutils_logging_file_open_file(file)) {
+    file->file_size = 0;
+    file->reopen_failure_time = now;
+    return false;
+  }
+  return true;
+}
+
+/// Add an output line and its newline, the mutex must be held.
+static void
+__rcutils_logging_file_append_locked(
+  rcutils_logging_file_t * file, int severity, const char * line, size_t line_length)
+{
+  if (!__rcutils_logging_file_reopen_locked(file)) {
+    return;
+  }
+  size_t length = line_length + 1;
+  if (file->max_file_size > 0 && file->file_size + file->buffered > 0 &&
+    file->file_size + file->buffered + length > file->max_file_size)
+  {
+    __rcutils_logging_file_flush_locked(file);
+    __rcutils_logging_file_rotate_locked(file);
+    if (NULL == file->file) {
+      return;
+    }
+  }
+  if (file->buffered + length > file->buffer_size) {
+    __rcutils_logging_file_flush_locked(file);
+  }
+  if (length > file->buffer_size) {
+    // The output line doesn't fit into the buffer at all, write it directly.
+    if (file->file) {
+      size_t written = fwrite(line, 1, line_length, file->file);
+      written += fwrite("\n", 1, 1, file->file);
+      file->file_size += written;
+      if (written != length) {
+        __rcutils_logging_file_report_write_failure(file);
+      }
+    }
+    return;
+  }
+  if (0 == file->buffered && file->has_flush_thread) {
+    if (rcutils_steady_time_now(&file->first_buffered_time) != RCUTILS_RET_OK) {
+      file->first_buffered_time = 0;
+    }
+    rcutils_condition_signal(&file->condition);
+  }
+  memcpy(file->buffer + file->buffered, line, line_length);
+  file->buffer[file->buffered + line_length] = '\n';
+  file->buffered += length;
+  if (severity >= file->flush_severity) {
+    __rcutils_logging_file_flush_locked(file);
+  }
+}
+
+static void
+__rcutils_logging_file_flush_periodically(void * arg)
+{
+  rcutils_logging_file_t * file = (rcutils_logging_file_t *)arg;
+  rcutils_mutex_lock(&file->mutex);
+  while (atomic_load(&file->running)) {
+    if (0 == file->buffered) {
+      // Wait until an output line is buffered or the file is closed.
+      rcutils_condition_wait(&file->condition, &file->mutex);
+      continue;
+    }
+    int64_t remaining_ns = file->flush_period_ns;
+    rcutils_time_point_value_t now;
+    if (rcutils_steady_time_now(&now) == RCUTILS_RET_OK) {
+      remaining_ns = file->first_buffered_time + file->flush_period_ns - now;
+    }
+    if (remaining_ns > 0) {
+      // The buffered output lines may also be flushed in the meantime, which signals.
+      rcutils_condition_timed_wait_ns(&file->condition, &file->mutex, remaining_ns);
+      continue;
+    }
+    __rcutils_logging_file_flush_locked(file);
+  }
+  rcutils_mutex_unlock(&file->mutex);
+}
+
+void rcutils_logging_file_output_handler(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args)
+{
+  rcutils_logging_file_t * file = &g_rcutils_logging_file;
+  atomic_fetch_add(&file->active_writers, 1);
+  if (!atomic_load(&file->enabled)) {
+    atomic_fetch_sub(&file->active_writers, 1);
+    return;
+  }
+  // The output line is rendered before taking the lock, into a buffer of the calling thread.
+  const char * line = NULL;
+  size_t line_length = 0;
+  if (rcutils_logging_render_output_line(
+      location, severity, name, format, args, &line, &line_length))
+  {
+    rcutils_mutex_lock(&file->mutex);
+    __rcutils_logging_file_append_locked(file, severity, line, line_length);
+    rcutils_mutex_unlock(&file->mutex);
+    rcutils_logging_add_output_volume(line_length + 1);
+  }
+  atomic_fetch_sub(&file->active_writers, 1);
+}
+
+rcutils_ret_t
+rcutils_logging_file_open(const rcutils_logging_file_options_t * options)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(
+    options, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
+  RCUTILS_CHECK_ALLOCATOR_WITH_MSG(
+    &options->allocator, "invalid allocator", return RCUTILS_RET_INVALID_ARGUMENT)
+  rcutils_allocator_t allocator = options->allocator;
+  if (NULL == options->file_path || '\0' == options->file_path[0]) {
+    RCUTILS_SET_ERROR_MSG("invalid file path", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (0 == options->buffer_size) {
+    RCUTILS_SET_ERROR_MSG("invalid buffer size", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (options->flush_period_ns < 0) {
+    RCUTILS_SET_ERROR_MSG("invalid flush period", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (g_rcutils_logging_file_opened) {
+    RCUTILS_SET_ERROR_MSG("a log file is open already", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+
+  rcutils_logging_file_t * file = &g_rcutils_logging_file;
+  file->allocator = allocator;
+  file->buffer_size = options->buffer_size;
+  file->buffered = 0;
+  file->first_buffered_time = 0;
+  file->write_failure_reported = false;
+  file->reopen_failure_time = 0;
+  file->flush_period_ns = options->flush_period_ns;
+  file->flush_severity = options->flush_severity;
+  file->max_file_size = options->max_file_size;
+  file->max_rotated_files = options->max_rotated_files;
+  file->has_flush_thread = options->flush_period_ns > 0;
+  file->file_path = rcutils_strdup(options->file_path, allocator);
+  file->buffer = allocator.allocate(options->buffer_size, allocator.state);
+  if (NULL == file->file_path || NULL == file->buffer) {
+    allocator.deallocate(file->file_path, allocator.state);
+    allocator.deallocate(file->buffer, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for the log file buffer", allocator)
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  if (rcutils_mutex_init(&file->mutex) != RCUTILS_RET_OK) {
+    allocator.deallocate(file->file_path, allocator.state);
+    allocator.deallocate(file->buffer, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the log file mutex", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  if (rcutils_condition_init(&file->condition) != RCUTILS_RET_OK) {
+    rcutils_mutex_fini(&file->mutex);
+    allocator.deallocate(file->file_path, allocator.state);
+    allocator.deallocate(file->buffer, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to initialize the log file condition", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  if (!__rcutils_logging_file_open_file(file)) {
+    rcutils_condition_fini(&file->condition);
+    rcutils_mutex_fini(&file->mutex);
+    allocator.deallocate(file->file_path, allocator.state);
+    allocator.deallocate(file->buffer, allocator.state);
+    RCUTILS_SET_ERROR_MSG("failed to open the log file", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  atomic_init(&file->active_writers, 0);
+
+  if (file->has_flush_thread) {
+    atomic_store(&file->running, true);
+    if (rcutils_thread_create(
+        &file->flush_thread, __rcutils_logging_file_flush_periodically, file) != RCUTILS_RET_OK)
+    {
+      atomic_store(&file->running, false);
+      fclose(file->file);
+      file->file = NULL;
+      rcutils_condition_fini(&file->condition);
+      rcutils_mutex_fini(&file->mutex);
+      allocator.deallocate(file->file_path, allocator.state);
+      allocator.deallocate(file->buffer, allocator.state);
+      RCUTILS_SET_ERROR_MSG("failed to start the log file flush thread", allocator)
+      return RCUTILS_RET_ERROR;
+    }
+  }
+  g_rcutils_logging_file_opened = true;
+  atomic_store(&file->enabled, true);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_file_flush(void)
+{
+  if (!g_rcutils_logging_file_opened) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_file_t * file = &g_rcutils_logging_file;
+  rcutils_mutex_lock(&file->mutex);
+  bool flushed = __rcutils_logging_file_flush_locked(file);
+  rcutils_mutex_unlock(&file->mutex);
+  if (!flushed) {
+    RCUTILS_SET_ERROR_MSG("failed to write to the log file", file->allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_file_close(void)
+{
+  if (!g_rcutils_logging_file_opened) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_file_t * file = &g_rcutils_logging_file;
+  rcutils_allocator_t allocator = file->allocator;
+
+  // Stop accepting output lines and wait for the ones which are being written.
+  atomic_store(&file->enabled, false);
+  while (atomic_load(&file->active_writers) != 0) {
+    rcutils_thread_yield();
+  }
+  if (file->has_flush_thread) {
+    rcutils_mutex_lock(&file->mutex);
+    atomic_store(&file->running, false);
+    rcutils_condition_signal(&file->condition);
+    rcutils_mutex_unlock(&file->mutex);
+    if (rcutils_thread_join(&file->flush_thread) != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG("failed to join the log file flush thread", allocator)
+      return RCUTILS_RET_ERROR;
+    }
+  }
+  g_rcutils_logging_file_opened = false;
+
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  if (!__rcutils_logging_file_flush_locked(file)) {
+    RCUTILS_SET_ERROR_MSG("failed to write to the log file", allocator)
+    ret = RCUTILS_RET_ERROR;
+  }
+  if (file->file && fclose(file->file) != 0) {
+    RCUTILS_SET_ERROR_MSG("failed to close the log file", allocator)
+    ret = RCUTILS_RET_ERROR;
+  }
+  file->file = NULL;
+  rcutils_condition_fini(&file->condition);
+  rcutils_mutex_fini(&file->mutex);
+  allocator.deallocate(file->file_path, allocator.state);
+  file->file_path = NULL;
+  allocator.deallocate(file->buffer, allocator.state);
+  file->buffer = NULL;
+  return ret;
+}
+
+#if __cplusplus
+}
+#endif
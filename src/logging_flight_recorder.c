@@ -0,0 +1,806 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <limits.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+# include <fcntl.h>
+# include <io.h>
+# include <sys/stat.h>
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include "./logging_binary_format.h"
+#include "./logging_output.h"
+#include "./stdatomic_helper.h"
+#include "./thread_helper.h"
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_flight_recorder.h"
+#include "rcutils/macros.h"
+#include "rcutils/strdup.h"
+#include "rcutils/time.h"
+
+// The size of the buffer the entries of a dump are collected in before being written.
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_WRITE_BUFFER_SIZE 4096
+
+// The ids of the strings and the call site of a dumped record.
+// The decoder uses the latest entry with an id, so each record redefines the ids it refers to.
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_NAME_ID 1
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_FORMAT_ID 2
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_FUNCTION_NAME_ID 3
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_FILE_NAME_ID 4
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_CALL_SITE_ID 5
+
+/// The header of a record in a ring, followed by the logger name and the encoded arguments.
+typedef struct rcutils_logging_flight_recorder_record_t
+{
+  // The size of the record with padding to 8 bytes, or 0 if the rest of the ring is unused.
+  uint32_t size;
+  int32_t severity;
+  int64_t timestamp;
+  const char * format;
+  // The strings of the location, or NULL if the message has no location.
+  const char * function_name;
+  const char * file_name;
+  uint64_t line_number;
+  uint32_t name_length;
+  uint32_t arguments_size;
+} rcutils_logging_flight_recorder_record_t;
+
+/// The ring which the records of one thread are written to.
+/**
+ * The positions only grow, the offset in the data is their remainder by the
+ * size of the ring.
+ * Only the thread which claimed the ring writes to it, the records from the
+ * tail up to the head are complete.
+ * The tail is moved past the records which are about to be overwritten before
+ * they are, so that a dump can detect records which changed while copying.
+ */
+typedef struct rcutils_logging_flight_recorder_ring_t
+{
+  atomic_bool claimed;
+  // Allocated by the first thread which claims the ring, before the head is moved.
+  char * data;
+  atomic_uint_least64_t head;
+  atomic_uint_least64_t tail;
+} rcutils_logging_flight_recorder_ring_t;
+
+/// The position of a dump in a ring.
+typedef struct rcutils_logging_flight_recorder_cursor_t
+{
+  uint64_t position;
+  // The head of the ring when the dump started, later records aren't dumped.
+  uint64_t end;
+  // The header of the record at the position, if there is one.
+  rcutils_logging_flight_recorder_record_t record;
+  bool has_record;
+} rcutils_logging_flight_recorder_cursor_t;
+
+typedef struct rcutils_logging_flight_recorder_t
+{
+  char * file_path;
+  // A power of two.
+  size_t ring_size;
+  size_t max_threads;
+  bool dump_on_fatal;
+  rcutils_allocator_t allocator;
+  // Changed for each start, to detect the rings claimed before.
+  uint64_t generation;
+  rcutils_logging_flight_recorder_ring_t * rings;
+
+  // The memory used by a dump, which is allocated in advance since a dump must not allocate.
+  rcutils_logging_flight_recorder_cursor_t * cursors;
+  char * record_buffer;
+  char write_buffer[RCUTILS_LOGGING_FLIGHT_RECORDER_WRITE_BUFFER_SIZE];
+  size_t buffered;
+  int file_descriptor;
+  bool write_failed;
+  // The strings which were last written with their ids.
+  const char * dumped_format;
+  const char * dumped_function_name;
+  const char * dumped_file_name;
+
+  // Records are only written and dumped while this is true.
+  atomic_bool enabled;
+  // The number of threads currently using the rings.
+  atomic_size_t active_threads;
+  atomic_bool dumping;
+} rcutils_logging_flight_recorder_t;
+
+static rcutils_logging_flight_recorder_t g_rcutils_logging_flight_recorder;
+static bool g_rcutils_logging_flight_recorder_started = false;
+
+atomic_int g_rcutils_logging_flight_recorder_severity = ATOMIC_VAR_INIT(INT_MAX);
+
+/// The ring claimed by a thread, which is only valid for the same generation of the recorder.
+typedef struct rcutils_logging_flight_recorder_thread_t
+{
+  // NULL if no ring was available.
+  rcutils_logging_flight_recorder_ring_t * ring;
+  uint64_t generation;
+} rcutils_logging_flight_recorder_thread_t;
+
+static RCUTILS_THREAD_LOCAL rcutils_logging_flight_recorder_thread_t
+  g_rcutils_logging_flight_recorder_thread;
+static rcutils_thread_key_t g_rcutils_logging_flight_recorder_thread_exit_key;
+static bool g_rcutils_logging_flight_recorder_thread_exit_key_created = false;
+
+// The signals after which the records are dumped, and the actions they had before.
+#ifdef _WIN32
+typedef void (* rcutils_logging_flight_recorder_signal_handler_t)(int);
+static const int g_rcutils_logging_flight_recorder_signals[] = {
+  SIGSEGV, SIGFPE, SIGILL, SIGABRT,
+};
+static rcutils_logging_flight_recorder_signal_handler_t
+  g_rcutils_logging_flight_recorder_previous_handlers[4];
+#else
+static const int g_rcutils_logging_flight_recorder_signals[] = {
+  SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT,
+};
+static struct sigaction g_rcutils_logging_flight_recorder_previous_actions[5];
+#endif
+#define RCUTILS_LOGGING_FLIGHT_RECORDER_SIGNALS_COUNT \
+  (sizeof(g_rcutils_logging_flight_recorder_signals) / \
+  sizeof(g_rcutils_logging_flight_recorder_signals[0]))
+static bool g_rcutils_logging_flight_recorder_signal_handlers_installed = false;
+
+rcutils_logging_flight_recorder_options_t
+rcutils_logging_flight_recorder_get_default_options(void)
+{
+  rcutils_logging_flight_recorder_options_t options;
+  options.file_path = NULL;
+  options.thread_buffer_size = 64 * 1024;
+  options.max_threads = 64;
+  options.severity = RCUTILS_LOG_SEVERITY_DEBUG;
+  options.dump_on_fatal = true;
+  options.dump_on_signal = true;
+  options.allocator = rcutils_get_default_allocator();
+  return options;
+}
+
+/// Get the ring of the calling thread, claiming one if it has none yet.
+/**
+ * \return the ring, or NULL if no ring is available for the thread.
+ */
+static rcutils_logging_flight_recorder_ring_t *
+__rcutils_logging_flight_recorder_get_thread_ring(rcutils_logging_flight_recorder_t * recorder)
+{
+  rcutils_logging_flight_recorder_thread_t * thread = &g_rcutils_logging_flight_recorder_thread;
+  if (thread->generation == recorder->generation) {
+    return thread->ring;
+  }
+  // A thread which doesn't get a ring doesn't try again until the next start.
+  thread->generation = recorder->generation;
+  thread->ring = NULL;
+  for (size_t i = 0; i < recorder->max_threads; ++i) {
+    rcutils_logging_flight_recorder_ring_t * ring = &recorder->rings[i];
+    bool claimed = false;
+    if (atomic_load(&ring->claimed) ||
+      !atomic_compare_exchange_strong(&ring->claimed, &claimed, true))
+    {
+      continue;
+    }
+    if (NULL == ring->data) {
+      ring->data = recorder->allocator.allocate(recorder->ring_size, recorder->allocator.state);
+      if (NULL == ring->data) {
+        atomic_store(&ring->claimed, false);
+        return NULL;
+      }
+    }
+    thread->ring = ring;
+    break;
+  }
+  if (thread->ring && g_rcutils_logging_flight_recorder_thread_exit_key_created) {
+    // If this fails the ring stays claimed after the thread exits.
+    (void)rcutils_thread_key_set(g_rcutils_logging_flight_recorder_thread_exit_key, thread);
+  }
+  return thread->ring;
+}
+
+static void RCUTILS_THREAD_KEY_DESTRUCTOR_CALL
+__rcutils_logging_flight_recorder_release_thread_ring_at_exit(void * value)
+{
+  rcutils_logging_flight_recorder_thread_t * thread =
+    (rcutils_logging_flight_recorder_thread_t *)value;
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  atomic_fetch_add(&recorder->active_threads, 1);
+  // The records stay in the ring for the thread which claims it next.
+  if (atomic_load(&recorder->enabled) && thread->generation == recorder->generation &&
+    thread->ring)
+  {
+    atomic_store(&thread->ring->claimed, false);
+  }
+  atomic_fetch_sub(&recorder->active_threads, 1);
+  thread->ring = NULL;
+}
+
+/// Write a record to the ring of the calling thread, overwriting the oldest records.
+static void
+__rcutils_logging_flight_recorder_write(
+  rcutils_logging_flight_recorder_t * recorder, rcutils_logging_flight_recorder_ring_t * ring,
+  const rcutils_logging_flight_recorder_record_t * record, const char * name,
+  const char * arguments)
+{
+  const size_t ring_size = recorder->ring_size;
+  const uint64_t mask = ring_size - 1;
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t offset = (size_t)(head & mask);
+  // A record doesn't wrap around, it starts at the beginning of the ring if it doesn't fit.
+  uint64_t start = head;
+  if (offset + record->size > ring_size) {
+    start += ring_size - offset;
+  }
+  uint64_t end = start + record->size;
+  while (end - tail > ring_size) {
+    uint32_t size;
+    memcpy(&size, ring->data + (tail & mask), sizeof(size));
+    tail += 0 == size ? ring_size - (tail & mask) : size;
+  }
+  // A dump which sees any of the bytes written below also sees the records they overwrite gone.
+  atomic_store_explicit(&ring->tail, tail, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  if (start != head) {
+    uint32_t padding = 0;
+    memcpy(ring->data + offset, &padding, sizeof(padding));
+  }
+  char * data = ring->data + (start & mask);
+  memcpy(data, record, sizeof(*record));
+  memcpy(data + sizeof(*record), name, record->name_length);
+  memcpy(data + sizeof(*record) + record->name_length, arguments, record->arguments_size);
+  atomic_store_explicit(&ring->head, end, memory_order_release);
+}
+
+static bool
+__rcutils_logging_flight_recorder_dump(rcutils_logging_flight_recorder_t * recorder);
+
+void
+rcutils_logging_flight_recorder_capture(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args)
+{
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  atomic_fetch_add(&recorder->active_threads, 1);
+  if (!atomic_load(&recorder->enabled)) {
+    atomic_fetch_sub(&recorder->active_threads, 1);
+    return;
+  }
+  rcutils_logging_flight_recorder_ring_t * ring =
+    __rcutils_logging_flight_recorder_get_thread_ring(recorder);
+  rcutils_logging_flight_recorder_record_t record;
+  size_t arguments_size = 0;
+  const char * arguments = NULL;
+  if (ring) {
+    arguments = rcutils_logging_binary_encode_message(&format, args, &arguments_size);
+  }
+  // Records larger than half of the ring would overwrite too many others.
+  const size_t max_size = recorder->ring_size / 2;
+  size_t name_length = strlen(name);
+  if (arguments && name_length <= max_size && arguments_size <= max_size &&
+    sizeof(record) + name_length + arguments_size <= max_size)
+  {
+    rcutils_time_point_value_t timestamp;
+    if (rcutils_system_time_now(&timestamp) != RCUTILS_RET_OK) {
+      timestamp = 0;
+    }
+    size_t size = (sizeof(record) + name_length + arguments_size + 7) & ~(size_t)7;
+    record.size = (uint32_t)size;
+    record.severity = severity;
+    record.timestamp = timestamp;
+    record.format = format;
+    record.function_name = NULL;
+    record.file_name = NULL;
+    record.line_number = 0;
+    if (location && location->function_name && location->file_name) {
+      record.function_name = location->function_name;
+      record.file_name = location->file_name;
+      record.line_number = location->line_number;
+    }
+    record.name_length = (uint32_t)name_length;
+    record.arguments_size = (uint32_t)arguments_size;
+    __rcutils_logging_flight_recorder_write(recorder, ring, &record, name, arguments);
+  }
+  if (recorder->dump_on_fatal && severity >= RCUTILS_LOG_SEVERITY_FATAL) {
+    __rcutils_logging_flight_recorder_dump(recorder);
+  }
+  atomic_fetch_sub(&recorder->active_threads, 1);
+}
+
+/// Write the buffered entries of the dump to its file.
+static void
+__rcutils_logging_flight_recorder_flush_dump(rcutils_logging_flight_recorder_t * recorder)
+{
+  const char * data = recorder->write_buffer;
+  size_t remaining = recorder->buffered;
+  recorder->buffered = 0;
+  while (remaining > 0 && !recorder->write_failed) {
+#ifdef _WIN32
+    int written = _write(recorder->file_descriptor, data, (unsigned int)remaining);
+#else
+    ssize_t written = write(recorder->file_descriptor, data, remaining);
+    if (written < 0 && EINTR == errno) {
+      continue;
+    }
+#endif
+    if (written <= 0) {
+      recorder->write_failed = true;
+      break;
+    }
+    data += written;
+    remaining -= (size_t)written;
+  }
+}
+
+/// Add the given bytes to the dump.
+static void
+__rcutils_logging_flight_recorder_write_dump(
+  rcutils_logging_flight_recorder_t * recorder, const void * data, size_t size)
+{
+  const char * bytes = (const char *)data;
+  while (size > 0) {
+    if (RCUTILS_LOGGING_FLIGHT_RECORDER_WRITE_BUFFER_SIZE == recorder->buffered) {
+      __rcutils_logging_flight_recorder_flush_dump(recorder);
+    }
+    size_t chunk = RCUTILS_LOGGING_FLIGHT_RECORDER_WRITE_BUFFER_SIZE - recorder->buffered;
+    if (chunk > size) {
+      chunk = size;
+    }
+    memcpy(recorder->write_buffer + recorder->buffered, bytes, chunk);
+    recorder->buffered += chunk;
+    bytes += chunk;
+    size -= chunk;
+  }
+}
+
+static void
+__rcutils_logging_flight_recorder_dump_string(
+  rcutils_logging_flight_recorder_t * recorder, uint32_t id, const char * string, size_t length)
+{
+  char header[RCUTILS_LOGGING_BINARY_STRING_HEADER_SIZE];
+  uint32_t length32 = (uint32_t)length;
+  header[0] = RCUTILS_LOGGING_BINARY_ENTRY_STRING;
+  memcpy(header + 1, &id, 4);
+  memcpy(header + 5, &length32, 4);
+  __rcutils_logging_flight_recorder_write_dump(recorder, header, sizeof(header));
+  __rcutils_logging_flight_recorder_write_dump(recorder, string, length32);
+}
+
+/// Read the header of the next record of a ring which hasn't been overwritten.
+/**
+ * \return true if there is such a record before the end of the dump.
+ */
+static bool
+__rcutils_logging_flight_recorder_peek(
+  rcutils_logging_flight_recorder_t * recorder, rcutils_logging_flight_recorder_ring_t * ring,
+  rcutils_logging_flight_recorder_cursor_t * cursor)
+{
+  const size_t ring_size = recorder->ring_size;
+  rcutils_logging_flight_recorder_record_t * record = &cursor->record;
+  cursor->has_record = false;
+  while (cursor->position < cursor->end) {
+    size_t offset = (size_t)(cursor->position & (ring_size - 1));
+    // Records always fit, so the rest of the ring is unused if the header doesn't.
+    record->size = 0;
+    if (ring_size - offset >= sizeof(*record)) {
+      memcpy(record, ring->data + offset, sizeof(*record));
+    }
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail > cursor->position) {
+      // The thread has overwritten the record, continue with its oldest one.
+      cursor->position = tail;
+      continue;
+    }
+    if (0 == record->size) {
+      cursor->position += ring_size - offset;
+      continue;
+    }
+    if (record->size < sizeof(*record) || record->size > ring_size / 2 ||
+      record->size > ring_size - offset ||
+      (uint64_t)record->name_length + record->arguments_size > record->size - sizeof(*record))
+    {
+      return false;
+    }
+    cursor->has_record = true;
+    return true;
+  }
+  return false;
+}
+
+/// Add the record at the cursor of a ring to the dump, unless it has been overwritten.
+static void
+__rcutils_logging_flight_recorder_dump_record(
+  rcutils_logging_flight_recorder_t * recorder, rcutils_logging_flight_recorder_ring_t * ring,
+  rcutils_logging_flight_recorder_cursor_t * cursor)
+{
+  const rcutils_logging_flight_recorder_record_t * record = &cursor->record;
+  size_t offset = (size_t)(cursor->position & (recorder->ring_size - 1));
+  memcpy(
+    recorder->record_buffer, ring->data + offset + sizeof(*record),
+    (size_t)record->name_length + record->arguments_size);
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&ring->tail, memory_order_relaxed) > cursor->position) {
+    return;
+  }
+
+  __rcutils_logging_flight_recorder_dump_string(
+    recorder, RCUTILS_LOGGING_FLIGHT_RECORDER_NAME_ID, recorder->record_buffer,
+    record->name_length);
+  if (record->format != recorder->dumped_format) {
+    __rcutils_logging_flight_recorder_dump_string(
+      recorder, RCUTILS_LOGGING_FLIGHT_RECORDER_FORMAT_ID, record->format,
+      strlen(record->format));
+    recorder->dumped_format = record->format;
+  }
+  uint32_t call_site_id = 0;
+  if (record->function_name) {
+    if (record->function_name != recorder->dumped_function_name) {
+      __rcutils_logging_flight_recorder_dump_string(
+        recorder, RCUTILS_LOGGING_FLIGHT_RECORDER_FUNCTION_NAME_ID, record->function_name,
+        strlen(record->function_name));
+      recorder->dumped_function_name = record->function_name;
+    }
+    if (record->file_name != recorder->dumped_file_name) {
+      __rcutils_logging_flight_recorder_dump_string(
+        recorder, RCUTILS_LOGGING_FLIGHT_RECORDER_FILE_NAME_ID, record->file_name,
+        strlen(record->file_name));
+      recorder->dumped_file_name = record->file_name;
+    }
+    char call_site[RCUTILS_LOGGING_BINARY_CALL_SITE_SIZE];
+    uint32_t function_name_id = RCUTILS_LOGGING_FLIGHT_RECORDER_FUNCTION_NAME_ID;
+    uint32_t file_name_id = RCUTILS_LOGGING_FLIGHT_RECORDER_FILE_NAME_ID;
+    call_site_id = RCUTILS_LOGGING_FLIGHT_RECORDER_CALL_SITE_ID;
+    call_site[0] = RCUTILS_LOGGING_BINARY_ENTRY_CALL_SITE;
+    memcpy(call_site + 1, &call_site_id, 4);
+    memcpy(call_site + 5, &function_name_id, 4);
+    memcpy(call_site + 9, &file_name_id, 4);
+    memcpy(call_site + 13, &record->line_number, 8);
+    __rcutils_logging_flight_recorder_write_dump(recorder, call_site, sizeof(call_site));
+  }
+
+  char header[RCUTILS_LOGGING_BINARY_RECORD_HEADER_SIZE];
+  uint32_t name_id = RCUTILS_LOGGING_FLIGHT_RECORDER_NAME_ID;
+  uint32_t format_id = RCUTILS_LOGGING_FLIGHT_RECORDER_FORMAT_ID;
+  header[0] = RCUTILS_LOGGING_BINARY_ENTRY_RECORD;
+  memcpy(header + 1, &record->timestamp, 8);
+  memcpy(header + 9, &record->severity, 4);
+  memcpy(header + 13, &name_id, 4);
+  memcpy(header + 17, &call_site_id, 4);
+  memcpy(header + 21, &format_id, 4);
+  memcpy(header + 25, &record->arguments_size, 4);
+  __rcutils_logging_flight_recorder_write_dump(recorder, header, sizeof(header));
+  __rcutils_logging_flight_recorder_write_dump(
+    recorder, recorder->record_buffer + record->name_length, record->arguments_size);
+}
+
+/// Write the records of all rings ordered by time, without allocating memory.
+/**
+ * Only async-signal-safe functions are used, so that this can be called from
+ * a signal handler.
+ *
+ * \return true if successful, false if another dump is in progress or writing failed.
+ */
+static bool
+__rcutils_logging_flight_recorder_dump(rcutils_logging_flight_recorder_t * recorder)
+{
+  if (atomic_exchange(&recorder->dumping, true)) {
+    return false;
+  }
+#ifdef _WIN32
+  recorder->file_descriptor = _open(
+    recorder->file_path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  recorder->file_descriptor = open(recorder->file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+  if (recorder->file_descriptor < 0) {
+    atomic_store(&recorder->dumping, false);
+    return false;
+  }
+  recorder->buffered = 0;
+  recorder->write_failed = false;
+  recorder->dumped_format = NULL;
+  recorder->dumped_function_name = NULL;
+  recorder->dumped_file_name = NULL;
+
+  char header[RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4 + 4];
+  uint32_t version = RCUTILS_LOGGING_BINARY_VERSION;
+  uint32_t byte_order_marker = RCUTILS_LOGGING_BINARY_BYTE_ORDER_MARKER;
+  memcpy(header, RCUTILS_LOGGING_BINARY_MAGIC, RCUTILS_LOGGING_BINARY_MAGIC_LENGTH);
+  memcpy(header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH, &version, 4);
+  memcpy(header + RCUTILS_LOGGING_BINARY_MAGIC_LENGTH + 4, &byte_order_marker, 4);
+  __rcutils_logging_flight_recorder_write_dump(recorder, header, sizeof(header));
+
+  for (size_t i = 0; i < recorder->max_threads; ++i) {
+    rcutils_logging_flight_recorder_cursor_t * cursor = &recorder->cursors[i];
+    rcutils_logging_flight_recorder_ring_t * ring = &recorder->rings[i];
+    cursor->end = atomic_load_explicit(&ring->head, memory_order_acquire);
+    cursor->position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    cursor->has_record = false;
+    if (cursor->end != 0) {
+      __rcutils_logging_flight_recorder_peek(recorder, ring, cursor);
+    }
+  }
+  // Merge the records of the rings, which are each ordered by time already.
+  while (true) {
+    size_t oldest = recorder->max_threads;
+    for (size_t i = 0; i < recorder->max_threads; ++i) {
+      if (recorder->cursors[i].has_record && (oldest == recorder->max_threads ||
+        recorder->cursors[i].record.timestamp < recorder->cursors[oldest].record.timestamp))
+      {
+        oldest = i;
+      }
+    }
+    if (oldest == recorder->max_threads) {
+      break;
+    }
+    rcutils_logging_flight_recorder_cursor_t * cursor = &recorder->cursors[oldest];
+    rcutils_logging_flight_recorder_ring_t * ring = &recorder->rings[oldest];
+    __rcutils_logging_flight_recorder_dump_record(recorder, ring, cursor);
+    cursor->position += cursor->record.size;
+    __rcutils_logging_flight_recorder_peek(recorder, ring, cursor);
+  }
+
+  __rcutils_logging_flight_recorder_flush_dump(recorder);
+#ifdef _WIN32
+  bool closed = _close(recorder->file_descriptor) == 0;
+#else
+  bool closed = close(recorder->file_descriptor) == 0;
+#endif
+  bool dumped = closed && !recorder->write_failed;
+  atomic_store(&recorder->dumping, false);
+  return dumped;
+}
+
+static void
+__rcutils_logging_flight_recorder_signal_handler(int signal_number)
+{
+#ifndef _WIN32
+  int saved_errno = errno;
+#endif
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  atomic_fetch_add(&recorder->active_threads, 1);
+  if (atomic_load(&recorder->enabled)) {
+    __rcutils_logging_flight_recorder_dump(recorder);
+  }
+  atomic_fetch_sub(&recorder->active_threads, 1);
+
+  // Restore the previous action and raise the signal again, it is delivered once this returns.
+  for (size_t i = 0; i < RCUTILS_LOGGING_FLIGHT_RECORDER_SIGNALS_COUNT; ++i) {
+    if (g_rcutils_logging_flight_recorder_signals[i] == signal_number) {
+#ifdef _WIN32
+      signal(signal_number, g_rcutils_logging_flight_recorder_previous_handlers[i]);
+#else
+      sigaction(signal_number, &g_rcutils_logging_flight_recorder_previous_actions[i], NULL);
+#endif
+    }
+  }
+  raise(signal_number);
+#ifndef _WIN32
+  errno = saved_errno;
+#endif
+}
+
+/// Restore the signal actions from before the signal handlers were installed.
+static bool
+__rcutils_logging_flight_recorder_restore_signal_handlers(size_t count)
+{
+  bool restored = true;
+  for (size_t i = 0; i < count; ++i) {
+    int signal_number = g_rcutils_logging_flight_recorder_signals[i];
+#ifdef _WIN32
+    restored &=
+      signal(signal_number, g_rcutils_logging_flight_recorder_previous_handlers[i]) != SIG_ERR;
+#else
+    restored &= sigaction(
+      signal_number, &g_rcutils_logging_flight_recorder_previous_actions[i], NULL) == 0;
+#endif
+  }
+  return restored;
+}
+
+static bool
+__rcutils_logging_flight_recorder_install_signal_handlers(void)
+{
+  for (size_t i = 0; i < RCUTILS_LOGGING_FLIGHT_RECORDER_SIGNALS_COUNT; ++i) {
+    int signal_number = g_rcutils_logging_flight_recorder_signals[i];
+#ifdef _WIN32
+    rcutils_logging_flight_recorder_signal_handler_t previous_handler =
+      signal(signal_number, __rcutils_logging_flight_recorder_signal_handler);
+    bool installed = previous_handler != SIG_ERR;
+    g_rcutils_logging_flight_recorder_previous_handlers[i] = previous_handler;
+#else
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = __rcutils_logging_flight_recorder_signal_handler;
+    sigemptyset(&action.sa_mask);
+    bool installed = sigaction(
+      signal_number, &action, &g_rcutils_logging_flight_recorder_previous_actions[i]) == 0;
+#endif
+    if (!installed) {
+      __rcutils_logging_flight_recorder_restore_signal_handlers(i);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+__rcutils_logging_flight_recorder_free(rcutils_logging_flight_recorder_t * recorder)
+{
+  rcutils_allocator_t allocator = recorder->allocator;
+  if (recorder->rings) {
+    for (size_t i = 0; i < recorder->max_threads; ++i) {
+      allocator.deallocate(recorder->rings[i].data, allocator.state);
+    }
+  }
+  allocator.deallocate(recorder->rings, allocator.state);
+  recorder->rings = NULL;
+  allocator.deallocate(recorder->cursors, allocator.state);
+  recorder->cursors = NULL;
+  allocator.deallocate(recorder->record_buffer, allocator.state);
+  recorder->record_buffer = NULL;
+  allocator.deallocate(recorder->file_path, allocator.state);
+  recorder->file_path = NULL;
+}
+
+rcutils_ret_t
+rcutils_logging_flight_recorder_start(const rcutils_logging_flight_recorder_options_t * options)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(
+    options, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
+  RCUTILS_CHECK_ALLOCATOR_WITH_MSG(
+    &options->allocator, "invalid allocator", return RCUTILS_RET_INVALID_ARGUMENT)
+  rcutils_allocator_t allocator = options->allocator;
+  if (NULL == options->file_path || '\0' == options->file_path[0]) {
+    RCUTILS_SET_ERROR_MSG("invalid file path", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  // The ring has to fit a few records, and their sizes have to fit into 32 bits.
+  if (options->thread_buffer_size < 1024 || options->thread_buffer_size > UINT32_MAX) {
+    RCUTILS_SET_ERROR_MSG("invalid thread buffer size", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (0 == options->max_threads ||
+    options->max_threads > SIZE_MAX / sizeof(rcutils_logging_flight_recorder_cursor_t))
+  {
+    RCUTILS_SET_ERROR_MSG("invalid maximum number of threads", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (options->severity < RCUTILS_LOG_SEVERITY_UNSET ||
+    options->severity > RCUTILS_LOG_SEVERITY_FATAL)
+  {
+    RCUTILS_SET_ERROR_MSG("invalid severity", allocator)
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (g_rcutils_logging_flight_recorder_started) {
+    RCUTILS_SET_ERROR_MSG("the flight recorder is started already", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  recorder->allocator = allocator;
+  recorder->ring_size = 1024;
+  while (recorder->ring_size < options->thread_buffer_size) {
+    recorder->ring_size *= 2;
+  }
+  recorder->max_threads = options->max_threads;
+  recorder->dump_on_fatal = options->dump_on_fatal;
+  recorder->file_path = rcutils_strdup(options->file_path, allocator);
+  recorder->rings = allocator.zero_allocate(
+    options->max_threads, sizeof(rcutils_logging_flight_recorder_ring_t), allocator.state);
+  recorder->cursors = allocator.zero_allocate(
+    options->max_threads, sizeof(rcutils_logging_flight_recorder_cursor_t), allocator.state);
+  recorder->record_buffer = allocator.allocate(recorder->ring_size / 2, allocator.state);
+  if (NULL == recorder->file_path || NULL == recorder->rings || NULL == recorder->cursors ||
+    NULL == recorder->record_buffer)
+  {
+    __rcutils_logging_flight_recorder_free(recorder);
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for the flight recorder", allocator)
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  for (size_t i = 0; i < recorder->max_threads; ++i) {
+    atomic_init(&recorder->rings[i].claimed, false);
+    atomic_init(&recorder->rings[i].head, 0);
+    atomic_init(&recorder->rings[i].tail, 0);
+  }
+  if (options->dump_on_signal && !__rcutils_logging_flight_recorder_install_signal_handlers()) {
+    __rcutils_logging_flight_recorder_free(recorder);
+    RCUTILS_SET_ERROR_MSG("failed to install the signal handlers", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  g_rcutils_logging_flight_recorder_signal_handlers_installed = options->dump_on_signal;
+  if (!g_rcutils_logging_flight_recorder_thread_exit_key_created) {
+    // If this fails the rings of exited threads aren't reused.
+    g_rcutils_logging_flight_recorder_thread_exit_key_created = rcutils_thread_key_create(
+      &g_rcutils_logging_flight_recorder_thread_exit_key,
+      __rcutils_logging_flight_recorder_release_thread_ring_at_exit) == RCUTILS_RET_OK;
+  }
+
+  ++recorder->generation;
+  atomic_init(&recorder->active_threads, 0);
+  atomic_init(&recorder->dumping, false);
+  g_rcutils_logging_flight_recorder_started = true;
+  atomic_store(&recorder->enabled, true);
+  atomic_store(&g_rcutils_logging_flight_recorder_severity, options->severity);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_flight_recorder_stop(void)
+{
+  if (!g_rcutils_logging_flight_recorder_started) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  rcutils_allocator_t allocator = recorder->allocator;
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  if (g_rcutils_logging_flight_recorder_signal_handlers_installed) {
+    g_rcutils_logging_flight_recorder_signal_handlers_installed = false;
+    if (!__rcutils_logging_flight_recorder_restore_signal_handlers(
+        RCUTILS_LOGGING_FLIGHT_RECORDER_SIGNALS_COUNT))
+    {
+      RCUTILS_SET_ERROR_MSG("failed to restore the signal handlers", allocator)
+      ret = RCUTILS_RET_ERROR;
+    }
+  }
+
+  // Stop recording and wait for the threads which are using the rings.
+  atomic_store(&g_rcutils_logging_flight_recorder_severity, INT_MAX);
+  atomic_store(&recorder->enabled, false);
+  while (atomic_load(&recorder->active_threads) != 0) {
+    rcutils_thread_yield();
+  }
+  g_rcutils_logging_flight_recorder_started = false;
+  __rcutils_logging_flight_recorder_free(recorder);
+  return ret;
+}
+
+rcutils_ret_t
+rcutils_logging_flight_recorder_dump(void)
+{
+  rcutils_logging_flight_recorder_t * recorder = &g_rcutils_logging_flight_recorder;
+  atomic_fetch_add(&recorder->active_threads, 1);
+  if (!atomic_load(&recorder->enabled)) {
+    atomic_fetch_sub(&recorder->active_threads, 1);
+    RCUTILS_SET_ERROR_MSG("the flight recorder isn't started", rcutils_get_default_allocator())
+    return RCUTILS_RET_ERROR;
+  }
+  rcutils_allocator_t allocator = recorder->allocator;
+  bool dumped = __rcutils_logging_flight_recorder_dump(recorder);
+  atomic_fetch_sub(&recorder->active_threads, 1);
+  if (!dumped) {
+    RCUTILS_SET_ERROR_MSG("failed to dump the flight recorder", allocator)
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+#if __cplusplus
+}
+#endif
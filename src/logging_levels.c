@@ -0,0 +1,477 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include "./logging_levels.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "./hash_helper.h"
+#include "rcutils/logging.h"
+
+void
+rcutils_logging_levels_init(rcutils_logging_levels_t * levels, rcutils_allocator_t allocator)
+{
+  levels->root = NULL;
+  levels->sequence = 0;
+  levels->allocator = allocator;
+}
+
+/// Free a node without its children.
+static void
+__rcutils_logging_levels_free_node(
+  rcutils_logging_levels_node_t * node, rcutils_allocator_t allocator)
+{
+  allocator.deallocate(node->children, allocator.state);
+  allocator.deallocate(node->segment, allocator.state);
+  allocator.deallocate(node, allocator.state);
+}
+
+static void
+__rcutils_logging_levels_free_tree(
+  rcutils_logging_levels_node_t * node, rcutils_allocator_t allocator)
+{
+  for (size_t i = 0; i < node->children_capacity; ++i) {
+    rcutils_logging_levels_node_t * child = node->children[i];
+    if (child) {
+      __rcutils_logging_levels_free_tree(child, allocator);
+    }
+  }
+  __rcutils_logging_levels_free_node(node, allocator);
+}
+
+void
+rcutils_logging_levels_fini(rcutils_logging_levels_t * levels)
+{
+  if (levels->root) {
+    __rcutils_logging_levels_free_tree(levels->root, levels->allocator);
+  }
+  rcutils_logging_levels_init(levels, levels->allocator);
+}
+
+void
+rcutils_logging_levels_free_replaced(
+  rcutils_logging_levels_node_t * replaced, rcutils_allocator_t allocator)
+{
+  while (replaced) {
+    rcutils_logging_levels_node_t * next = replaced->next_replaced;
+    __rcutils_logging_levels_free_node(replaced, allocator);
+    replaced = next;
+  }
+}
+
+/// Find the child with the segment, or the unused entry where it would be added.
+static rcutils_logging_levels_node_t **
+__rcutils_logging_levels_find_child(
+  const rcutils_logging_levels_node_t * node, const char * segment, size_t segment_length,
+  size_t hash)
+{
+  size_t mask = node->children_capacity - 1;
+  size_t index = hash & mask;
+  while (true) {
+    rcutils_logging_levels_node_t ** entry = &node->children[index];
+    if (NULL == *entry ||
+      ((*entry)->hash == hash && (*entry)->segment_length == segment_length &&
+      memcmp((*entry)->segment, segment, segment_length) == 0))
+    {
+      return entry;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+/// Get the child with the segment, or NULL if there is none.
+static const rcutils_logging_levels_node_t *
+__rcutils_logging_levels_get_child(
+  const rcutils_logging_levels_node_t * node, const char * segment, size_t segment_length)
+{
+  if (0 == node->children_size) {
+    return NULL;
+  }
+  return *__rcutils_logging_levels_find_child(
+    node, segment, segment_length, rcutils_hash_string(segment, segment_length));
+}
+
+/// Make sure that one more child can be added without exceeding a load factor of 0.5.
+static rcutils_ret_t
+__rcutils_logging_levels_reserve_child(
+  rcutils_logging_levels_node_t * node, rcutils_allocator_t allocator)
+{
+  if ((node->children_size + 1) * 2 <= node->children_capacity) {
+    return RCUTILS_RET_OK;
+  }
+  size_t capacity = node->children_capacity ? node->children_capacity * 2 : 4;
+  if (capacity > SIZE_MAX / sizeof(rcutils_logging_levels_node_t *)) {
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  rcutils_logging_levels_node_t ** children = allocator.zero_allocate(
+    capacity, sizeof(rcutils_logging_levels_node_t *), allocator.state);
+  if (NULL == children) {
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  rcutils_logging_levels_node_t resized = *node;
+  resized.children = children;
+  resized.children_capacity = capacity;
+  for (size_t i = 0; i < node->children_capacity; ++i) {
+    rcutils_logging_levels_node_t * child = node->children[i];
+    if (child) {
+      *__rcutils_logging_levels_find_child(
+        &resized, child->segment, child->segment_length, child->hash) = child;
+    }
+  }
+  allocator.deallocate(node->children, allocator.state);
+  node->children = children;
+  node->children_capacity = capacity;
+  return RCUTILS_RET_OK;
+}
+
+/// Create a node without children.
+/**
+ * \param segment The segment of the node, or NULL for a root.
+ */
+static rcutils_logging_levels_node_t *
+__rcutils_logging_levels_create_node(
+  const char * segment, size_t segment_length, size_t hash, rcutils_allocator_t allocator)
+{
+  rcutils_logging_levels_node_t * node = allocator.zero_allocate(
+    1, sizeof(rcutils_logging_levels_node_t), allocator.state);
+  if (NULL == node) {
+    return NULL;
+  }
+  node->level = RCUTILS_LOG_SEVERITY_UNSET;
+  if (segment) {
+    node->segment = allocator.allocate(segment_length + 1, allocator.state);
+    if (NULL == node->segment) {
+      allocator.deallocate(node, allocator.state);
+      return NULL;
+    }
+    memcpy(node->segment, segment, segment_length);
+    node->segment[segment_length] = '\0';
+    node->segment_length = segment_length;
+    node->hash = hash;
+  }
+  return node;
+}
+
+/// Create a copy of a node which shares the children of the node.
+static rcutils_logging_levels_node_t *
+__rcutils_logging_levels_copy_node(
+  const rcutils_logging_levels_node_t * node, rcutils_allocator_t allocator)
+{
+  rcutils_logging_levels_node_t * copy = __rcutils_logging_levels_create_node(
+    node->segment, node->segment_length, node->hash, allocator);
+  if (NULL == copy) {
+    return NULL;
+  }
+  copy->level = node->level;
+  copy->sequence = node->sequence;
+  if (node->children_capacity > 0) {
+    copy->children = allocator.allocate(
+      node->children_capacity * sizeof(rcutils_logging_levels_node_t *), allocator.state);
+    if (NULL == copy->children) {
+      __rcutils_logging_levels_free_node(copy, allocator);
+      return NULL;
+    }
+    memcpy(
+      copy->children, node->children,
+      node->children_capacity * sizeof(rcutils_logging_levels_node_t *));
+    copy->children_capacity = node->children_capacity;
+    copy->children_size = node->children_size;
+  }
+  return copy;
+}
+
+/// Get the length of the first segment of a name.
+static size_t
+__rcutils_logging_levels_segment_length(const char * name, size_t name_length)
+{
+  const char * separator = memchr(name, RCUTILS_LOGGING_SEPARATOR_CHAR, name_length);
+  return separator ? (size_t)(separator - name) : name_length;
+}
+
+rcutils_ret_t
+rcutils_logging_levels_set(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int level,
+  rcutils_logging_levels_t * updated, rcutils_logging_levels_node_t ** replaced)
+{
+  rcutils_allocator_t allocator = levels->allocator;
+  // The nodes on the path are copied, so that they can be modified without disturbing readers.
+  // The copies are linked like the replaced nodes, to free them if an error occurs.
+  rcutils_logging_levels_node_t * copies = NULL;
+  rcutils_logging_levels_node_t * replaced_here = NULL;
+  rcutils_logging_levels_node_t * root;
+  if (levels->root) {
+    root = __rcutils_logging_levels_copy_node(levels->root, allocator);
+  } else {
+    root = __rcutils_logging_levels_create_node(NULL, 0, 0, allocator);
+  }
+  if (NULL == root) {
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  copies = root;
+  if (levels->root) {
+    replaced_here = levels->root;
+    replaced_here->next_replaced = NULL;
+  }
+
+  rcutils_logging_levels_node_t * node = root;
+  size_t offset = 0;
+  while (true) {
+    size_t segment_length =
+      __rcutils_logging_levels_segment_length(name + offset, name_length - offset);
+    const char * segment = name + offset;
+    if (__rcutils_logging_levels_reserve_child(node, allocator) != RCUTILS_RET_OK) {
+      rcutils_logging_levels_free_replaced(copies, allocator);
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+    size_t hash = rcutils_hash_string(segment, segment_length);
+    rcutils_logging_levels_node_t ** entry =
+      __rcutils_logging_levels_find_child(node, segment, segment_length, hash);
+    rcutils_logging_levels_node_t * child;
+    if (*entry) {
+      child = __rcutils_logging_levels_copy_node(*entry, allocator);
+    } else {
+      child = __rcutils_logging_levels_create_node(segment, segment_length, hash, allocator);
+    }
+    if (NULL == child) {
+      rcutils_logging_levels_free_replaced(copies, allocator);
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+    child->next_replaced = copies;
+    copies = child;
+    if (*entry) {
+      (*entry)->next_replaced = replaced_here;
+      replaced_here = *entry;
+    } else {
+      node->children_size++;
+    }
+    *entry = child;
+    node = child;
+    offset += segment_length;
+    if (offset == name_length) {
+      break;
+    }
+    // Skip the separator.
+    ++offset;
+  }
+  node->level = level;
+  node->sequence = levels->sequence + 1;
+
+  // Nothing can fail anymore, forget about the copies and hand over the replaced nodes.
+  while (copies) {
+    rcutils_logging_levels_node_t * next = copies->next_replaced;
+    copies->next_replaced = NULL;
+    copies = next;
+  }
+  if (replaced_here) {
+    rcutils_logging_levels_node_t * last = replaced_here;
+    while (last->next_replaced) {
+      last = last->next_replaced;
+    }
+    last->next_replaced = *replaced;
+    *replaced = replaced_here;
+  }
+  updated->root = root;
+  updated->sequence = levels->sequence + 1;
+  updated->allocator = allocator;
+  return RCUTILS_RET_OK;
+}
+
+/// Descend to the node of a logger, optionally remembering the deepest level set on the way.
+/**
+ * \return The node of the logger, or NULL if it isn't part of the tree.
+ */
+static const rcutils_logging_levels_node_t *
+__rcutils_logging_levels_descend(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length,
+  int * deepest_level, size_t * deepest_depth)
+{
+  const rcutils_logging_levels_node_t * node = levels->root;
+  if (NULL == node) {
+    return NULL;
+  }
+  size_t offset = 0;
+  size_t depth = 0;
+  while (true) {
+    size_t segment_length =
+      __rcutils_logging_levels_segment_length(name + offset, name_length - offset);
+    node = __rcutils_logging_levels_get_child(node, name + offset, segment_length);
+    if (NULL == node) {
+      return NULL;
+    }
+    ++depth;
+    if (deepest_level && node->level != RCUTILS_LOG_SEVERITY_UNSET) {
+      *deepest_level = node->level;
+      *deepest_depth = depth;
+    }
+    offset += segment_length;
+    if (offset == name_length) {
+      return node;
+    }
+    // Skip the separator.
+    ++offset;
+  }
+}
+
+bool
+rcutils_logging_levels_get(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int * level)
+{
+  const rcutils_logging_levels_node_t * node =
+    __rcutils_logging_levels_descend(levels, name, name_length, NULL, NULL);
+  if (NULL == node || RCUTILS_LOG_SEVERITY_UNSET == node->level) {
+    return false;
+  }
+  *level = node->level;
+  return true;
+}
+
+bool
+rcutils_logging_levels_get_effective(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int * level,
+  size_t * depth)
+{
+  int deepest_level = RCUTILS_LOG_SEVERITY_UNSET;
+  __rcutils_logging_levels_descend(levels, name, name_length, &deepest_level, depth);
+  if (RCUTILS_LOG_SEVERITY_UNSET == deepest_level) {
+    return false;
+  }
+  *level = deepest_level;
+  return true;
+}
+
+/// A set of active nodes while matching patterns, which starts out in a buffer on the stack.
+typedef struct rcutils_logging_levels_states_t
+{
+  const rcutils_logging_levels_node_t ** nodes;
+  size_t size;
+  size_t capacity;
+  bool allocated;
+} rcutils_logging_levels_states_t;
+
+#define RCUTILS_LOGGING_LEVELS_STATES_STACK_CAPACITY 16
+
+static bool
+__rcutils_logging_levels_is_any_segments(const rcutils_logging_levels_node_t * node)
+{
+  return 2 == node->segment_length && 0 == memcmp(node->segment, "**", 2);
+}
+
+/// Add a node, and the `**` nodes which can match no segments after it, to a set.
+static rcutils_ret_t
+__rcutils_logging_levels_add_state(
+  rcutils_logging_levels_states_t * states, const rcutils_logging_levels_node_t * node,
+  rcutils_allocator_t allocator)
+{
+  while (node) {
+    for (size_t i = 0; i < states->size; ++i) {
+      if (states->nodes[i] == node) {
+        return RCUTILS_RET_OK;
+      }
+    }
+    if (states->size == states->capacity) {
+      const rcutils_logging_levels_node_t ** nodes = allocator.allocate(
+        states->capacity * 2 * sizeof(rcutils_logging_levels_node_t *), allocator.state);
+      if (NULL == nodes) {
+        return RCUTILS_RET_BAD_ALLOC;
+      }
+      memcpy(nodes, states->nodes, states->size * sizeof(rcutils_logging_levels_node_t *));
+      if (states->allocated) {
+        allocator.deallocate((void *)states->nodes, allocator.state);
+      }
+      states->nodes = nodes;
+      states->capacity *= 2;
+      states->allocated = true;
+    }
+    states->nodes[states->size++] = node;
+    node = __rcutils_logging_levels_get_child(node, "**", 2);
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rcutils_logging_levels_match(
+  const rcutils_logging_levels_t * patterns, const char * name, size_t name_length, int * level,
+  size_t * depth)
+{
+  *level = RCUTILS_LOG_SEVERITY_UNSET;
+  if (NULL == patterns->root || 0 == patterns->root->children_size) {
+    return RCUTILS_RET_OK;
+  }
+  rcutils_allocator_t allocator = patterns->allocator;
+  const rcutils_logging_levels_node_t * buffers[2][RCUTILS_LOGGING_LEVELS_STATES_STACK_CAPACITY];
+  rcutils_logging_levels_states_t current =
+  {buffers[0], 0, RCUTILS_LOGGING_LEVELS_STATES_STACK_CAPACITY, false};
+  rcutils_logging_levels_states_t next =
+  {buffers[1], 0, RCUTILS_LOGGING_LEVELS_STATES_STACK_CAPACITY, false};
+  rcutils_ret_t ret = __rcutils_logging_levels_add_state(&current, patterns->root, allocator);
+
+  size_t offset = 0;
+  size_t segment_depth = 0;
+  while (RCUTILS_RET_OK == ret && current.size > 0) {
+    size_t segment_length =
+      __rcutils_logging_levels_segment_length(name + offset, name_length - offset);
+    const char * segment = name + offset;
+    ++segment_depth;
+    next.size = 0;
+    for (size_t i = 0; i < current.size && RCUTILS_RET_OK == ret; ++i) {
+      const rcutils_logging_levels_node_t * node = current.nodes[i];
+      ret = __rcutils_logging_levels_add_state(
+        &next, __rcutils_logging_levels_get_child(node, segment, segment_length), allocator);
+      if (RCUTILS_RET_OK == ret) {
+        ret = __rcutils_logging_levels_add_state(
+          &next, __rcutils_logging_levels_get_child(node, "*", 1), allocator);
+      }
+      if (RCUTILS_RET_OK == ret && __rcutils_logging_levels_is_any_segments(node)) {
+        ret = __rcutils_logging_levels_add_state(&next, node, allocator);
+      }
+    }
+    // The pattern set last wins among the patterns matching at this depth.
+    size_t sequence = 0;
+    for (size_t i = 0; i < next.size; ++i) {
+      const rcutils_logging_levels_node_t * node = next.nodes[i];
+      if (node->level != RCUTILS_LOG_SEVERITY_UNSET && node->sequence > sequence) {
+        sequence = node->sequence;
+        *level = node->level;
+        *depth = segment_depth;
+      }
+    }
+    rcutils_logging_levels_states_t swap = current;
+    current = next;
+    next = swap;
+    offset += segment_length;
+    if (offset == name_length) {
+      break;
+    }
+    // Skip the separator.
+    ++offset;
+  }
+
+  if (current.allocated) {
+    allocator.deallocate((void *)current.nodes, allocator.state);
+  }
+  if (next.allocated) {
+    allocator.deallocate((void *)next.nodes, allocator.state);
+  }
+  return ret;
+}
+
+#if __cplusplus
+}
+#endif
@@ -0,0 +1,165 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOGGING_LEVELS_H_
+#define LOGGING_LEVELS_H_
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rcutils/allocator.h"
+#include "rcutils/types/rcutils_ret.h"
+#include "rcutils/visibility_control.h"
+
+typedef struct rcutils_logging_levels_node_t
+{
+  // The segment of the logger name between two separators, NULL for the root.
+  char * segment;
+  size_t segment_length;
+  size_t hash;
+  // `RCUTILS_LOG_SEVERITY_UNSET` if no level has been set for the logger.
+  int level;
+  // The order in which the levels were set, later levels have a higher number.
+  size_t sequence;
+  // A hash table of the child nodes using open addressing and linear probing,
+  // the number of entries is zero or a power of two.
+  struct rcutils_logging_levels_node_t ** children;
+  size_t children_capacity;
+  size_t children_size;
+  // Links the nodes which have been replaced by rcutils_logging_levels_set().
+  struct rcutils_logging_levels_node_t * next_replaced;
+} rcutils_logging_levels_node_t;
+
+/// The registry of the severity levels which have been set for loggers.
+/**
+ * The levels are stored in a prefix tree with one node per segment of the
+ * logger names, which are split on `RCUTILS_LOGGING_SEPARATOR_CHAR`.
+ * The children of a node are stored in a hash table keyed by their segment.
+ * Nodes are never removed, setting the level `RCUTILS_LOG_SEVERITY_UNSET`
+ * stores that level instead.
+ *
+ * A registry is never modified once it has been created.
+ * Setting a level creates a new registry which shares all nodes with the
+ * previous one except for those on the path to the logger, which are copied.
+ * Therefore readers of the previous registry can continue while a level is
+ * set, and the replaced nodes are freed once no reader uses them anymore.
+ */
+typedef struct rcutils_logging_levels_t
+{
+  // NULL while no level has been set.
+  rcutils_logging_levels_node_t * root;
+  // The sequence number of the level which was set last.
+  size_t sequence;
+  rcutils_allocator_t allocator;
+} rcutils_logging_levels_t;
+
+/// Initialize an empty registry, which doesn't allocate memory until a level is set.
+RCUTILS_LOCAL
+void
+rcutils_logging_levels_init(rcutils_logging_levels_t * levels, rcutils_allocator_t allocator);
+
+/// Free the memory of the registry, leaving it empty.
+/**
+ * The nodes replaced by setting levels aren't part of the registry anymore,
+ * they have to be freed with rcutils_logging_levels_free_replaced() before.
+ */
+RCUTILS_LOCAL
+void
+rcutils_logging_levels_fini(rcutils_logging_levels_t * levels);
+
+/// Create a registry with the level of a logger set, the name doesn't need to be null terminated.
+/**
+ * The cost is proportional to the number of segments of the name and the
+ * number of children of the nodes on the way to the logger.
+ * The nodes of `levels` which aren't part of `updated` are prepended to the
+ * list of replaced nodes, `levels` stays valid until they are freed.
+ * If an error occurs `updated` and the list of replaced nodes are unchanged.
+ *
+ * \param[out] updated The new registry, which may be `levels` itself.
+ * \param[inout] replaced The list of replaced nodes, linked by `next_replaced`.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCUTILS_LOCAL
+rcutils_ret_t
+rcutils_logging_levels_set(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int level,
+  rcutils_logging_levels_t * updated, rcutils_logging_levels_node_t ** replaced);
+
+/// Free a list of nodes replaced by rcutils_logging_levels_set(), without their children.
+RCUTILS_LOCAL
+void
+rcutils_logging_levels_free_replaced(
+  rcutils_logging_levels_node_t * replaced, rcutils_allocator_t allocator);
+
+/// Get the level of a logger, the name doesn't need to be null terminated.
+/**
+ * This function doesn't allocate memory.
+ *
+ * \return true if a level has been set for the logger, false otherwise.
+ */
+RCUTILS_LOCAL
+bool
+rcutils_logging_levels_get(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int * level);
+
+/// Get the level of a logger or its closest ancestor which has a level set.
+/**
+ * The ancestors are visited in a single descent from the root of the tree,
+ * remembering the deepest level which has been set.
+ * This function doesn't allocate memory.
+ *
+ * \param[out] depth The number of segments of the logger or ancestor which has the level.
+ * \return true if a level has been set for the logger or an ancestor, false otherwise.
+ */
+RCUTILS_LOCAL
+bool
+rcutils_logging_levels_get_effective(
+  const rcutils_logging_levels_t * levels, const char * name, size_t name_length, int * level,
+  size_t * depth);
+
+/// Get the level of the deepest pattern which matches a logger or one of its ancestors.
+/**
+ * The names in the registry are interpreted as patterns, where a segment `*`
+ * matches any one segment and a segment `**` matches any number of segments,
+ * including none.
+ * All patterns are matched in a single pass over the segments of the logger
+ * name, by simulating the tree as a nondeterministic automaton whose states
+ * are the nodes of the tree.
+ * If several patterns match at the same depth, the level set last is used.
+ *
+ * This function only allocates memory if many nodes of the tree can be
+ * active at the same time.
+ *
+ * \param[out] level The level, or `RCUTILS_LOG_SEVERITY_UNSET` if no pattern matched.
+ * \param[out] depth The number of segments of the logger or ancestor which matched.
+ * \return `RCUTILS_RET_OK` if successful, or
+ * \return `RCUTILS_RET_BAD_ALLOC` if allocating memory failed.
+ */
+RCUTILS_LOCAL
+rcutils_ret_t
+rcutils_logging_levels_match(
+  const rcutils_logging_levels_t * patterns, const char * name, size_t name_length, int * level,
+  size_t * depth);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // LOGGING_LEVELS_H_
@@ -0,0 +1,92 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOGGING_OUTPUT_H_
+#define LOGGING_OUTPUT_H_
+
+// Internal helpers shared by the logging functions and the output handlers.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "./stdatomic_helper.h"
+#include "rcutils/logging.h"
+#include "rcutils/visibility_control.h"
+
+/// Render an output line using the console output format.
+/**
+ * The line is rendered into a scratch buffer of the calling thread, which is
+ * only valid until the next call on the same thread.
+ * It is null terminated and doesn't include a trailing newline.
+ *
+ * \return true if successful, or
+ * \return false if the severity is unknown or formatting the line failed,
+ *   which has been reported to stderr.
+ */
+RCUTILS_LOCAL
+bool
+rcutils_logging_render_output_line(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args,
+  const char ** line, size_t * line_length);
+
+/// Get the scratch buffer of the calling thread used for rendering output lines.
+/**
+ * Output handlers which don't render output lines can use this buffer
+ * instead, it keeps its contents when it grows.
+ *
+ * \param size The minimum size of the buffer in bytes.
+ * \param capacity The actual size of the buffer is stored here.
+ * \return the buffer, or NULL if allocating memory failed.
+ */
+RCUTILS_LOCAL
+char *
+rcutils_logging_reserve_output_scratch_buffer(size_t size, size_t * capacity);
+
+/// Account the bytes output by a handler against the log volume budget.
+/**
+ * \param bytes The number of bytes written for a message.
+ */
+RCUTILS_LOCAL
+void
+rcutils_logging_add_output_volume(size_t bytes);
+
+/// The lowest severity recorded by the flight recorder, above all severities while it's stopped.
+RCUTILS_LOCAL
+extern atomic_int g_rcutils_logging_flight_recorder_severity;
+
+/// Record a message in the ring of the calling thread if the flight recorder is started.
+/**
+ * This dumps the records afterwards if the message is fatal and the flight
+ * recorder is configured to do so.
+ *
+ * \param args The arguments of the format string, which are not consumed.
+ */
+RCUTILS_LOCAL
+void
+rcutils_logging_flight_recorder_capture(
+  const rcutils_log_location_t * location,
+  int severity, const char * name, const char * format, va_list * args);
+
+#if __cplusplus
+}
+#endif
+
+#endif  // LOGGING_OUTPUT_H_
@@ -0,0 +1,33 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef STDATOMIC_HELPER_H_
+#define STDATOMIC_HELPER_H_
+
+// Internal helper used to get C11 atomics on all supported platforms.
+// Only the atomic types which are typedef'd by the C11 standard (and not the
+// _Atomic keyword) may be used, since the Windows shim cannot support it.
+
+#if !defined(_WIN32)
+
+#include <stdatomic.h>
+
+#else  // !defined(_WIN32)
+
+#include "./stdatomic_helper/win32/stdatomic.h"
+
+#endif  // !defined(_WIN32)
+
+#endif  // STDATOMIC_HELPER_H_
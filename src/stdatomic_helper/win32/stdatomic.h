@@ -0,0 +1,123 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Minimal subset of C11's stdatomic.h implemented with the Interlocked family
+// of functions, since MSVC does not provide stdatomic.h for C.
+//
+// All atomic types are 64 bits wide, which means any plain object which is
+// accessed through these functions must be 64 bits wide as well.
+// The same applies to the `expected` argument of the compare exchange functions.
+// Every operation is sequentially consistent regardless of the memory order given.
+
+#ifndef STDATOMIC_HELPER__WIN32__STDATOMIC_H_
+#define STDATOMIC_HELPER__WIN32__STDATOMIC_H_
+
+#if !defined(_WIN32)
+#error "this stdatomic.h does not support your compiler"
+#endif  // !defined(_WIN32)
+
+#include <windows.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum memory_order
+{
+  memory_order_relaxed,
+  memory_order_consume,
+  memory_order_acquire,
+  memory_order_release,
+  memory_order_acq_rel,
+  memory_order_seq_cst
+} memory_order;
+
+typedef volatile LONG64 atomic_bool;
+typedef volatile LONG64 atomic_int;
+typedef volatile LONG64 atomic_uint;
+typedef volatile LONG64 atomic_size_t;
+typedef volatile LONG64 atomic_int_least64_t;
+typedef volatile LONG64 atomic_uint_least64_t;
+typedef volatile LONG64 atomic_intptr_t;
+typedef volatile LONG64 atomic_uintptr_t;
+
+typedef volatile LONG atomic_flag;
+
+#define ATOMIC_FLAG_INIT 0
+#define ATOMIC_VAR_INIT(value) (value)
+
+static __inline bool
+rcutils_win32_atomic_compare_exchange(
+  volatile LONG64 * object, LONG64 * expected, LONG64 desired)
+{
+  LONG64 previous = InterlockedCompareExchange64(object, desired, *expected);
+  if (previous == *expected) {
+    return true;
+  }
+  *expected = previous;
+  return false;
+}
+
+#define atomic_init(object, value) (*(object) = (LONG64)(value))
+
+#define atomic_thread_fence(order) MemoryBarrier()
+
+#define atomic_load_explicit(object, order) \
+  InterlockedCompareExchange64((volatile LONG64 *)(object), 0, 0)
+#define atomic_load(object) \
+  atomic_load_explicit(object, memory_order_seq_cst)
+
+#define atomic_store_explicit(object, desired, order) \
+  ((void)InterlockedExchange64((volatile LONG64 *)(object), (LONG64)(desired)))
+#define atomic_store(object, desired) \
+  atomic_store_explicit(object, desired, memory_order_seq_cst)
+
+#define atomic_exchange_explicit(object, desired, order) \
+  InterlockedExchange64((volatile LONG64 *)(object), (LONG64)(desired))
+#define atomic_exchange(object, desired) \
+  atomic_exchange_explicit(object, desired, memory_order_seq_cst)
+
+#define atomic_compare_exchange_strong_explicit(object, expected, desired, success, failure) \
+  rcutils_win32_atomic_compare_exchange( \
+    (volatile LONG64 *)(object), (LONG64 *)(expected), (LONG64)(desired))
+#define atomic_compare_exchange_strong(object, expected, desired) \
+  atomic_compare_exchange_strong_explicit( \
+    object, expected, desired, memory_order_seq_cst, memory_order_seq_cst)
+#define atomic_compare_exchange_weak_explicit(object, expected, desired, success, failure) \
+  atomic_compare_exchange_strong_explicit(object, expected, desired, success, failure)
+#define atomic_compare_exchange_weak(object, expected, desired) \
+  atomic_compare_exchange_strong(object, expected, desired)
+
+#define atomic_fetch_add_explicit(object, operand, order) \
+  InterlockedExchangeAdd64((volatile LONG64 *)(object), (LONG64)(operand))
+#define atomic_fetch_add(object, operand) \
+  atomic_fetch_add_explicit(object, operand, memory_order_seq_cst)
+
+#define atomic_fetch_sub_explicit(object, operand, order) \
+  InterlockedExchangeAdd64((volatile LONG64 *)(object), -(LONG64)(operand))
+#define atomic_fetch_sub(object, operand) \
+  atomic_fetch_sub_explicit(object, operand, memory_order_seq_cst)
+
+#define atomic_flag_test_and_set_explicit(object, order) \
+  (InterlockedExchange((volatile LONG *)(object), 1) != 0)
+#define atomic_flag_test_and_set(object) \
+  atomic_flag_test_and_set_explicit(object, memory_order_seq_cst)
+
+#define atomic_flag_clear_explicit(object, order) \
+  ((void)InterlockedExchange((volatile LONG *)(object), 0))
+#define atomic_flag_clear(object) \
+  atomic_flag_clear_explicit(object, memory_order_seq_cst)
+
+#endif  // STDATOMIC_HELPER__WIN32__STDATOMIC_H_
@@ -21,17 +21,47 @@ extern "C"
 
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "./common.h"
+#include "./hash_helper.h"
 #include "rcutils/strdup.h"
 #include "rcutils/format_string.h"
 #include "rcutils/types/rcutils_ret.h"
 
+// A bucket which has never been used, this terminates the probing.
+#define RCUTILS_STRING_MAP_BUCKET_EMPTY 0
+// A bucket whose entry has been removed, probing has to continue past it.
+#define RCUTILS_STRING_MAP_BUCKET_REMOVED SIZE_MAX
+
+typedef struct rcutils_string_map_entry_t
+{
+  // NULL if the entry has been removed.
+  char * key;
+  char * value;
+  size_t key_length;
+  size_t hash;
+} rcutils_string_map_entry_t;
+
+/// The string map is a hash table with open addressing and linear probing.
+/**
+ * The entries are stored in the order they were added, so that iterating the
+ * keys follows the insertion order, and `capacity` entries are allocated.
+ * The buckets reference the entries by their index plus one, and there are at
+ * least twice as many buckets as entries, which keeps the load factor of the
+ * table (including removed entries) below 0.5.
+ * Removed entries leave a hole until the entries are compacted, which happens
+ * when a new entry doesn't fit at the end anymore or when reserving.
+ */
 typedef struct rcutils_string_map_impl_t
 {
-  char ** keys;
-  char ** values;
+  rcutils_string_map_entry_t * entries;
+  // The number of entries in use, including removed ones.
+  size_t entries_end;
+  size_t * buckets;
+  // The number of buckets minus one, the number of buckets is a power of two.
+  size_t bucket_mask;
   size_t capacity;
   size_t size;
   rcutils_allocator_t allocator;
@@ -66,8 +96,10 @@ rcutils_string_map_init(
       rcutils_get_default_allocator())
     return RCUTILS_RET_BAD_ALLOC;
   }
-  string_map->impl->keys = NULL;
-  string_map->impl->values = NULL;
+  string_map->impl->entries = NULL;
+  string_map->impl->entries_end = 0;
+  string_map->impl->buckets = NULL;
+  string_map->impl->bucket_mask = 0;
   string_map->impl->capacity = 0;
   string_map->impl->size = 0;
   string_map->impl->allocator = allocator;
@@ -137,6 +169,32 @@ rcutils_string_map_get_size(const rcutils_string_map_t * string_map, size_t * si
   return RCUTILS_RET_OK;
 }
 
+/// Move the entries in use to the front, keeping their order, and rebuild the buckets.
+static void
+__compact_entries_and_rebuild_buckets(
+  rcutils_string_map_impl_t * string_map_impl,
+  size_t * buckets,
+  size_t bucket_mask)
+{
+  size_t entries_end = 0;
+  for (size_t i = 0; i < string_map_impl->entries_end; ++i) {
+    if (string_map_impl->entries[i].key != NULL) {
+      string_map_impl->entries[entries_end++] = string_map_impl->entries[i];
+    }
+  }
+  string_map_impl->entries_end = entries_end;
+  for (size_t i = 0; i <= bucket_mask; ++i) {
+    buckets[i] = RCUTILS_STRING_MAP_BUCKET_EMPTY;
+  }
+  for (size_t i = 0; i < entries_end; ++i) {
+    size_t bucket_index = string_map_impl->entries[i].hash & bucket_mask;
+    while (buckets[bucket_index] != RCUTILS_STRING_MAP_BUCKET_EMPTY) {
+      bucket_index = (bucket_index + 1) & bucket_mask;
+    }
+    buckets[bucket_index] = i + 1;
+  }
+}
+
 rcutils_ret_t
 rcutils_string_map_reserve(rcutils_string_map_t * string_map, size_t capacity)
 {
@@ -155,43 +213,49 @@ rcutils_string_map_reserve(rcutils_string_map_t * string_map, size_t capacity)
     // if requested capacity is equal to the current capacity, nothing to do
     return RCUTILS_RET_OK;
   } else if (capacity == 0) {
-    // if the requested capacity is zero, then make sure the existing keys and values are free'd
-    allocator.deallocate(string_map->impl->keys, allocator.state);
-    string_map->impl->keys = NULL;
-    allocator.deallocate(string_map->impl->values, allocator.state);
-    string_map->impl->values = NULL;
+    // if the requested capacity is zero, then make sure the entries and buckets are free'd
+    allocator.deallocate(string_map->impl->entries, allocator.state);
+    string_map->impl->entries = NULL;
+    string_map->impl->entries_end = 0;
+    allocator.deallocate(string_map->impl->buckets, allocator.state);
+    string_map->impl->buckets = NULL;
+    string_map->impl->bucket_mask = 0;
     // falls through to normal function end
   } else {
-    // if the capacity non-zero and different, use realloc to increase/shrink the size
-    // note that realloc when the pointer is NULL is the same as malloc
-    // note also that realloc will shrink the space if needed
-
-    // resize the keys, assigning the result only if it succeeds
-    char ** new_keys =
-      allocator.reallocate(string_map->impl->keys, capacity * sizeof(char *), allocator.state);
-    if (NULL == new_keys) {
-      RCUTILS_SET_ERROR_MSG("failed to allocate memory for string_map keys", allocator)
+    if (capacity > SIZE_MAX / 4 / sizeof(rcutils_string_map_entry_t)) {
+      RCUTILS_SET_ERROR_MSG("requested string_map capacity is too large", allocator)
       return RCUTILS_RET_BAD_ALLOC;
     }
-    string_map->impl->keys = new_keys;
-
-    // resize the values, assigning the result only if it succeeds
-    char ** new_values =
-      allocator.reallocate(string_map->impl->values, capacity * sizeof(char *), allocator.state);
-    if (NULL == new_values) {
-      RCUTILS_SET_ERROR_MSG("failed to allocate memory for string_map values", allocator)
+    // keep the load factor at or below 0.5, using a power of two for the number of buckets
+    size_t bucket_count = 2;
+    while (bucket_count < capacity * 2) {
+      bucket_count *= 2;
+    }
+    size_t * new_buckets = allocator.allocate(bucket_count * sizeof(size_t), allocator.state);
+    if (NULL == new_buckets) {
+      RCUTILS_SET_ERROR_MSG("failed to allocate memory for string_map buckets", allocator)
       return RCUTILS_RET_BAD_ALLOC;
     }
-    string_map->impl->values = new_values;
-
-    // zero out the new memory, if there is any (expanded instead of shrunk)
-    if (capacity > string_map->impl->capacity) {
-      size_t i = string_map->impl->capacity;
-      for (; i < capacity; ++i) {
-        string_map->impl->keys[i] = NULL;
-        string_map->impl->values[i] = NULL;
+
+    // compact the entries first, so that shrinking doesn't cut off any of them
+    // note that realloc when the pointer is NULL is the same as malloc
+    __compact_entries_and_rebuild_buckets(string_map->impl, new_buckets, bucket_count - 1);
+    rcutils_string_map_entry_t * new_entries = allocator.reallocate(
+      string_map->impl->entries, capacity * sizeof(rcutils_string_map_entry_t), allocator.state);
+    if (NULL == new_entries) {
+      allocator.deallocate(new_buckets, allocator.state);
+      // the entries have been moved, so the existing buckets have to be updated
+      if (string_map->impl->buckets) {
+        __compact_entries_and_rebuild_buckets(
+          string_map->impl, string_map->impl->buckets, string_map->impl->bucket_mask);
       }
+      RCUTILS_SET_ERROR_MSG("failed to allocate memory for string_map entries", allocator)
+      return RCUTILS_RET_BAD_ALLOC;
     }
+    string_map->impl->entries = new_entries;
+    allocator.deallocate(string_map->impl->buckets, allocator.state);
+    string_map->impl->buckets = new_buckets;
+    string_map->impl->bucket_mask = bucket_count - 1;
     // falls through to normal function end
   }
   string_map->impl->capacity = capacity;
@@ -202,10 +266,10 @@ static void
 __remove_key_and_value_at_index(rcutils_string_map_impl_t * string_map_impl, size_t index)
 {
   rcutils_allocator_t allocator = string_map_impl->allocator;
-  allocator.deallocate(string_map_impl->keys[index], allocator.state);
-  string_map_impl->keys[index] = NULL;
-  allocator.deallocate(string_map_impl->values[index], allocator.state);
-  string_map_impl->values[index] = NULL;
+  allocator.deallocate(string_map_impl->entries[index].key, allocator.state);
+  string_map_impl->entries[index].key = NULL;
+  allocator.deallocate(string_map_impl->entries[index].value, allocator.state);
+  string_map_impl->entries[index].value = NULL;
   string_map_impl->size--;
 }
 
@@ -218,11 +282,17 @@ rcutils_string_map_clear(rcutils_string_map_t * string_map)
     string_map->impl, "invalid string map",
     return RCUTILS_RET_STRING_MAP_INVALID, rcutils_get_default_allocator())
   size_t i = 0;
-  for (; i < string_map->impl->capacity; ++i) {
-    if (string_map->impl->keys[i] != NULL) {
+  for (; i < string_map->impl->entries_end; ++i) {
+    if (string_map->impl->entries[i].key != NULL) {
       __remove_key_and_value_at_index(string_map->impl, i);
     }
   }
+  string_map->impl->entries_end = 0;
+  if (string_map->impl->buckets) {
+    for (i = 0; i <= string_map->impl->bucket_mask; ++i) {
+      string_map->impl->buckets[i] = RCUTILS_STRING_MAP_BUCKET_EMPTY;
+    }
+  }
   return RCUTILS_RET_OK;
 }
 
@@ -255,28 +325,72 @@ rcutils_string_map_set(rcutils_string_map_t * string_map, const char * key, cons
   return ret;
 }
 
+/// Find the bucket referencing the entry of the key, or the bucket where it would be added.
+/**
+ * \return true if the key exists, with `bucket_index` referencing its entry,
+ * \return false if it doesn't exist, with `bucket_index` being the first
+ *   removed or empty bucket on the probing sequence of the key.
+ */
 static bool
-__get_index_of_key_if_exists(
-  rcutils_string_map_impl_t * string_map_impl,
+__get_bucket_of_key(
+  const rcutils_string_map_impl_t * string_map_impl,
   const char * key,
   size_t key_length,
-  size_t * index)
+  size_t hash,
+  size_t * bucket_index)
 {
-  size_t i = 0;
-  for (; i < string_map_impl->capacity; ++i) {
-    if (NULL == string_map_impl->keys[i]) {
-      continue;
-    }
-    size_t cmp_count = strlen(string_map_impl->keys[i]);
-    if (key_length > cmp_count) {
-      cmp_count = key_length;
+  size_t bucket_mask = string_map_impl->bucket_mask;
+  size_t index = hash & bucket_mask;
+  bool free_bucket_found = false;
+  while (true) {
+    size_t bucket = string_map_impl->buckets[index];
+    if (RCUTILS_STRING_MAP_BUCKET_EMPTY == bucket) {
+      if (!free_bucket_found) {
+        *bucket_index = index;
+      }
+      return false;
     }
-    if (strncmp(key, string_map_impl->keys[i], cmp_count) == 0) {
-      *index = i;
-      return true;
+    if (RCUTILS_STRING_MAP_BUCKET_REMOVED == bucket) {
+      if (!free_bucket_found) {
+        *bucket_index = index;
+        free_bucket_found = true;
+      }
+    } else {
+      const rcutils_string_map_entry_t * entry = &string_map_impl->entries[bucket - 1];
+      if (entry->hash == hash && entry->key_length == key_length &&
+        memcmp(entry->key, key, key_length) == 0)
+      {
+        *bucket_index = index;
+        return true;
+      }
     }
+    index = (index + 1) & bucket_mask;
   }
-  return false;
+}
+
+static bool
+__get_index_of_key_if_exists(
+  const rcutils_string_map_impl_t * string_map_impl,
+  const char * key,
+  size_t key_length,
+  size_t * index)
+{
+  if (0 == string_map_impl->capacity) {
+    return false;
+  }
+  // only consider the key up to its null terminator, if that comes first
+  const char * key_end = memchr(key, '\0', key_length);
+  if (key_end) {
+    key_length = (size_t)(key_end - key);
+  }
+  size_t bucket_index;
+  if (!__get_bucket_of_key(
+      string_map_impl, key, key_length, rcutils_hash_string(key, key_length), &bucket_index))
+  {
+    return false;
+  }
+  *index = string_map_impl->buckets[bucket_index] - 1;
+  return true;
 }
 
 rcutils_ret_t
@@ -294,49 +408,56 @@ rcutils_string_map_set_no_resize(
     key, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(
     value, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
-  rcutils_allocator_t allocator = string_map->impl->allocator;
-  size_t key_index;
-  bool should_free_key_on_error = false;
-  bool key_exists = __get_index_of_key_if_exists(string_map->impl, key, strlen(key), &key_index);
+  rcutils_string_map_impl_t * string_map_impl = string_map->impl;
+  rcutils_allocator_t allocator = string_map_impl->allocator;
+  size_t key_length = strlen(key);
+  size_t hash = rcutils_hash_string(key, key_length);
+  size_t bucket_index = 0;
+  bool key_exists = string_map_impl->capacity > 0 &&
+    __get_bucket_of_key(string_map_impl, key, key_length, hash, &bucket_index);
   if (!key_exists) {
-    // create space for, and store the key if it doesn't exist yet
-    assert(string_map->impl->size <= string_map->impl->capacity);  // defensive, should not happen
-    if (string_map->impl->size == string_map->impl->capacity) {
+    // make sure there is space for the key if it doesn't exist yet
+    assert(string_map_impl->size <= string_map_impl->capacity);  // defensive, should not happen
+    if (string_map_impl->size == string_map_impl->capacity) {
       return RCUTILS_RET_NOT_ENOUGH_SPACE;
     }
-    for (key_index = 0; key_index < string_map->impl->capacity; ++key_index) {
-      if (NULL == string_map->impl->keys[key_index]) {
-        break;
-      }
-    }
-    assert(key_index < string_map->impl->capacity);  // defensive, this should not happen
-    string_map->impl->keys[key_index] = rcutils_strdup(key, allocator);
-    if (NULL == string_map->impl->keys[key_index]) {
-      RCUTILS_SET_ERROR_MSG("failed to allocate memory for key", rcutils_get_default_allocator())
-      return RCUTILS_RET_BAD_ALLOC;
-    }
-    should_free_key_on_error = true;
   }
-  // at this point the key is in the map, waiting for the value to set/overwritten
-  char * original_value = string_map->impl->values[key_index];
   char * new_value = rcutils_strdup(value, allocator);
   if (NULL == new_value) {
-    RCUTILS_SET_ERROR_MSG("failed to allocate memory for key", allocator)
-    if (should_free_key_on_error) {
-      allocator.deallocate(string_map->impl->keys[key_index], allocator.state);
-      string_map->impl->keys[key_index] = NULL;
-    }
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for value", allocator)
     return RCUTILS_RET_BAD_ALLOC;
   }
-  string_map->impl->values[key_index] = new_value;
-  if (original_value != NULL) {
-    // clean up the old value if not NULL
-    allocator.deallocate(original_value, allocator.state);
+  if (key_exists) {
+    // overwrite the value, cleaning up the old one
+    rcutils_string_map_entry_t * entry =
+      &string_map_impl->entries[string_map_impl->buckets[bucket_index] - 1];
+    allocator.deallocate(entry->value, allocator.state);
+    entry->value = new_value;
+    return RCUTILS_RET_OK;
   }
-  if (!key_exists) {
-    // if the key didn't exist, then we had to add it, so increase the size
-    string_map->impl->size++;
+
+  char * new_key = rcutils_strdup(key, allocator);
+  if (NULL == new_key) {
+    RCUTILS_SET_ERROR_MSG("failed to allocate memory for key", rcutils_get_default_allocator())
+    allocator.deallocate(new_value, allocator.state);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  if (string_map_impl->entries_end == string_map_impl->capacity) {
+    // there are removed entries, since the size is less than the capacity, make room at the end
+    __compact_entries_and_rebuild_buckets(
+      string_map_impl, string_map_impl->buckets, string_map_impl->bucket_mask);
+    // the previously found bucket might not be free anymore
+    __get_bucket_of_key(string_map_impl, key, key_length, hash, &bucket_index);
   }
+  size_t entry_index = string_map_impl->entries_end++;
+  rcutils_string_map_entry_t * entry = &string_map_impl->entries[entry_index];
+  entry->key = new_key;
+  entry->value = new_value;
+  entry->key_length = key_length;
+  entry->hash = hash;
+  string_map_impl->buckets[bucket_index] = entry_index + 1;
+  // the key didn't exist, so we had to add it and increase the size
+  string_map_impl->size++;
   return RCUTILS_RET_OK;
 }
 
@@ -350,13 +471,19 @@ rcutils_string_map_unset(rcutils_string_map_t * string_map, const char * key)
     return RCUTILS_RET_STRING_MAP_INVALID, rcutils_get_default_allocator())
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(
     key, RCUTILS_RET_INVALID_ARGUMENT, rcutils_get_default_allocator())
-  rcutils_allocator_t allocator = string_map->impl->allocator;
-  size_t key_index;
-  if (!__get_index_of_key_if_exists(string_map->impl, key, strlen(key), &key_index)) {
+  rcutils_string_map_impl_t * string_map_impl = string_map->impl;
+  rcutils_allocator_t allocator = string_map_impl->allocator;
+  size_t key_length = strlen(key);
+  size_t bucket_index;
+  if (0 == string_map_impl->capacity || !__get_bucket_of_key(
+      string_map_impl, key, key_length, rcutils_hash_string(key, key_length), &bucket_index))
+  {
     RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(allocator, "key '%s' not found", key);
     return RCUTILS_RET_STRING_KEY_NOT_FOUND;
   }
-  __remove_key_and_value_at_index(string_map->impl, key_index);
+  __remove_key_and_value_at_index(string_map_impl, string_map_impl->buckets[bucket_index] - 1);
+  // the entry stays a hole until the next compaction, which bounds the number of removed buckets
+  string_map_impl->buckets[bucket_index] = RCUTILS_STRING_MAP_BUCKET_REMOVED;
   return RCUTILS_RET_OK;
 }
 
@@ -403,7 +530,7 @@ rcutils_string_map_getn(
   }
   size_t key_index;
   if (__get_index_of_key_if_exists(string_map->impl, key, key_length, &key_index)) {
-    return string_map->impl->values[key_index];
+    return string_map->impl->entries[key_index].value;
   }
   return NULL;
 }
@@ -422,26 +549,23 @@ rcutils_string_map_get_next_key(
   size_t start_index = 0;
   if (key != NULL) {
     // if given a key, try to find it
-    bool given_key_found = false;
-    size_t i = 0;
-    for (; i < string_map->impl->capacity; ++i) {
-      if (string_map->impl->keys[i] == key) {
-        given_key_found = true;
-        // given key found at index i, start there + 1
-        start_index = i + 1;
-      }
-    }
-    if (!given_key_found) {
+    size_t key_index;
+    if (
+      !__get_index_of_key_if_exists(string_map->impl, key, strlen(key), &key_index) ||
+      string_map->impl->entries[key_index].key != key)
+    {
       // given key not found, cannot return next key with that
       return NULL;
     }
+    // given key found at index key_index, start there + 1
+    start_index = key_index + 1;
   }
-  // iterate through the storage and look for another non-NULL key to return
+  // iterate through the entries and look for another non-NULL key to return
   size_t i = start_index;
-  for (; i < string_map->impl->capacity; ++i) {
-    if (string_map->impl->keys[i] != NULL) {
+  for (; i < string_map->impl->entries_end; ++i) {
+    if (string_map->impl->entries[i].key != NULL) {
       // next key found, return it
-      return string_map->impl->keys[i];
+      return string_map->impl->entries[i].key;
     }
   }
   // next key (or first key) not found
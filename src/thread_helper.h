@@ -0,0 +1,374 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef THREAD_HELPER_H_
+#define THREAD_HELPER_H_
+
+// Internal helper providing the few threading primitives needed by rcutils.
+
+#if __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+#endif  // _WIN32
+
+#include "rcutils/types/rcutils_ret.h"
+
+/// The signature of a function which can be run in a separate thread.
+typedef void (* rcutils_thread_function_t)(void * arg);
+
+typedef struct rcutils_thread_t
+{
+#ifdef _WIN32
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif  // _WIN32
+  rcutils_thread_function_t function;
+  void * arg;
+} rcutils_thread_t;
+
+#ifdef _WIN32
+static DWORD WINAPI
+__rcutils_thread_trampoline(LPVOID arg)
+{
+  rcutils_thread_t * thread = (rcutils_thread_t *)arg;
+  thread->function(thread->arg);
+  return 0;
+}
+#else
+static void *
+__rcutils_thread_trampoline(void * arg)
+{
+  rcutils_thread_t * thread = (rcutils_thread_t *)arg;
+  thread->function(thread->arg);
+  return NULL;
+}
+#endif  // _WIN32
+
+/// Start a thread running the given function.
+/**
+ * The thread struct must stay valid until rcutils_thread_join() returned.
+ */
+static inline rcutils_ret_t
+rcutils_thread_create(rcutils_thread_t * thread, rcutils_thread_function_t function, void * arg)
+{
+  thread->function = function;
+  thread->arg = arg;
+#ifdef _WIN32
+  thread->handle = CreateThread(NULL, 0, __rcutils_thread_trampoline, thread, 0, NULL);
+  if (NULL == thread->handle) {
+    return RCUTILS_RET_ERROR;
+  }
+#else
+  if (pthread_create(&thread->handle, NULL, __rcutils_thread_trampoline, thread) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+/// Wait for a thread started with rcutils_thread_create() to finish.
+static inline rcutils_ret_t
+rcutils_thread_join(rcutils_thread_t * thread)
+{
+#ifdef _WIN32
+  if (WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) {
+    return RCUTILS_RET_ERROR;
+  }
+  CloseHandle(thread->handle);
+#else
+  if (pthread_join(thread->handle, NULL) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+/// Give up the remainder of the calling thread's time slice.
+static inline void
+rcutils_thread_yield(void)
+{
+#ifdef _WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif  // _WIN32
+}
+
+/// Suspend the calling thread for (at least) the given number of nanoseconds.
+static inline void
+rcutils_thread_sleep_ns(int64_t nanoseconds)
+{
+#ifdef _WIN32
+  // Sleep has a millisecond resolution, round up so that we never busy loop.
+  Sleep((DWORD)((nanoseconds + 999999) / 1000000));
+#else
+  struct timespec duration;
+  duration.tv_sec = (time_t)(nanoseconds / 1000000000);
+  duration.tv_nsec = (long)(nanoseconds % 1000000000);
+  while (nanosleep(&duration, &duration) != 0 && EINTR == errno) {
+    // interrupted by a signal, sleep for the remaining time
+  }
+#endif  // _WIN32
+}
+
+/// Return the id of the calling thread, as shown by the tools of the operating system.
+static inline uint64_t
+rcutils_thread_get_id(void)
+{
+#if defined(_WIN32)
+  return (uint64_t)GetCurrentThreadId();
+#elif defined(__linux__)
+  return (uint64_t)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+  uint64_t id = 0;
+  pthread_threadid_np(NULL, &id);
+  return id;
+#else
+  return (uint64_t)(uintptr_t)pthread_self();
+#endif
+}
+
+typedef struct rcutils_mutex_t
+{
+#ifdef _WIN32
+  SRWLOCK lock;
+#else
+  pthread_mutex_t lock;
+#endif  // _WIN32
+} rcutils_mutex_t;
+
+/// Initialize a mutex with static storage duration, which doesn't need to be finalized.
+#ifdef _WIN32
+# define RCUTILS_MUTEX_INITIALIZER {SRWLOCK_INIT}
+#else
+# define RCUTILS_MUTEX_INITIALIZER {PTHREAD_MUTEX_INITIALIZER}
+#endif  // _WIN32
+
+/// Initialize a mutex, it must be finalized with rcutils_mutex_fini().
+static inline rcutils_ret_t
+rcutils_mutex_init(rcutils_mutex_t * mutex)
+{
+#ifdef _WIN32
+  InitializeSRWLock(&mutex->lock);
+#else
+  if (pthread_mutex_init(&mutex->lock, NULL) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+static inline void
+rcutils_mutex_fini(rcutils_mutex_t * mutex)
+{
+#ifdef _WIN32
+  (void)mutex;
+#else
+  pthread_mutex_destroy(&mutex->lock);
+#endif  // _WIN32
+}
+
+static inline void
+rcutils_mutex_lock(rcutils_mutex_t * mutex)
+{
+#ifdef _WIN32
+  AcquireSRWLockExclusive(&mutex->lock);
+#else
+  pthread_mutex_lock(&mutex->lock);
+#endif  // _WIN32
+}
+
+static inline void
+rcutils_mutex_unlock(rcutils_mutex_t * mutex)
+{
+#ifdef _WIN32
+  ReleaseSRWLockExclusive(&mutex->lock);
+#else
+  pthread_mutex_unlock(&mutex->lock);
+#endif  // _WIN32
+}
+
+typedef struct rcutils_condition_t
+{
+#ifdef _WIN32
+  CONDITION_VARIABLE condition;
+#else
+  pthread_cond_t condition;
+#endif  // _WIN32
+} rcutils_condition_t;
+
+/// Initialize a condition variable, it must be finalized with rcutils_condition_fini().
+static inline rcutils_ret_t
+rcutils_condition_init(rcutils_condition_t * condition)
+{
+#ifdef _WIN32
+  InitializeConditionVariable(&condition->condition);
+#else
+  pthread_condattr_t attributes;
+  if (pthread_condattr_init(&attributes) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#ifndef __APPLE__
+  // Timed waits are measured with the monotonic clock, which isn't changed with the time of day.
+  if (pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) != 0) {
+    pthread_condattr_destroy(&attributes);
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // __APPLE__
+  int result = pthread_cond_init(&condition->condition, &attributes);
+  pthread_condattr_destroy(&attributes);
+  if (result != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+static inline void
+rcutils_condition_fini(rcutils_condition_t * condition)
+{
+#ifdef _WIN32
+  (void)condition;
+#else
+  pthread_cond_destroy(&condition->condition);
+#endif  // _WIN32
+}
+
+/// Wake one of the threads waiting for the condition.
+static inline void
+rcutils_condition_signal(rcutils_condition_t * condition)
+{
+#ifdef _WIN32
+  WakeConditionVariable(&condition->condition);
+#else
+  pthread_cond_signal(&condition->condition);
+#endif  // _WIN32
+}
+
+/// Wake all threads waiting for the condition.
+static inline void
+rcutils_condition_broadcast(rcutils_condition_t * condition)
+{
+#ifdef _WIN32
+  WakeAllConditionVariable(&condition->condition);
+#else
+  pthread_cond_broadcast(&condition->condition);
+#endif  // _WIN32
+}
+
+/// Wait for the condition to be signaled, the mutex must be locked and is locked again on return.
+/**
+ * The wait may also end spuriously, so the caller has to check what it waits for again.
+ */
+static inline void
+rcutils_condition_wait(rcutils_condition_t * condition, rcutils_mutex_t * mutex)
+{
+#ifdef _WIN32
+  SleepConditionVariableSRW(&condition->condition, &mutex->lock, INFINITE, 0);
+#else
+  pthread_cond_wait(&condition->condition, &mutex->lock);
+#endif  // _WIN32
+}
+
+/// Like rcutils_condition_wait(), but give up after (about) the given number of nanoseconds.
+static inline void
+rcutils_condition_timed_wait_ns(
+  rcutils_condition_t * condition, rcutils_mutex_t * mutex, int64_t nanoseconds)
+{
+#if defined(_WIN32)
+  // The timeout has a millisecond resolution, round up so that we never busy loop.
+  SleepConditionVariableSRW(
+    &condition->condition, &mutex->lock, (DWORD)((nanoseconds + 999999) / 1000000), 0);
+#elif defined(__APPLE__)
+  struct timespec duration;
+  duration.tv_sec = (time_t)(nanoseconds / 1000000000);
+  duration.tv_nsec = (long)(nanoseconds % 1000000000);
+  pthread_cond_timedwait_relative_np(&condition->condition, &mutex->lock, &duration);
+#else
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  int64_t deadline_ns = (int64_t)deadline.tv_nsec + nanoseconds % 1000000000;
+  deadline.tv_sec += (time_t)(nanoseconds / 1000000000 + deadline_ns / 1000000000);
+  deadline.tv_nsec = (long)(deadline_ns % 1000000000);
+  pthread_cond_timedwait(&condition->condition, &mutex->lock, &deadline);
+#endif
+}
+
+#ifdef _WIN32
+# define RCUTILS_THREAD_KEY_DESTRUCTOR_CALL WINAPI
+typedef DWORD rcutils_thread_key_t;
+#else
+# define RCUTILS_THREAD_KEY_DESTRUCTOR_CALL
+typedef pthread_key_t rcutils_thread_key_t;
+#endif  // _WIN32
+
+/// The signature of a function which is called with a thread's non-NULL key value at its exit.
+typedef void (RCUTILS_THREAD_KEY_DESTRUCTOR_CALL * rcutils_thread_key_destructor_t)(void * value);
+
+/// Create a key to associate a value with each thread.
+static inline rcutils_ret_t
+rcutils_thread_key_create(rcutils_thread_key_t * key, rcutils_thread_key_destructor_t destructor)
+{
+#ifdef _WIN32
+  // Fiber local storage is used since only it supports a callback at thread exit.
+  *key = FlsAlloc(destructor);
+  if (FLS_OUT_OF_INDEXES == *key) {
+    return RCUTILS_RET_ERROR;
+  }
+#else
+  if (pthread_key_create(key, destructor) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+/// Set the value associated with the key for the calling thread.
+static inline rcutils_ret_t
+rcutils_thread_key_set(rcutils_thread_key_t key, void * value)
+{
+#ifdef _WIN32
+  if (!FlsSetValue(key, value)) {
+    return RCUTILS_RET_ERROR;
+  }
+#else
+  if (pthread_setspecific(key, value) != 0) {
+    return RCUTILS_RET_ERROR;
+  }
+#endif  // _WIN32
+  return RCUTILS_RET_OK;
+}
+
+#if __cplusplus
+}
+#endif
+
+#endif  // THREAD_HELPER_H_
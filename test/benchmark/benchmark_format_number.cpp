@@ -0,0 +1,107 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+#include "rcutils/format_number.h"
+#include "rcutils/snprintf.h"
+
+// A typical line number and a time in nanoseconds, which change a bit in each iteration.
+static const uint64_t g_line_number = 1234u;
+static const int64_t g_time = 1524165462123456789LL;
+
+static void BM_snprintf_uint64(benchmark::State & state)
+{
+  char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  uint64_t value = g_line_number;
+  for (auto _ : state) {
+    int written = rcutils_snprintf(
+      buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value++));
+    benchmark::DoNotOptimize(written);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_snprintf_uint64);
+
+static void BM_format_uint64(benchmark::State & state)
+{
+  char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  uint64_t value = g_line_number;
+  for (auto _ : state) {
+    size_t written = rcutils_format_uint64(value++, buffer);
+    benchmark::DoNotOptimize(written);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_format_uint64);
+
+static void BM_snprintf_time_as_nanoseconds(benchmark::State & state)
+{
+  char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  int64_t value = g_time;
+  for (auto _ : state) {
+    int written = rcutils_snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+    value += 1000;
+    benchmark::DoNotOptimize(written);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_snprintf_time_as_nanoseconds);
+
+static void BM_format_time_as_nanoseconds(benchmark::State & state)
+{
+  char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+  int64_t value = g_time;
+  for (auto _ : state) {
+    size_t written = rcutils_format_int64(value, buffer);
+    value += 1000;
+    benchmark::DoNotOptimize(written);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_format_time_as_nanoseconds);
+
+static void BM_strftime_iso8601(benchmark::State & state)
+{
+  char buffer[64];
+  int64_t value = g_time;
+  for (auto _ : state) {
+    time_t seconds = static_cast<time_t>(value / 1000000000);
+    struct tm * calendar_time = gmtime(&seconds);
+    size_t written = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", calendar_time);
+    rcutils_snprintf(
+      buffer + written, sizeof(buffer) - written, ".%09lldZ",
+      static_cast<long long>(value % 1000000000));
+    value += 1000;
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_strftime_iso8601);
+
+static void BM_format_time_iso8601(benchmark::State & state)
+{
+  char buffer[RCUTILS_FORMAT_TIME_ISO8601_LENGTH + 1];
+  int64_t value = g_time;
+  for (auto _ : state) {
+    size_t written = rcutils_format_time_iso8601(value, buffer);
+    value += 1000;
+    benchmark::DoNotOptimize(written);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_format_time_iso8601);
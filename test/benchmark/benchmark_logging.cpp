@@ -0,0 +1,270 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+# include <io.h>
+# define dup _dup
+# define dup2 _dup2
+# define close _close
+# define fileno _fileno
+static const char * g_null_device = "NUL";
+#else
+# include <unistd.h>
+static const char * g_null_device = "/dev/null";
+#endif
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_async.h"
+#include "rcutils/logging_binary.h"
+#include "rcutils/logging_file.h"
+#include "rcutils/logging_flight_recorder.h"
+#include "rcutils/logging_macros.h"
+
+static const char * g_file_path = "benchmark_logging.log";
+
+static void noop_output_handler(
+  const rcutils_log_location_t *, int, const char *, const char *, va_list *)
+{
+}
+
+enum OutputHandler
+{
+  NOOP_OUTPUT_HANDLER,
+  CONSOLE_OUTPUT_HANDLER,
+  FILE_OUTPUT_HANDLER,
+  BINARY_OUTPUT_HANDLER,
+  ASYNC_OUTPUT_HANDLER,
+};
+
+/// Set up the logging system with an output handler, with stdout redirected to the null device.
+class LoggingFixture : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State & state) override
+  {
+    // The threads of multi-threaded benchmarks wait for each other before and after the loop.
+    if (state.thread_index() != 0) {
+      return;
+    }
+    if (rcutils_logging_initialize() != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+      return;
+    }
+    fflush(stdout);
+    saved_stdout = dup(fileno(stdout));
+    FILE * null_device = fopen(g_null_device, "w");
+    if (null_device) {
+      dup2(fileno(null_device), fileno(stdout));
+      fclose(null_device);
+    }
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+  }
+
+  void TearDown(const benchmark::State & state) override
+  {
+    if (state.thread_index() != 0) {
+      return;
+    }
+    if (rcutils_logging_async_stop() != RCUTILS_RET_OK ||
+      rcutils_logging_file_close() != RCUTILS_RET_OK ||
+      rcutils_logging_binary_close() != RCUTILS_RET_OK)
+    {
+      rcutils_reset_error();
+    }
+    rcutils_logging_set_output_handler(previous_output_handler);
+    if (rcutils_logging_shutdown() != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+    std::remove(g_file_path);
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+      dup2(saved_stdout, fileno(stdout));
+      close(saved_stdout);
+    }
+  }
+
+  void set_output_handler(const benchmark::State & state, OutputHandler output_handler)
+  {
+    if (state.thread_index() != 0) {
+      return;
+    }
+    rcutils_ret_t ret = RCUTILS_RET_OK;
+    switch (output_handler) {
+      case NOOP_OUTPUT_HANDLER:
+        rcutils_logging_set_output_handler(noop_output_handler);
+        break;
+      case CONSOLE_OUTPUT_HANDLER:
+        rcutils_logging_set_output_handler(rcutils_logging_console_output_handler);
+        break;
+      case FILE_OUTPUT_HANDLER: {
+          rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+          options.file_path = g_file_path;
+          // Keep the disk usage bounded during long runs.
+          options.max_file_size = 64 * 1024 * 1024;
+          options.max_rotated_files = 0;
+          ret = rcutils_logging_file_open(&options);
+          rcutils_logging_set_output_handler(rcutils_logging_file_output_handler);
+          break;
+        }
+      case BINARY_OUTPUT_HANDLER: {
+          rcutils_logging_binary_options_t options = rcutils_logging_binary_get_default_options();
+          options.file_path = g_file_path;
+          ret = rcutils_logging_binary_open(&options);
+          rcutils_logging_set_output_handler(rcutils_logging_binary_output_handler);
+          break;
+        }
+      case ASYNC_OUTPUT_HANDLER:
+        rcutils_logging_set_output_handler(rcutils_logging_console_output_handler);
+        ret = rcutils_logging_async_start(NULL);
+        break;
+    }
+    if (ret != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+  }
+
+protected:
+  int saved_stdout = -1;
+  rcutils_logging_output_handler_t previous_output_handler = NULL;
+};
+
+// The cost of a statement below the level of its logger.
+BENCHMARK_DEFINE_F(LoggingFixture, disabled_statement)(benchmark::State & state)
+{
+  set_output_handler(state, NOOP_OUTPUT_HANDLER);
+  int i = 0;
+  for (auto _ : state) {
+    RCUTILS_LOG_DEBUG_NAMED("benchmark.logger", "message %d", i++);
+  }
+}
+BENCHMARK_REGISTER_F(LoggingFixture, disabled_statement)->ThreadRange(1, 8);
+
+// The cost of a statement below the level of its logger which is given by its handle.
+BENCHMARK_DEFINE_F(LoggingFixture, disabled_statement_logger)(benchmark::State & state)
+{
+  set_output_handler(state, NOOP_OUTPUT_HANDLER);
+  rcutils_logger_t * logger = rcutils_logging_get_logger("benchmark.logger");
+  int i = 0;
+  for (auto _ : state) {
+    RCUTILS_LOG_DEBUG_LOGGER(logger, "message %d", i++);
+  }
+}
+BENCHMARK_REGISTER_F(LoggingFixture, disabled_statement_logger)->ThreadRange(1, 8);
+
+// The cost of a statement below the level of its logger which is kept by the flight recorder.
+BENCHMARK_DEFINE_F(LoggingFixture, recorded_statement)(benchmark::State & state)
+{
+  set_output_handler(state, NOOP_OUTPUT_HANDLER);
+  if (state.thread_index() == 0) {
+    rcutils_logging_flight_recorder_options_t options =
+      rcutils_logging_flight_recorder_get_default_options();
+    options.file_path = g_file_path;
+    options.dump_on_fatal = false;
+    options.dump_on_signal = false;
+    if (rcutils_logging_flight_recorder_start(&options) != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+  }
+  int i = 0;
+  for (auto _ : state) {
+    RCUTILS_LOG_DEBUG_NAMED("benchmark.logger", "message %d with %s", i++, "an argument");
+  }
+}
+BENCHMARK_REGISTER_F(LoggingFixture, recorded_statement)->ThreadRange(1, 8)->UseRealTime();
+
+// The cost of an enabled statement for each output handler.
+#define DEFINE_ENABLED_STATEMENT_BENCHMARK(name, output_handler) \
+  BENCHMARK_DEFINE_F(LoggingFixture, name)(benchmark::State & state) \
+  { \
+    set_output_handler(state, output_handler); \
+    int i = 0; \
+    for (auto _ : state) { \
+      RCUTILS_LOG_INFO_NAMED("benchmark.logger", "message %d with %s", i++, "an argument"); \
+    } \
+  } \
+  BENCHMARK_REGISTER_F(LoggingFixture, name)->ThreadRange(1, 8)->UseRealTime()
+
+DEFINE_ENABLED_STATEMENT_BENCHMARK(enabled_statement_noop, NOOP_OUTPUT_HANDLER);
+DEFINE_ENABLED_STATEMENT_BENCHMARK(enabled_statement_console, CONSOLE_OUTPUT_HANDLER);
+DEFINE_ENABLED_STATEMENT_BENCHMARK(enabled_statement_file, FILE_OUTPUT_HANDLER);
+DEFINE_ENABLED_STATEMENT_BENCHMARK(enabled_statement_binary, BINARY_OUTPUT_HANDLER);
+DEFINE_ENABLED_STATEMENT_BENCHMARK(enabled_statement_async, ASYNC_OUTPUT_HANDLER);
+
+// The cost of formatting and writing long messages to the console.
+BENCHMARK_DEFINE_F(LoggingFixture, long_message)(benchmark::State & state)
+{
+  set_output_handler(state, CONSOLE_OUTPUT_HANDLER);
+  const std::string argument(static_cast<size_t>(state.range(0)), 'x');
+  for (auto _ : state) {
+    RCUTILS_LOG_INFO_NAMED("benchmark.logger", "long message: %s", argument.c_str());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK_REGISTER_F(LoggingFixture, long_message)->RangeMultiplier(8)->Range(64, 256 * 1024);
+
+// The cost of resolving the effective level, by the depth of the logger name and the number of
+// loggers with a level.
+BENCHMARK_DEFINE_F(LoggingFixture, effective_level)(benchmark::State & state)
+{
+  const int64_t depth = state.range(0);
+  const int64_t loggers = state.range(1);
+  for (int64_t i = 0; i < loggers; ++i) {
+    std::string logger_name = "configured_" + std::to_string(i);
+    if (rcutils_logging_set_logger_level(logger_name.c_str(), RCUTILS_LOG_SEVERITY_WARN) !=
+      RCUTILS_RET_OK)
+    {
+      rcutils_reset_error();
+    }
+  }
+  // Only the root of the hierarchy has a level, so that all ancestors are visited.
+  if (rcutils_logging_set_logger_level("benchmark", RCUTILS_LOG_SEVERITY_WARN) !=
+    RCUTILS_RET_OK)
+  {
+    rcutils_reset_error();
+  }
+  std::string name = "benchmark";
+  for (int64_t i = 1; i < depth; ++i) {
+    name += ".child_" + std::to_string(i);
+  }
+  for (auto _ : state) {
+    int level = rcutils_logging_get_logger_effective_level(name.c_str());
+    benchmark::DoNotOptimize(level);
+  }
+}
+BENCHMARK_REGISTER_F(LoggingFixture, effective_level)
+->ArgNames({"depth", "loggers"})
+->ArgsProduct({{1, 4, 16}, {0, 100, 10000}});
+
+// The cost of resolving the effective level of a logger handle, which is cached until any
+// logger level changes.
+BENCHMARK_DEFINE_F(LoggingFixture, effective_level_logger)(benchmark::State & state)
+{
+  std::string name = "benchmark";
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    name += ".child_" + std::to_string(i);
+  }
+  rcutils_logger_t * logger = rcutils_logging_get_logger(name.c_str());
+  for (auto _ : state) {
+    int level = rcutils_logger_get_effective_level(logger);
+    benchmark::DoNotOptimize(level);
+  }
+}
+BENCHMARK_REGISTER_F(LoggingFixture, effective_level_logger)->ArgName("depth")->Arg(1)->Arg(16);
@@ -0,0 +1,104 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/types/string_map.h"
+
+class StringMapFixture : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State & state) override
+  {
+    const size_t num_keys = static_cast<size_t>(state.range(0));
+    string_map = rcutils_get_zero_initialized_string_map();
+    if (rcutils_string_map_init(&string_map, 0, rcutils_get_default_allocator()) !=
+      RCUTILS_RET_OK)
+    {
+      rcutils_reset_error();
+      return;
+    }
+    keys.clear();
+    for (size_t i = 0; i < num_keys; ++i) {
+      keys.push_back("node" + std::to_string(i) + ".parameter_name");
+      if (rcutils_string_map_set(&string_map, keys.back().c_str(), "value") != RCUTILS_RET_OK) {
+        rcutils_reset_error();
+      }
+    }
+  }
+
+  void TearDown(const benchmark::State &) override
+  {
+    if (rcutils_string_map_fini(&string_map) != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+  }
+
+protected:
+  rcutils_string_map_t string_map;
+  std::vector<std::string> keys;
+};
+
+BENCHMARK_DEFINE_F(StringMapFixture, get_existing)(benchmark::State & state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    const char * value = rcutils_string_map_get(&string_map, keys[i].c_str());
+    benchmark::DoNotOptimize(value);
+    if (++i == keys.size()) {
+      i = 0;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(StringMapFixture, get_existing)->Arg(10)->Arg(1000)->Arg(10000)->Arg(100000);
+
+BENCHMARK_DEFINE_F(StringMapFixture, get_missing)(benchmark::State & state) {
+  for (auto _ : state) {
+    const char * value = rcutils_string_map_get(&string_map, "node.missing_parameter_name");
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK_REGISTER_F(StringMapFixture, get_missing)->Arg(10)->Arg(1000)->Arg(10000)->Arg(100000);
+
+BENCHMARK_DEFINE_F(StringMapFixture, set_existing)(benchmark::State & state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    if (rcutils_string_map_set(&string_map, keys[i].c_str(), "other_value") != RCUTILS_RET_OK) {
+      state.SkipWithError(rcutils_get_error_string_safe());
+      rcutils_reset_error();
+      break;
+    }
+    if (++i == keys.size()) {
+      i = 0;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(StringMapFixture, set_existing)->Arg(10)->Arg(1000)->Arg(10000)->Arg(100000);
+
+BENCHMARK_DEFINE_F(StringMapFixture, set_and_unset)(benchmark::State & state) {
+  for (auto _ : state) {
+    if (rcutils_string_map_set(&string_map, "node.new_parameter_name", "value") !=
+      RCUTILS_RET_OK ||
+      rcutils_string_map_unset(&string_map, "node.new_parameter_name") != RCUTILS_RET_OK)
+    {
+      state.SkipWithError(rcutils_get_error_string_safe());
+      rcutils_reset_error();
+      break;
+    }
+  }
+}
+BENCHMARK_REGISTER_F(StringMapFixture, set_and_unset)->Arg(10)->Arg(1000)->Arg(10000)->Arg(100000);
@@ -0,0 +1,101 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "rcutils/format_number.h"
+
+TEST(test_format_number, format_uint64) {
+  std::vector<uint64_t> values = {0u, 1u, 9u, 10u, 99u, 100u, 101u, 999u, 1000u, UINT64_MAX};
+  for (uint64_t value = 1; value < UINT64_MAX / 7; value = value * 7 + 3) {
+    values.push_back(value);
+  }
+  for (uint64_t value : values) {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%llu", static_cast<unsigned long long>(value));
+    char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+    EXPECT_EQ(strlen(expected), rcutils_format_uint64(value, buffer));
+    EXPECT_STREQ(expected, buffer);
+  }
+}
+
+TEST(test_format_number, format_int64) {
+  std::vector<int64_t> values = {0, 1, -1, 10, -10, -99, -100, INT64_MAX, INT64_MIN};
+  for (int64_t value = 1; value < INT64_MAX / 7; value = value * 7 + 3) {
+    values.push_back(value);
+    values.push_back(-value);
+  }
+  for (int64_t value : values) {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%lld", static_cast<long long>(value));
+    char buffer[RCUTILS_FORMAT_INT64_MAX_LENGTH + 1];
+    EXPECT_EQ(strlen(expected), rcutils_format_int64(value, buffer));
+    EXPECT_STREQ(expected, buffer);
+  }
+}
+
+TEST(test_format_number, format_uint64_fixed) {
+  char buffer[16];
+  memset(buffer, 'x', sizeof(buffer));
+  rcutils_format_uint64_fixed(42u, 9, buffer);
+  EXPECT_EQ("000000042x", std::string(buffer, 10));
+  rcutils_format_uint64_fixed(123456789u, 9, buffer);
+  EXPECT_EQ("123456789x", std::string(buffer, 10));
+  // Digits which don't fit are dropped.
+  rcutils_format_uint64_fixed(12345u, 3, buffer);
+  EXPECT_EQ("345", std::string(buffer, 3));
+  rcutils_format_uint64_fixed(7u, 1, buffer);
+  EXPECT_EQ("7", std::string(buffer, 1));
+  memset(buffer, 'x', sizeof(buffer));
+  rcutils_format_uint64_fixed(7u, 0, buffer);
+  EXPECT_EQ('x', buffer[0]);
+}
+
+TEST(test_format_number, format_time_iso8601) {
+  char buffer[RCUTILS_FORMAT_TIME_ISO8601_LENGTH + 1];
+  EXPECT_EQ(RCUTILS_FORMAT_TIME_ISO8601_LENGTH, rcutils_format_time_iso8601(0, buffer));
+  EXPECT_STREQ("1970-01-01T00:00:00.000000000Z", buffer);
+  rcutils_format_time_iso8601(-1, buffer);
+  EXPECT_STREQ("1969-12-31T23:59:59.999999999Z", buffer);
+  rcutils_format_time_iso8601(951782400123456789LL, buffer);
+  EXPECT_STREQ("2000-02-29T00:00:00.123456789Z", buffer);
+  rcutils_format_time_iso8601(INT64_MAX, buffer);
+  EXPECT_STREQ("2262-04-11T23:47:16.854775807Z", buffer);
+  rcutils_format_time_iso8601(INT64_MIN, buffer);
+  EXPECT_STREQ("1677-09-21T00:12:43.145224192Z", buffer);
+
+  // Compare the dates with gmtime() for one time of each day over more than 400 years.
+  const int64_t seconds_per_day = 24 * 60 * 60;
+  for (int64_t day = -106000; day < 106000; ++day) {
+    int64_t seconds = day * seconds_per_day + (day * 4567) % seconds_per_day;
+    time_t time = static_cast<time_t>(seconds);
+    if (static_cast<int64_t>(time) != seconds) {
+      continue;
+    }
+    struct tm * calendar_time = gmtime(&time);
+    if (!calendar_time) {
+      continue;
+    }
+    char expected[64];
+    strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%S", calendar_time);
+    rcutils_format_time_iso8601(seconds * 1000000000LL + 5, buffer);
+    ASSERT_EQ(std::string(expected) + ".000000005Z", buffer) << seconds;
+  }
+}
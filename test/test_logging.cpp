@@ -14,7 +14,9 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "rcutils/logging.h"
@@ -231,4 +233,406 @@ TEST(CLASSNAME(TestLogging, RMW_IMPLEMENTATION), test_logger_severity_hierarchy)
   EXPECT_EQ(
     rcutils_test_logging_cpp_dot_severity,
     rcutils_logging_get_logger_effective_level("rcutils_test_logging_cpp.."));
+
+  // check that setting the level of a descendant doesn't set the levels of its ancestors
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_deep.a.b.c", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_UNSET, rcutils_logging_get_logger_level("rcutils_test_deep.a.b"));
+  EXPECT_EQ(
+    rcutils_logging_get_default_logger_level(),
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b"));
+  EXPECT_EQ(
+    rcutils_logging_get_default_logger_level(),
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b.cd"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b.c.d"));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_deep.a", RCUTILS_LOG_SEVERITY_WARN));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_WARN,
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b.c"));
+  // unsetting the level of a logger makes it inherit the level of its ancestors again
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_deep.a.b.c", RCUTILS_LOG_SEVERITY_UNSET));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_WARN,
+    rcutils_logging_get_logger_effective_level("rcutils_test_deep.a.b.c"));
+
+  // check a large number of siblings, which grows the children of a node several times
+  for (int i = 0; i < 1000; ++i) {
+    std::string name = "rcutils_test_siblings.child_" + std::to_string(i);
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rcutils_logging_set_logger_level(
+        name.c_str(), i % 2 ? RCUTILS_LOG_SEVERITY_ERROR : RCUTILS_LOG_SEVERITY_DEBUG));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    std::string name = "rcutils_test_siblings.child_" + std::to_string(i) + ".grandchild";
+    EXPECT_EQ(
+      i % 2 ? RCUTILS_LOG_SEVERITY_ERROR : RCUTILS_LOG_SEVERITY_DEBUG,
+      rcutils_logging_get_logger_effective_level(name.c_str()));
+  }
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
+
+TEST(CLASSNAME(TestLogging, RMW_IMPLEMENTATION), test_logger_is_enabled_for_cache) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+  rcutils_log_level_cache_t cache = {0, 0};
+  const char * name = "rcutils_test_location.child";
+
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_DEBUG));
+  const uint64_t cached_name = cache.logger_name;
+  EXPECT_NE(0u, cached_name);
+  EXPECT_NE(0u, cache.logger_level);
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_INFO));
+
+  // setting the level of an ancestor invalidates the cached level
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_location", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_DEBUG));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level(name, RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_WARN));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_ERROR));
+
+  // the default level is used even when it is changed directly
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level(name, RCUTILS_LOG_SEVERITY_UNSET));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_location", RCUTILS_LOG_SEVERITY_UNSET));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_DEBUG));
+  g_rcutils_logging_default_logger_level = RCUTILS_LOG_SEVERITY_DEBUG;
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_DEBUG));
+  g_rcutils_logging_default_logger_level = RCUTILS_LOG_SEVERITY_INFO;
+
+  // other logger names are not cached but still resolved
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_location2", RCUTILS_LOG_SEVERITY_FATAL));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, "rcutils_test_location2", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(cached_name, cache.logger_name);
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_INFO));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, NULL, RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      NULL, name, RCUTILS_LOG_SEVERITY_INFO));
+
+  // the cache is bound to the contents of the name rather than its address
+  char buffer[] = "rcutils_test_location.child";
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, buffer, RCUTILS_LOG_SEVERITY_INFO));
+  rcutils_log_level_cache_t buffer_cache = {0, 0};
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &buffer_cache, buffer, RCUTILS_LOG_SEVERITY_INFO));
+  snprintf(buffer, sizeof(buffer), "%s", "rcutils_test_location2");
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &buffer_cache, buffer, RCUTILS_LOG_SEVERITY_ERROR));
+
+  // restarting the logging system invalidates the cached level
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level(name, RCUTILS_LOG_SEVERITY_FATAL));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_ERROR));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, name, RCUTILS_LOG_SEVERITY_ERROR));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
+
+TEST(CLASSNAME(TestLogging, RMW_IMPLEMENTATION), test_set_logger_levels) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+
+  const size_t count = 500;
+  std::vector<std::string> name_strings;
+  std::vector<const char *> names;
+  std::vector<int> levels;
+  for (size_t i = 0; i < count; ++i) {
+    name_strings.push_back("rcutils_test_levels.logger" + std::to_string(i));
+  }
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(name_strings[i].c_str());
+    levels.push_back(i % 2 ? RCUTILS_LOG_SEVERITY_ERROR : RCUTILS_LOG_SEVERITY_DEBUG);
+  }
+  names.push_back("");
+  levels.push_back(RCUTILS_LOG_SEVERITY_WARN);
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_levels(names.data(), levels.data(), names.size()));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, rcutils_logging_get_default_logger_level());
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_EQ(levels[i], rcutils_logging_get_logger_level(names[i]));
+    EXPECT_EQ(levels[i], rcutils_logging_get_logger_effective_level(
+        (name_strings[i] + ".child").c_str()));
+  }
+  // the names don't need to be null terminated
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_leveln("rcutils_test_levels.logger10.child", 28));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_UNSET,
+    rcutils_logging_get_logger_leveln("rcutils_test_levels.logger10.child", 26));
+
+  // overwrite existing levels
+  const char * overwrite_names[] = {"rcutils_test_levels.logger0", "rcutils_test_levels.logger1"};
+  int overwrite_levels[] = {RCUTILS_LOG_SEVERITY_FATAL, RCUTILS_LOG_SEVERITY_UNSET};
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_levels(overwrite_names, overwrite_levels, 2));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_FATAL, rcutils_logging_get_logger_level(overwrite_names[0]));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_UNSET, rcutils_logging_get_logger_level(overwrite_names[1]));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_WARN,
+    rcutils_logging_get_logger_effective_level(overwrite_names[1]));
+
+  // the levels are set until the first invalid one
+  const char * invalid_names[] = {"rcutils_test_levels.a", "rcutils_test_levels.b", NULL};
+  int invalid_levels[] = {RCUTILS_LOG_SEVERITY_ERROR, 42, RCUTILS_LOG_SEVERITY_ERROR};
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_set_logger_levels(invalid_names, invalid_levels, 3));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_ERROR, rcutils_logging_get_logger_level(invalid_names[0]));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_UNSET, rcutils_logging_get_logger_level(invalid_names[1]));
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_set_logger_levels(&invalid_names[2], &invalid_levels[2], 1));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_set_logger_levels(NULL, NULL, 1));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_levels(NULL, NULL, 0));
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
+
+TEST(CLASSNAME(TestLogging, RMW_IMPLEMENTATION), test_concurrent_logger_levels) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+
+  // readers only ever see the levels of complete snapshots while writers set levels
+  std::atomic<bool> done(false);
+  std::atomic<size_t> unexpected_levels(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; ++r) {
+    readers.emplace_back([&done, &unexpected_levels]() {
+        while (!done) {
+          int level = rcutils_logging_get_logger_effective_level("concurrent.a.b.c");
+          if (level != RCUTILS_LOG_SEVERITY_INFO && level != RCUTILS_LOG_SEVERITY_DEBUG &&
+          level != RCUTILS_LOG_SEVERITY_ERROR)
+          {
+            ++unexpected_levels;
+          }
+          level = rcutils_logging_get_logger_level("concurrent.a");
+          if (level != RCUTILS_LOG_SEVERITY_UNSET && level != RCUTILS_LOG_SEVERITY_DEBUG &&
+          level != RCUTILS_LOG_SEVERITY_ERROR)
+          {
+            ++unexpected_levels;
+          }
+        }
+      });
+  }
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 2; ++w) {
+    writers.emplace_back([w]() {
+        for (int i = 0; i < 50; ++i) {
+          // the tables of the nodes grow while they are read
+          std::string name = "concurrent.a.logger" + std::to_string(w) + "_" + std::to_string(i);
+          const char * names[] = {"concurrent.a", name.c_str()};
+          int levels[] = {
+            i % 2 ? RCUTILS_LOG_SEVERITY_ERROR : RCUTILS_LOG_SEVERITY_DEBUG,
+            RCUTILS_LOG_SEVERITY_WARN};
+          EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_levels(names, levels, 2));
+          EXPECT_EQ(
+            RCUTILS_RET_OK,
+            rcutils_logging_set_logger_level_pattern("concurrent.*.b", levels[0]));
+        }
+      });
+  }
+  for (auto & writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto & reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0u, unexpected_levels);
+  for (int w = 0; w < 2; ++w) {
+    for (int i = 0; i < 50; ++i) {
+      std::string name = "concurrent.a.logger" + std::to_string(w) + "_" + std::to_string(i);
+      EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, rcutils_logging_get_logger_level(name.c_str()));
+    }
+  }
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
+
+TEST(CLASSNAME(TestLogging, RMW_IMPLEMENTATION), test_logger_level_patterns) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+
+  // a single segment wildcard
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("planner.*.costmap", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("planner.local.costmap.layer"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_INFO,
+    rcutils_logging_get_logger_effective_level("planner.costmap"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_INFO,
+    rcutils_logging_get_logger_effective_level("planner.a.b.costmap"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_INFO,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap2"));
+  // the level of the pattern isn't the level of a logger
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_UNSET,
+    rcutils_logging_get_logger_level("planner.global.costmap"));
+
+  // a wildcard for any number of segments, including none
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("controller.**.debug", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("controller.debug"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("controller.a.b.c.debug"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_INFO,
+    rcutils_logging_get_logger_effective_level("controller.a.b.c"));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("**.noisy", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_ERROR, rcutils_logging_get_logger_effective_level("noisy"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("a.noisy.b"));
+  // segments with other characters next to a wildcard only match themselves
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("prefix*", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, rcutils_logging_get_logger_effective_level("prefix_a"));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_ERROR, rcutils_logging_get_logger_effective_level("prefix*"));
+
+  // the closest match wins, and the level set by name wins at the same depth
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("planner", RCUTILS_LOG_SEVERITY_WARN));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("planner.global.costmap.layer", RCUTILS_LOG_SEVERITY_FATAL));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_FATAL,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap.layer"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_WARN,
+    rcutils_logging_get_logger_effective_level("planner.global"));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("planner.local.costmap", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("planner.local.costmap"));
+
+  // the pattern set last wins at the same depth, and unset patterns are ignored
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("planner.global.*", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("planner.*.costmap", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("planner.*.costmap", RCUTILS_LOG_SEVERITY_UNSET));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_ERROR,
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+
+  // the cached levels are updated when a pattern is set
+  rcutils_log_level_cache_t cache = {0, 0};
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, "cached.logger", RCUTILS_LOG_SEVERITY_DEBUG));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("cached.*", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for_cache(
+      &cache, "cached.logger", RCUTILS_LOG_SEVERITY_DEBUG));
+
+  // many patterns which match at the same time
+  const char * segments[] = {"a", "b", "c", "d", "e"};
+  for (int combination = 0; combination < 32; ++combination) {
+    std::string pattern = "wide";
+    for (int i = 0; i < 5; ++i) {
+      pattern += std::string(".") + (combination & (1 << i) ? "*" : segments[i]);
+    }
+    int level = combination == 13 ? RCUTILS_LOG_SEVERITY_ERROR : RCUTILS_LOG_SEVERITY_WARN;
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level_pattern(pattern.c_str(), level));
+  }
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level_pattern("wide.a.*.c.d.e", RCUTILS_LOG_SEVERITY_FATAL));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_FATAL,
+    rcutils_logging_get_logger_effective_level("wide.a.b.c.d.e"));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_WARN,
+    rcutils_logging_get_logger_effective_level("wide.x.y.z.w.v"));
+
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_set_logger_level_pattern(NULL, RCUTILS_LOG_SEVERITY_DEBUG));
+  rcutils_reset_error();
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_set_logger_level_pattern("", RCUTILS_LOG_SEVERITY_DEBUG));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_set_logger_level_pattern("a.*", 1000));
+  rcutils_reset_error();
+
+  // patterns are cleared on logging restart
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  EXPECT_EQ(
+    rcutils_logging_get_default_logger_level(),
+    rcutils_logging_get_logger_effective_level("planner.global.costmap"));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
 }
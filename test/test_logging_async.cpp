@@ -0,0 +1,279 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_async.h"
+
+struct LogEvent
+{
+  int level;
+  std::string name;
+  std::string message;
+  std::string function_name;
+  size_t line_number;
+};
+
+std::mutex g_log_events_mutex;
+std::vector<LogEvent> g_log_events;
+std::atomic<bool> g_block_output_handler(false);
+std::atomic<size_t> g_blocked_calls(0);
+
+void record_output_handler(
+  const rcutils_log_location_t * location,
+  int level, const char * name, const char * format, va_list * args)
+{
+  if (g_block_output_handler) {
+    ++g_blocked_calls;
+    while (g_block_output_handler) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  LogEvent event;
+  event.level = level;
+  event.name = name;
+  char buffer[2048];
+  vsnprintf(buffer, sizeof(buffer), format, *args);
+  event.message = buffer;
+  event.function_name = location ? location->function_name : "";
+  event.line_number = location ? location->line_number : 0u;
+  std::lock_guard<std::mutex> lock(g_log_events_mutex);
+  g_log_events.push_back(event);
+}
+
+class TestLoggingAsync : public ::testing::Test
+{
+public:
+  rcutils_logging_output_handler_t previous_output_handler;
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_DEBUG);
+    this->previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(record_output_handler);
+    g_log_events.clear();
+    g_block_output_handler = false;
+    g_blocked_calls = 0;
+  }
+
+  void TearDown()
+  {
+    g_block_output_handler = false;
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+    rcutils_logging_set_output_handler(this->previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  }
+
+  // Block the output handler on the first record, so that the queue fills up.
+  void block_output_handler()
+  {
+    g_block_output_handler = true;
+    rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "name", "blocking");
+    while (0u == g_blocked_calls) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+};
+
+TEST_F(TestLoggingAsync, test_start_stop) {
+  EXPECT_FALSE(rcutils_logging_async_is_enabled());
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.queue_capacity = 0;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_async_start(&options));
+  rcutils_reset_error();
+  options = rcutils_logging_async_get_default_options();
+  options.overflow_policy = static_cast<rcutils_logging_async_overflow_policy_t>(42);
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_async_start(&options));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_async_get_stats(NULL));
+  rcutils_reset_error();
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(NULL));
+  EXPECT_TRUE(rcutils_logging_async_is_enabled());
+  EXPECT_EQ(rcutils_logging_async_output_handler, rcutils_logging_get_output_handler());
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_async_start(NULL));
+  rcutils_reset_error();
+
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+  EXPECT_FALSE(rcutils_logging_async_is_enabled());
+  EXPECT_EQ(record_output_handler, rcutils_logging_get_output_handler());
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+}
+
+TEST_F(TestLoggingAsync, test_records_are_forwarded) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(NULL));
+  rcutils_log_location_t location = {"func", "file", 42u};
+  rcutils_log(&location, RCUTILS_LOG_SEVERITY_WARN, "name1", "message %d", 1);
+  rcutils_log(NULL, RCUTILS_LOG_SEVERITY_DEBUG, NULL, "message %s", "2");
+  // disabled records are not queued
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+  rcutils_log(NULL, RCUTILS_LOG_SEVERITY_DEBUG, NULL, "message %s", "3");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(2u, g_log_events.size());
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, g_log_events[0].level);
+  EXPECT_EQ("name1", g_log_events[0].name);
+  EXPECT_EQ("message 1", g_log_events[0].message);
+  EXPECT_EQ("func", g_log_events[0].function_name);
+  EXPECT_EQ(42u, g_log_events[0].line_number);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, g_log_events[1].level);
+  EXPECT_EQ("", g_log_events[1].name);
+  EXPECT_EQ("message 2", g_log_events[1].message);
+  EXPECT_EQ("", g_log_events[1].function_name);
+
+  rcutils_logging_async_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_get_stats(&stats));
+  EXPECT_EQ(2u, stats.enqueued);
+  EXPECT_EQ(2u, stats.written);
+  EXPECT_EQ(0u, stats.dropped);
+  EXPECT_EQ(0u, stats.truncated);
+
+  // after stopping records are passed on directly
+  rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "name", "synchronous");
+  ASSERT_EQ(3u, g_log_events.size());
+  EXPECT_EQ("synchronous", g_log_events[2].message);
+}
+
+TEST_F(TestLoggingAsync, test_truncation) {
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.max_message_length = 8;
+  options.max_name_length = 4;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(&options));
+  rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "a.long.name", "a long message");
+  rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "abcd", "12345678");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(2u, g_log_events.size());
+  EXPECT_EQ("a.lo", g_log_events[0].name);
+  EXPECT_EQ("a long m", g_log_events[0].message);
+  EXPECT_EQ("abcd", g_log_events[1].name);
+  EXPECT_EQ("12345678", g_log_events[1].message);
+  rcutils_logging_async_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_get_stats(&stats));
+  EXPECT_EQ(1u, stats.truncated);
+}
+
+TEST_F(TestLoggingAsync, test_overflow_drop_newest) {
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.queue_capacity = 4;
+  options.overflow_policy = RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_NEWEST;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(&options));
+  block_output_handler();
+  for (int i = 0; i < 6; ++i) {
+    rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+  }
+  g_block_output_handler = false;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(5u, g_log_events.size());
+  EXPECT_EQ("blocking", g_log_events[0].message);
+  EXPECT_EQ("message 0", g_log_events[1].message);
+  EXPECT_EQ("message 3", g_log_events[4].message);
+  rcutils_logging_async_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_get_stats(&stats));
+  EXPECT_EQ(5u, stats.enqueued);
+  EXPECT_EQ(5u, stats.written);
+  EXPECT_EQ(2u, stats.dropped);
+}
+
+TEST_F(TestLoggingAsync, test_overflow_drop_oldest) {
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.queue_capacity = 4;
+  options.overflow_policy = RCUTILS_LOGGING_ASYNC_OVERFLOW_DROP_OLDEST;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(&options));
+  block_output_handler();
+  for (int i = 0; i < 6; ++i) {
+    rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+  }
+  g_block_output_handler = false;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(5u, g_log_events.size());
+  EXPECT_EQ("blocking", g_log_events[0].message);
+  EXPECT_EQ("message 2", g_log_events[1].message);
+  EXPECT_EQ("message 5", g_log_events[4].message);
+  rcutils_logging_async_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_get_stats(&stats));
+  EXPECT_EQ(7u, stats.enqueued);
+  EXPECT_EQ(5u, stats.written);
+  EXPECT_EQ(2u, stats.dropped);
+}
+
+TEST_F(TestLoggingAsync, test_overflow_block) {
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.queue_capacity = 4;
+  options.overflow_policy = RCUTILS_LOGGING_ASYNC_OVERFLOW_BLOCK;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(&options));
+  block_output_handler();
+  std::atomic<bool> done(false);
+  std::thread producer([&done]() {
+      for (int i = 0; i < 6; ++i) {
+        rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+      }
+      done = true;
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(done);
+  g_block_output_handler = false;
+  producer.join();
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(7u, g_log_events.size());
+  for (size_t i = 1; i < g_log_events.size(); ++i) {
+    EXPECT_EQ("message " + std::to_string(i - 1), g_log_events[i].message);
+  }
+  rcutils_logging_async_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_get_stats(&stats));
+  EXPECT_EQ(0u, stats.dropped);
+}
+
+TEST_F(TestLoggingAsync, test_multiple_producers) {
+  rcutils_logging_async_options_t options = rcutils_logging_async_get_default_options();
+  options.queue_capacity = 16;
+  options.overflow_policy = RCUTILS_LOGGING_ASYNC_OVERFLOW_BLOCK;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_start(&options));
+  const int num_threads = 4;
+  const int num_messages = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([t, num_messages]() {
+        std::string name = "thread" + std::to_string(t);
+        for (int i = 0; i < num_messages; ++i) {
+          rcutils_log(NULL, RCUTILS_LOG_SEVERITY_INFO, name.c_str(), "%d", i);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_async_stop());
+
+  ASSERT_EQ(static_cast<size_t>(num_threads * num_messages), g_log_events.size());
+  // the records of each thread are written in the order they were logged
+  std::vector<int> next_message(num_threads, 0);
+  for (const auto & event : g_log_events) {
+    int t = std::stoi(event.name.substr(6));
+    EXPECT_EQ(std::to_string(next_message[t]), event.message);
+    ++next_message[t];
+  }
+}
@@ -0,0 +1,310 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_binary.h"
+
+static const char * g_file_path = "test_logging_binary.log";
+
+std::string read_file(const std::string & file_path)
+{
+  std::ifstream file(file_path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+/// Decode the binary log file and return its lines without the timestamps.
+std::vector<std::string> decode(bool with_location)
+{
+  std::vector<std::string> lines;
+  FILE * input = fopen(g_file_path, "rb");
+  FILE * output = tmpfile();
+  EXPECT_NE(nullptr, input);
+  EXPECT_NE(nullptr, output);
+  if (!input || !output) {
+    return lines;
+  }
+  EXPECT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_binary_decode(input, output, with_location, rcutils_get_default_allocator()));
+  fclose(input);
+  rewind(output);
+  std::string line;
+  int c;
+  while ((c = fgetc(output)) != EOF) {
+    if ('\n' != c) {
+      line.push_back(static_cast<char>(c));
+      continue;
+    }
+    // Remove the timestamp after the severity.
+    size_t start = line.find("] [");
+    size_t end = line.find("] [", start + 3);
+    if (start != std::string::npos && end != std::string::npos) {
+      line.erase(start + 1, end - start);
+    }
+    lines.push_back(line);
+    line.clear();
+  }
+  fclose(output);
+  return lines;
+}
+
+std::string format(const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  va_list args_clone;
+  va_copy(args_clone, args);
+  std::vector<char> buffer(vsnprintf(nullptr, 0, format, args_clone) + 1);
+  va_end(args_clone);
+  vsnprintf(buffer.data(), buffer.size(), format, args);
+  va_end(args);
+  return buffer.data();
+}
+
+class TestLoggingBinary : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    std::remove(g_file_path);
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(rcutils_logging_binary_output_handler);
+  }
+
+  void TearDown()
+  {
+    rcutils_logging_set_output_handler(previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+    std::remove(g_file_path);
+  }
+
+  void open()
+  {
+    rcutils_logging_binary_options_t options = rcutils_logging_binary_get_default_options();
+    options.file_path = g_file_path;
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_open(&options));
+  }
+
+protected:
+  rcutils_logging_output_handler_t previous_output_handler;
+};
+
+TEST_F(TestLoggingBinary, open_invalid_arguments) {
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_binary_open(nullptr));
+  rcutils_reset_error();
+
+  rcutils_logging_binary_options_t options = rcutils_logging_binary_get_default_options();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_binary_open(&options));
+  rcutils_reset_error();
+
+  options.file_path = g_file_path;
+  options.buffer_size = 0;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_binary_open(&options));
+  rcutils_reset_error();
+
+  options.buffer_size = 1024;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_open(&options));
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_binary_open(&options));
+  rcutils_reset_error();
+}
+
+TEST_F(TestLoggingBinary, round_trip) {
+  open();
+  rcutils_log_location_t location = {"func", "file", 42u};
+  std::string long_argument(4096, 'y');
+  char characters[] = {'a', 'b', 'c'};
+  int value = 0;
+  void * pointer = &value;
+  std::vector<std::string> expected;
+
+#define LOG_AND_EXPECT(...) \
+  rcutils_log(&location, RCUTILS_LOG_SEVERITY_INFO, "name", __VA_ARGS__); \
+  expected.push_back("[INFO] [name]: " + format(__VA_ARGS__) + " (func() at file:42)")
+
+  LOG_AND_EXPECT("no arguments");
+  LOG_AND_EXPECT("100%% literal");
+  LOG_AND_EXPECT("%d %i %5d %-5d| %+d %05d", -1, 2, 3, 4, 5, -6);
+  LOG_AND_EXPECT("%hhd %hd %ld %lld %jd %zd %td", 300, 70000, -7L, LLONG_MIN, INTMAX_MAX,
+    static_cast<size_t>(-8), static_cast<ptrdiff_t>(-9));
+  LOG_AND_EXPECT("%u %o %x %X %#x %hhu %hu %lu %llu %zu", 1u, 8u, 255u, 255u, 255u, 300u,
+    70000u, 7UL, ULLONG_MAX, sizeof(value));
+  LOG_AND_EXPECT("%c%c %5c", 'o', 'k', '!');
+  LOG_AND_EXPECT("%f %.2f %e %g %10.3G %a", 1.5, 3.14159, 1e-10, 0.0001, 123456.789, 1.0);
+  LOG_AND_EXPECT("%s|%10s|%-10s|%.2s|", "string", "right", "left", "truncated");
+  LOG_AND_EXPECT("%.3s", characters);
+  LOG_AND_EXPECT("%*d|%-*d|%.*f|%*.*s|", 6, 1, 6, 2, 3, 2.0, 8, 3, "stars");
+  LOG_AND_EXPECT("%*d|%.*s|", -6, 1, -1, "negative");
+  LOG_AND_EXPECT("%p", pointer);
+  LOG_AND_EXPECT("X%sX%d", long_argument.c_str(), 42);
+  // Formats which can't be encoded are formatted right away.
+  LOG_AND_EXPECT("%Lf %d", 2.5L, 7);
+  LOG_AND_EXPECT("%1$d", 9);
+
+#undef LOG_AND_EXPECT
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, "other.name", "without location %d", 1);
+  expected.push_back("[WARN] [other.name]: without location 1");
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+  std::vector<std::string> lines = decode(true);
+  ASSERT_EQ(expected.size(), lines.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], lines[i]);
+  }
+
+  lines = decode(false);
+  ASSERT_EQ(expected.size(), lines.size());
+  EXPECT_EQ("[INFO] [name]: no arguments", lines[0]);
+}
+
+TEST_F(TestLoggingBinary, strings_are_written_once) {
+  open();
+  rcutils_log_location_t location = {"function_name", "file_name", 42u};
+  for (int i = 0; i < 10; ++i) {
+    rcutils_log(
+      &location, RCUTILS_LOG_SEVERITY_INFO, "logger_name", "format string %d %s", i, "argument");
+  }
+  // A different location struct with the same contents is a different call site.
+  rcutils_log_location_t other_location = location;
+  rcutils_log(
+    &other_location, RCUTILS_LOG_SEVERITY_INFO, "logger_name", "format string %d %s", 10,
+    "argument");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+
+  std::string content = read_file(g_file_path);
+  for (const char * string : {"function_name", "file_name", "logger_name", "format string"}) {
+    size_t position = content.find(string);
+    ASSERT_NE(std::string::npos, position) << string;
+    EXPECT_EQ(std::string::npos, content.find(string, position + 1)) << string;
+  }
+  // The string arguments are part of each record.
+  size_t count = 0;
+  for (size_t position = content.find("argument"); position != std::string::npos;
+    position = content.find("argument", position + 1))
+  {
+    ++count;
+  }
+  EXPECT_EQ(11u, count);
+
+  std::vector<std::string> lines = decode(true);
+  ASSERT_EQ(11u, lines.size());
+  EXPECT_EQ(
+    "[INFO] [logger_name]: format string 0 argument (function_name() at file_name:42)", lines[0]);
+  EXPECT_EQ(
+    "[INFO] [logger_name]: format string 10 argument (function_name() at file_name:42)",
+    lines[10]);
+}
+
+TEST_F(TestLoggingBinary, closed_file_discards_records) {
+  open();
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "before");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_flush());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "after");
+
+  std::vector<std::string> lines = decode(false);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("[INFO] [name]: before", lines[0]);
+}
+
+TEST_F(TestLoggingBinary, decode_invalid_input) {
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  FILE * output = tmpfile();
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_binary_decode(nullptr, output, false, allocator));
+  rcutils_reset_error();
+
+  FILE * input = fopen(g_file_path, "wb");
+  ASSERT_NE(nullptr, input);
+  fputs("not a binary log file", input);
+  fclose(input);
+  input = fopen(g_file_path, "rb");
+  ASSERT_NE(nullptr, input);
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_binary_decode(input, output, false, allocator));
+  rcutils_reset_error();
+  fclose(input);
+  fclose(output);
+}
+
+TEST_F(TestLoggingBinary, decode_out_of_range_stars) {
+  open();
+  // The values of '*' are replaced in the file with values which don't fit into an int.
+  const int64_t width_marker = 0x5a5a5a5a;
+  const int64_t precision_marker = 0x3c3c3c3c;
+  const std::string format = "%" + std::string(93, '-') + "*.*%";
+  rcutils_log(
+    nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", format.c_str(),
+    static_cast<int>(width_marker), static_cast<int>(precision_marker));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+
+  std::string content = read_file(g_file_path);
+  for (int64_t marker : {width_marker, precision_marker}) {
+    const std::string encoded(reinterpret_cast<const char *>(&marker), sizeof(marker));
+    size_t position = content.find(encoded);
+    ASSERT_NE(std::string::npos, position);
+    const int64_t replacement = INT64_MAX;
+    content.replace(
+      position, sizeof(replacement),
+      std::string(reinterpret_cast<const char *>(&replacement), sizeof(replacement)));
+  }
+  std::ofstream(g_file_path, std::ios::binary | std::ios::trunc) << content;
+
+  std::vector<std::string> lines = decode(false);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("[INFO] [name]: %", lines[0]);
+}
+
+TEST_F(TestLoggingBinary, decode_invalid_string_length) {
+  open();
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_binary_close());
+  const std::string content = read_file(g_file_path);
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  // The length of the null string, and a length beyond the end of the file.
+  for (uint32_t length : {UINT32_MAX, 1000u}) {
+    // A string entry: the type 1, the id and the length, followed by fewer characters.
+    const uint32_t values[2] = {1000u, length};
+    std::string crafted = content + '\x01';
+    crafted.append(reinterpret_cast<const char *>(values), sizeof(values));
+    crafted.append("abc");
+    std::ofstream(g_file_path, std::ios::binary | std::ios::trunc) << crafted;
+
+    FILE * input = fopen(g_file_path, "rb");
+    FILE * output = tmpfile();
+    ASSERT_NE(nullptr, input);
+    ASSERT_NE(nullptr, output);
+    EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_binary_decode(input, output, false, allocator));
+    rcutils_reset_error();
+    fclose(input);
+    fclose(output);
+  }
+}
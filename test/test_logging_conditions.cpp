@@ -0,0 +1,124 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests of the conditions of the logging macros which are evaluated by several threads at once.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+#include "rcutils/time.h"
+
+class TestLoggingConditions : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_DEBUG);
+  }
+
+  void TearDown()
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  }
+};
+
+std::atomic<size_t> g_concurrent_log_calls(0);
+
+void run_concurrently(std::function<void()> function)
+{
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back(function);
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+}
+
+TEST_F(TestLoggingConditions, test_logging_conditions_concurrently) {
+  rcutils_logging_set_output_handler(
+    [](const rcutils_log_location_t *, int, const char *, const char *, va_list *) -> void
+    {
+      ++g_concurrent_log_calls;
+    });
+
+  g_concurrent_log_calls = 0;
+  run_concurrently(
+    []() {
+      for (int i = 0; i < 1000; ++i) {
+        RCUTILS_LOG_INFO_ONCE("message %d", i);
+      }
+    });
+  EXPECT_EQ(1u, g_concurrent_log_calls);
+
+  g_concurrent_log_calls = 0;
+  run_concurrently(
+    []() {
+      for (int i = 0; i < 1000; ++i) {
+        RCUTILS_LOG_INFO_SKIPFIRST("message %d", i);
+      }
+    });
+  EXPECT_EQ(8u * 1000u - 1u, g_concurrent_log_calls);
+
+  g_concurrent_log_calls = 0;
+  run_concurrently(
+    []() {
+      for (int i = 0; i < 1000; ++i) {
+        RCUTILS_LOG_INFO_THROTTLE(RCUTILS_STEADY_TIME, 60 * 60 * 1000 /* ms */, "message %d", i);
+      }
+    });
+  EXPECT_EQ(1u, g_concurrent_log_calls);
+
+  g_concurrent_log_calls = 0;
+  run_concurrently(
+    []() {
+      for (int i = 0; i < 1000; ++i) {
+        RCUTILS_LOG_INFO_RATELIMIT(5, 60 * 60 * 1000 /* ms */, "message %d", i);
+      }
+    });
+  EXPECT_EQ(5u, g_concurrent_log_calls);
+}
+
+TEST_F(TestLoggingConditions, test_logging_condition_throttle) {
+  rcutils_time_point_value_t last_logged = 0;
+  EXPECT_TRUE(rcutils_logging_condition_throttle(&last_logged, 1000, 100));
+  EXPECT_EQ(100, last_logged);
+  last_logged = 90;
+  EXPECT_TRUE(rcutils_logging_condition_throttle(&last_logged, 10, 100));
+  EXPECT_EQ(100, last_logged);
+  EXPECT_FALSE(rcutils_logging_condition_throttle(&last_logged, 10, 109));
+  EXPECT_EQ(100, last_logged);
+  EXPECT_TRUE(rcutils_logging_condition_throttle(&last_logged, 10, 110));
+  EXPECT_EQ(110, last_logged);
+
+  // every thread tries to log in every interval, exactly one of them succeeds in each interval
+  last_logged = 0;
+  std::atomic<size_t> passed(0);
+  run_concurrently(
+    [&last_logged, &passed]() {
+      for (rcutils_time_point_value_t interval = 1; interval <= 1000; ++interval) {
+        if (rcutils_logging_condition_throttle(&last_logged, 10, interval * 10)) {
+          ++passed;
+        }
+      }
+    });
+  EXPECT_EQ(1000u, passed);
+  EXPECT_EQ(10000, last_logged);
+}
@@ -0,0 +1,239 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_file.h"
+#include "rcutils/time.h"
+
+static const char * g_file_path = "test_logging_file.log";
+
+std::string read_file(const std::string & file_path)
+{
+  std::ifstream file(file_path);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+void remove_files()
+{
+  std::remove(g_file_path);
+  for (int i = 1; i <= 3; ++i) {
+    std::remove((std::string(g_file_path) + "." + std::to_string(i)).c_str());
+  }
+}
+
+bool make_directory(const char * path)
+{
+#ifdef _WIN32
+  return _mkdir(path) == 0;
+#else
+  return mkdir(path, 0755) == 0;
+#endif
+}
+
+bool remove_directory(const char * path)
+{
+#ifdef _WIN32
+  return _rmdir(path) == 0;
+#else
+  return rmdir(path) == 0;
+#endif
+}
+
+class TestLoggingFile : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    remove_files();
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(rcutils_logging_file_output_handler);
+  }
+
+  void TearDown()
+  {
+    rcutils_logging_set_output_handler(previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_file_close());
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+    remove_files();
+  }
+
+protected:
+  rcutils_logging_output_handler_t previous_output_handler;
+};
+
+TEST_F(TestLoggingFile, invalid_options) {
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_file_open(nullptr));
+  rcutils_reset_error();
+
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_file_open(&options));
+  rcutils_reset_error();
+
+  options.file_path = g_file_path;
+  options.buffer_size = 0;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_file_open(&options));
+  rcutils_reset_error();
+
+  options = rcutils_logging_file_get_default_options();
+  options.file_path = g_file_path;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_file_open(&options));
+  rcutils_reset_error();
+}
+
+TEST_F(TestLoggingFile, buffered_until_flushed) {
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  options.file_path = g_file_path;
+  options.flush_period_ns = 0;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 1);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, "name", "message %d", 2);
+  EXPECT_EQ("", read_file(g_file_path));
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_flush());
+  EXPECT_EQ("[INFO] [name]: message 1\n[WARN] [name]: message 2\n", read_file(g_file_path));
+
+  // The flush severity is written immediately, together with everything buffered before.
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 3);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_ERROR, "name", "message %d", 4);
+  EXPECT_EQ(
+    "[INFO] [name]: message 1\n[WARN] [name]: message 2\n"
+    "[INFO] [name]: message 3\n[ERROR] [name]: message 4\n",
+    read_file(g_file_path));
+
+  // Closing the file writes the buffered lines, later ones are discarded.
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 5);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_close());
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 6);
+  EXPECT_EQ(
+    "[INFO] [name]: message 1\n[WARN] [name]: message 2\n"
+    "[INFO] [name]: message 3\n[ERROR] [name]: message 4\n"
+    "[INFO] [name]: message 5\n",
+    read_file(g_file_path));
+}
+
+TEST_F(TestLoggingFile, full_buffer_is_written) {
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  options.file_path = g_file_path;
+  options.flush_period_ns = 0;
+  // Room for two lines of 25 characters.
+  options.buffer_size = 60;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 1);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 2);
+  EXPECT_EQ("", read_file(g_file_path));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 3);
+  EXPECT_EQ("[INFO] [name]: message 1\n[INFO] [name]: message 2\n", read_file(g_file_path));
+
+  // Lines which don't fit into the buffer are written directly.
+  std::string long_message(100, 'x');
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "%s", long_message.c_str());
+  EXPECT_EQ(
+    "[INFO] [name]: message 1\n[INFO] [name]: message 2\n[INFO] [name]: message 3\n"
+    "[INFO] [name]: " + long_message + "\n",
+    read_file(g_file_path));
+}
+
+TEST_F(TestLoggingFile, flush_period) {
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  options.file_path = g_file_path;
+  options.flush_period_ns = RCUTILS_MS_TO_NS(10);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", 1);
+  std::string content;
+  for (int i = 0; i < 500 && content.empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    content = read_file(g_file_path);
+  }
+  EXPECT_EQ("[INFO] [name]: message 1\n", content);
+}
+
+TEST_F(TestLoggingFile, rotation) {
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  options.file_path = g_file_path;
+  options.flush_period_ns = 0;
+  // Room for two lines of 25 characters per file.
+  options.max_file_size = 60;
+  options.max_rotated_files = 2;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+
+  for (int i = 1; i <= 9; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+  }
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_close());
+
+  const std::string file_path(g_file_path);
+  EXPECT_EQ("[INFO] [name]: message 9\n", read_file(file_path));
+  EXPECT_EQ("[INFO] [name]: message 7\n[INFO] [name]: message 8\n", read_file(file_path + ".1"));
+  EXPECT_EQ("[INFO] [name]: message 5\n[INFO] [name]: message 6\n", read_file(file_path + ".2"));
+  // Only the configured number of rotated files is kept.
+  EXPECT_FALSE(std::ifstream(file_path + ".3").good());
+}
+
+TEST_F(TestLoggingFile, directory_removed) {
+  const std::string directory = "test_logging_file_directory";
+  const std::string file_path = directory + "/test.log";
+  std::remove(file_path.c_str());
+  std::remove((file_path + ".1").c_str());
+  remove_directory(directory.c_str());
+  ASSERT_TRUE(make_directory(directory.c_str()));
+  rcutils_logging_file_options_t options = rcutils_logging_file_get_default_options();
+  options.file_path = file_path.c_str();
+  options.flush_period_ns = 0;
+  options.max_file_size = 100;
+  options.max_rotated_files = 1;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_open(&options));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "before %d", 0);
+
+  // Rotating fails to reopen the file, the output lines are dropped meanwhile.
+  ASSERT_EQ(0, std::remove(file_path.c_str()));
+  ASSERT_TRUE(remove_directory(directory.c_str()));
+  for (int i = 0; i < 100; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "dropped %d", i);
+  }
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_file_flush());
+
+  // The file is opened again once the directory exists.
+  ASSERT_TRUE(make_directory(directory.c_str()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "after %d", 0);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_file_close());
+  EXPECT_EQ("[INFO] [name]: after 0\n", read_file(file_path));
+
+  std::remove(file_path.c_str());
+  remove_directory(directory.c_str());
+}
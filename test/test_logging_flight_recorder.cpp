@@ -0,0 +1,301 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_binary.h"
+#include "rcutils/logging_flight_recorder.h"
+#include "rcutils/logging_macros.h"
+
+static const char * g_file_path = "test_logging_flight_recorder.log";
+
+/// Decode the dump and return its lines, the timestamps are removed unless requested.
+static std::vector<std::string> decode(bool with_location, bool with_timestamp = false)
+{
+  std::vector<std::string> lines;
+  FILE * input = fopen(g_file_path, "rb");
+  FILE * output = tmpfile();
+  EXPECT_NE(nullptr, input);
+  EXPECT_NE(nullptr, output);
+  if (!input || !output) {
+    return lines;
+  }
+  EXPECT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_binary_decode(input, output, with_location, rcutils_get_default_allocator()));
+  fclose(input);
+  rewind(output);
+  std::string line;
+  int c;
+  while ((c = fgetc(output)) != EOF) {
+    if ('\n' != c) {
+      line.push_back(static_cast<char>(c));
+      continue;
+    }
+    size_t start = line.find("] [");
+    size_t end = line.find("] [", start + 3);
+    if (!with_timestamp && start != std::string::npos && end != std::string::npos) {
+      line.erase(start + 1, end - start);
+    }
+    lines.push_back(line);
+    line.clear();
+  }
+  fclose(output);
+  return lines;
+}
+
+static size_t g_log_calls = 0;
+
+static void count_output_handler(
+  const rcutils_log_location_t *, int, const char *, const char *, va_list *)
+{
+  ++g_log_calls;
+}
+
+class TestLoggingFlightRecorder : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    std::remove(g_file_path);
+    g_log_calls = 0;
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(count_output_handler);
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+    options = rcutils_logging_flight_recorder_get_default_options();
+    options.file_path = g_file_path;
+    options.dump_on_signal = false;
+  }
+
+  void TearDown()
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_stop());
+    rcutils_logging_set_output_handler(previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+    std::remove(g_file_path);
+  }
+
+protected:
+  rcutils_logging_output_handler_t previous_output_handler;
+  rcutils_logging_flight_recorder_options_t options;
+};
+
+TEST_F(TestLoggingFlightRecorder, records_below_level) {
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("flight", RCUTILS_LOG_SEVERITY_DEBUG));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for("flight", RCUTILS_LOG_SEVERITY_DEBUG));
+
+  RCUTILS_LOG_DEBUG_NAMED("flight", "debug %d", 1);
+  RCUTILS_LOG_INFO_NAMED("flight", "info %s", "two");
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "flight.child", "debug %.1f", 3.0);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, nullptr, "warn %c", '4');
+  // Only the messages at the level of their loggers are passed on.
+  EXPECT_EQ(2u, g_log_calls);
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+  std::vector<std::string> lines = decode(false);
+  std::vector<std::string> expected = {
+    "[DEBUG] [flight]: debug 1",
+    "[INFO] [flight]: info two",
+    "[DEBUG] [flight.child]: debug 3.0",
+    "[WARN] []: warn 4",
+  };
+  EXPECT_EQ(expected, lines);
+  lines = decode(true);
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("test_logging_flight_recorder.cpp:"));
+
+  // The records stay after a dump.
+  RCUTILS_LOG_DEBUG_NAMED("flight", "debug %d", 5);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+  lines = decode(false);
+  ASSERT_EQ(5u, lines.size());
+  EXPECT_EQ("[DEBUG] [flight]: debug 5", lines[4]);
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_stop());
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("flight", RCUTILS_LOG_SEVERITY_DEBUG));
+  RCUTILS_LOG_DEBUG_NAMED("flight", "debug %d", 6);
+  EXPECT_EQ(2u, g_log_calls);
+}
+
+TEST_F(TestLoggingFlightRecorder, severity) {
+  options.severity = RCUTILS_LOG_SEVERITY_WARN;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  RCUTILS_LOG_DEBUG_NAMED("flight", "debug");
+  RCUTILS_LOG_INFO_NAMED("flight", "info");
+  RCUTILS_LOG_WARN_NAMED("flight", "warn");
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+  std::vector<std::string> expected = {"[WARN] [flight]: warn"};
+  EXPECT_EQ(expected, decode(false));
+}
+
+TEST_F(TestLoggingFlightRecorder, overwrite_oldest_records) {
+  options.thread_buffer_size = 1024;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  for (int i = 0; i < 100; ++i) {
+    RCUTILS_LOG_DEBUG_NAMED("flight", "message %d", i);
+  }
+  // Too large to be recorded.
+  std::string argument(1024, 'x');
+  RCUTILS_LOG_DEBUG_NAMED("flight", "%s", argument.c_str());
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+  std::vector<std::string> lines = decode(false);
+  ASSERT_LT(0u, lines.size());
+  ASSERT_GT(100u, lines.size());
+  size_t first = 100 - lines.size();
+  for (size_t i = 0; i < lines.size(); ++i) {
+    EXPECT_EQ("[DEBUG] [flight]: message " + std::to_string(first + i), lines[i]);
+  }
+}
+
+TEST_F(TestLoggingFlightRecorder, threads) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(
+      [t]() {
+        for (int i = 0; i < 50; ++i) {
+          RCUTILS_LOG_DEBUG_NAMED("flight", "thread %d message %d", t, i);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+
+  // The records of all threads are merged by time.
+  std::vector<std::string> lines = decode(false, true);
+  ASSERT_EQ(200u, lines.size());
+  long long previous_timestamp = 0;
+  std::vector<int> next_message(4, 0);
+  for (const auto & line : lines) {
+    long long seconds = 0;
+    long long nanoseconds = 0;
+    int t = -1;
+    int i = -1;
+    ASSERT_EQ(
+      4, sscanf(
+        line.c_str(), "[DEBUG] [%lld.%lld] [flight]: thread %d message %d",
+        &seconds, &nanoseconds, &t, &i)) << line;
+    long long timestamp = seconds * 1000000000LL + nanoseconds;
+    EXPECT_LE(previous_timestamp, timestamp);
+    previous_timestamp = timestamp;
+    ASSERT_TRUE(t >= 0 && t < 4);
+    EXPECT_EQ(next_message[t]++, i);
+  }
+}
+
+TEST_F(TestLoggingFlightRecorder, rings_of_exited_threads) {
+  options.max_threads = 1;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  for (int t = 0; t < 2; ++t) {
+    std::thread thread([t]() {RCUTILS_LOG_DEBUG_NAMED("flight", "thread %d", t);});
+    thread.join();
+  }
+  // This thread doesn't get the ring, which is still claimed by the last thread.
+  std::thread thread([]() {
+      RCUTILS_LOG_DEBUG_NAMED("flight", "thread %d", 2);
+      RCUTILS_LOG_DEBUG_NAMED("flight", "thread %d", 3);
+      std::thread inner([]() {RCUTILS_LOG_DEBUG_NAMED("flight", "thread %d", 4);});
+      inner.join();
+    });
+  thread.join();
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_dump());
+  std::vector<std::string> expected = {
+    "[DEBUG] [flight]: thread 0",
+    "[DEBUG] [flight]: thread 1",
+    "[DEBUG] [flight]: thread 2",
+    "[DEBUG] [flight]: thread 3",
+  };
+  EXPECT_EQ(expected, decode(false));
+}
+
+TEST_F(TestLoggingFlightRecorder, dump_on_fatal) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  RCUTILS_LOG_DEBUG_NAMED("flight", "debug");
+  FILE * file = fopen(g_file_path, "rb");
+  EXPECT_EQ(nullptr, file);
+  if (file) {
+    fclose(file);
+  }
+  RCUTILS_LOG_FATAL_NAMED("flight", "fatal");
+  std::vector<std::string> expected = {
+    "[DEBUG] [flight]: debug",
+    "[FATAL] [flight]: fatal",
+  };
+  EXPECT_EQ(expected, decode(false));
+}
+
+#ifndef _WIN32
+static void crash(const rcutils_logging_flight_recorder_options_t * options)
+{
+  if (rcutils_logging_flight_recorder_start(options) == RCUTILS_RET_OK) {
+    RCUTILS_LOG_DEBUG_NAMED("flight", "before the crash");
+    std::abort();
+  }
+}
+
+TEST_F(TestLoggingFlightRecorder, dump_on_signal) {
+  options.dump_on_signal = true;
+  EXPECT_EXIT(crash(&options), ::testing::KilledBySignal(SIGABRT), "");
+  std::vector<std::string> expected = {"[DEBUG] [flight]: before the crash"};
+  EXPECT_EQ(expected, decode(false));
+}
+#endif
+
+TEST_F(TestLoggingFlightRecorder, invalid_arguments) {
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_flight_recorder_start(nullptr));
+  rcutils_reset_error();
+  rcutils_logging_flight_recorder_options_t invalid_options = options;
+  invalid_options.file_path = "";
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_flight_recorder_start(&invalid_options));
+  rcutils_reset_error();
+  invalid_options = options;
+  invalid_options.thread_buffer_size = 16;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_flight_recorder_start(&invalid_options));
+  rcutils_reset_error();
+  invalid_options = options;
+  invalid_options.max_threads = 0;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_flight_recorder_start(&invalid_options));
+  rcutils_reset_error();
+  invalid_options = options;
+  invalid_options.severity = RCUTILS_LOG_SEVERITY_FATAL + 1;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_flight_recorder_start(&invalid_options));
+  rcutils_reset_error();
+
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_flight_recorder_dump());
+  rcutils_reset_error();
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_flight_recorder_start(&options));
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_flight_recorder_start(&options));
+  rcutils_reset_error();
+
+  // The flight recorder is stopped on shutdown.
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  EXPECT_EQ(RCUTILS_RET_ERROR, rcutils_logging_flight_recorder_dump());
+  rcutils_reset_error();
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+}
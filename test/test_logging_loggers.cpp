@@ -0,0 +1,226 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_macros.h"
+
+struct LogEvent
+{
+  const rcutils_log_location_t * location;
+  int severity;
+  std::string name;
+  std::string message;
+};
+
+static std::vector<LogEvent> g_log_events;
+
+static void record_output_handler(
+  const rcutils_log_location_t * location, int severity, const char * name,
+  const char * format, va_list * args)
+{
+  char message[256];
+  vsnprintf(message, sizeof(message), format, *args);
+  g_log_events.push_back({location, severity, name, message});
+}
+
+class TestLoggingLoggers : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    g_log_events.clear();
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    rcutils_logging_set_output_handler(record_output_handler);
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+  }
+
+  void TearDown()
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  }
+};
+
+TEST_F(TestLoggingLoggers, interning) {
+  rcutils_logger_t * logger = rcutils_logging_get_logger("a.b.c");
+  ASSERT_NE(nullptr, logger);
+  EXPECT_STREQ("a.b.c", rcutils_logger_get_name(logger));
+  // the same name always results in the same handle
+  std::string name = "a.b.c";
+  EXPECT_EQ(logger, rcutils_logging_get_logger(name.c_str()));
+  EXPECT_NE(logger, rcutils_logging_get_logger("a.b.d"));
+
+  // the ancestors are created along with the logger
+  rcutils_logger_t * parent = rcutils_logger_get_parent(logger);
+  ASSERT_NE(nullptr, parent);
+  EXPECT_STREQ("a.b", rcutils_logger_get_name(parent));
+  EXPECT_EQ(parent, rcutils_logging_get_logger("a.b"));
+  rcutils_logger_t * root = rcutils_logger_get_parent(parent);
+  ASSERT_NE(nullptr, root);
+  EXPECT_STREQ("a", rcutils_logger_get_name(root));
+  EXPECT_EQ(nullptr, rcutils_logger_get_parent(root));
+
+  rcutils_logger_t * empty = rcutils_logging_get_logger("");
+  ASSERT_NE(nullptr, empty);
+  EXPECT_STREQ("", rcutils_logger_get_name(empty));
+  EXPECT_EQ(nullptr, rcutils_logger_get_parent(empty));
+  rcutils_logger_t * leading = rcutils_logging_get_logger(".x");
+  ASSERT_NE(nullptr, leading);
+  EXPECT_EQ(empty, rcutils_logger_get_parent(leading));
+
+  // enough loggers to resize the table
+  std::vector<rcutils_logger_t *> loggers;
+  for (int i = 0; i < 100; ++i) {
+    std::string child = "many.logger" + std::to_string(i);
+    loggers.push_back(rcutils_logging_get_logger(child.c_str()));
+    ASSERT_NE(nullptr, loggers.back());
+  }
+  for (int i = 0; i < 100; ++i) {
+    std::string child = "many.logger" + std::to_string(i);
+    EXPECT_EQ(loggers[i], rcutils_logging_get_logger(child.c_str()));
+    EXPECT_STREQ(child.c_str(), rcutils_logger_get_name(loggers[i]));
+  }
+  EXPECT_EQ(logger, rcutils_logging_get_logger("a.b.c"));
+}
+
+TEST_F(TestLoggingLoggers, invalid_arguments) {
+  EXPECT_EQ(nullptr, rcutils_logging_get_logger(nullptr));
+  EXPECT_TRUE(rcutils_error_is_set());
+  rcutils_reset_error();
+  EXPECT_EQ(nullptr, rcutils_logger_get_name(nullptr));
+  EXPECT_EQ(nullptr, rcutils_logger_get_parent(nullptr));
+  EXPECT_EQ(-1, rcutils_logger_get_effective_level(nullptr));
+  EXPECT_FALSE(rcutils_logger_is_enabled_for(nullptr, RCUTILS_LOG_SEVERITY_FATAL));
+  rcutils_log_logger_unchecked(nullptr, RCUTILS_LOG_SEVERITY_FATAL, nullptr, "message");
+  EXPECT_TRUE(g_log_events.empty());
+}
+
+TEST_F(TestLoggingLoggers, effective_level) {
+  rcutils_logger_t * logger = rcutils_logging_get_logger("x.y.z");
+  ASSERT_NE(nullptr, logger);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, rcutils_logger_get_effective_level(logger));
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_WARN);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, rcutils_logger_get_effective_level(logger));
+  EXPECT_FALSE(rcutils_logger_is_enabled_for(logger, RCUTILS_LOG_SEVERITY_INFO));
+  EXPECT_TRUE(rcutils_logger_is_enabled_for(logger, RCUTILS_LOG_SEVERITY_WARN));
+
+  // the cached levels follow the levels of the logger and its ancestors
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("x", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, rcutils_logger_get_effective_level(logger));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("x.y.z", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_ERROR, rcutils_logger_get_effective_level(logger));
+  EXPECT_EQ(
+    RCUTILS_LOG_SEVERITY_DEBUG,
+    rcutils_logger_get_effective_level(rcutils_logger_get_parent(logger)));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("x.y.z", RCUTILS_LOG_SEVERITY_UNSET));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, rcutils_logger_get_effective_level(logger));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("x", RCUTILS_LOG_SEVERITY_UNSET));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, rcutils_logger_get_effective_level(logger));
+}
+
+TEST_F(TestLoggingLoggers, effective_level_with_patterns) {
+  const char * names[] = {"p", "p.q", "p.q.r", "p.q.r.s", "p.other.r", ".p.q", "p..r"};
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("p", RCUTILS_LOG_SEVERITY_WARN));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_set_logger_level_pattern("p.*.r", RCUTILS_LOG_SEVERITY_DEBUG));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_set_logger_level_pattern("*.q", RCUTILS_LOG_SEVERITY_ERROR));
+  for (int i = 0; i < 3; ++i) {
+    if (1 == i) {
+      ASSERT_EQ(
+        RCUTILS_RET_OK, rcutils_logging_set_logger_level("p.q", RCUTILS_LOG_SEVERITY_FATAL));
+    } else if (2 == i) {
+      ASSERT_EQ(
+        RCUTILS_RET_OK, rcutils_logging_set_logger_level_pattern("**", RCUTILS_LOG_SEVERITY_INFO));
+    }
+    // the handles agree with the levels determined from the names
+    for (const char * name : names) {
+      rcutils_logger_t * logger = rcutils_logging_get_logger(name);
+      ASSERT_NE(nullptr, logger);
+      EXPECT_EQ(
+        rcutils_logging_get_logger_effective_level(name),
+        rcutils_logger_get_effective_level(logger)) << name << " in round " << i;
+    }
+  }
+}
+
+TEST_F(TestLoggingLoggers, logging_macros) {
+  rcutils_logger_t * logger = rcutils_logging_get_logger("macro.logger");
+  ASSERT_NE(nullptr, logger);
+  RCUTILS_LOG_INFO_LOGGER(logger, "message %d", 1);
+  RCUTILS_LOG_DEBUG_LOGGER(logger, "message %d", 2);
+  ASSERT_EQ(1u, g_log_events.size());
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, g_log_events[0].severity);
+  EXPECT_EQ("macro.logger", g_log_events[0].name);
+  EXPECT_EQ("message 1", g_log_events[0].message);
+  ASSERT_NE(nullptr, g_log_events[0].location);
+  EXPECT_STREQ(__func__, g_log_events[0].location->function_name);
+
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_set_logger_level("macro", RCUTILS_LOG_SEVERITY_DEBUG));
+  RCUTILS_LOG_DEBUG_LOGGER(logger, "message %d", 3);
+  ASSERT_EQ(2u, g_log_events.size());
+  EXPECT_EQ("message 3", g_log_events[1].message);
+
+  for (int i = 0; i < 3; ++i) {
+    RCUTILS_LOG_WARN_ONCE_LOGGER(logger, "once");
+    RCUTILS_LOG_ERROR_EXPRESSION_LOGGER(i == 1, logger, "expression %d", i);
+    RCUTILS_LOG_FATAL_SKIPFIRST_LOGGER(logger, "skipfirst %d", i);
+  }
+  ASSERT_EQ(6u, g_log_events.size());
+  EXPECT_EQ("once", g_log_events[2].message);
+  EXPECT_EQ("expression 1", g_log_events[3].message);
+  EXPECT_EQ("skipfirst 1", g_log_events[4].message);
+  EXPECT_EQ("skipfirst 2", g_log_events[5].message);
+
+  // the suppressed messages are reported with the name of the logger
+  for (int iteration = 0; iteration < 2; ++iteration) {
+    for (int i = 0; i < 3; ++i) {
+      RCUTILS_LOG_WARN_RATELIMIT_LOGGER(1, 100 /* ms */, logger, "rate limit %d", i);
+    }
+    if (0 == iteration) {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(150ms);
+    }
+  }
+  ASSERT_EQ(9u, g_log_events.size());
+  EXPECT_EQ("rate limit 0", g_log_events[6].message);
+  EXPECT_EQ("2 similar messages suppressed", g_log_events[7].message);
+  EXPECT_EQ("macro.logger", g_log_events[7].name);
+  EXPECT_EQ("rate limit 0", g_log_events[8].message);
+}
+
+TEST_F(TestLoggingLoggers, shutdown) {
+  rcutils_logger_t * logger = rcutils_logging_get_logger("shutdown.logger");
+  ASSERT_NE(nullptr, logger);
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_set_logger_level("shutdown", RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, rcutils_logger_get_effective_level(logger));
+
+  // the handles are created again after the logging system has been shut down
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  logger = rcutils_logging_get_logger("shutdown.logger");
+  ASSERT_NE(nullptr, logger);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, rcutils_logger_get_effective_level(logger));
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <string>
 
 #include "rcutils/error_handling.h"
 #include "rcutils/logging.h"
@@ -41,6 +42,15 @@ int main(int, char **)
   message[2] = 'd';
   rcutils_log(&location, RCUTILS_LOG_SEVERITY_INFO, "name2", message, 42);
 
+  // check a message which only becomes long when its arguments are formatted
+  std::string argument(4096, 'y');
+  rcutils_log(
+    &location, RCUTILS_LOG_SEVERITY_INFO, "name3", "X%sX%d", argument.c_str(), 43);
+
+  // check the same message again, after the buffers have been grown by the previous messages
+  rcutils_log(
+    &location, RCUTILS_LOG_SEVERITY_INFO, "name4", "X%sX%d", argument.c_str(), 44);
+
   std::cout.flush();
 
   return 0;
@@ -108,6 +108,18 @@ int main(int argc, char ** argv)
     return 16;
   }
 
+// Compile out the static logging macros below ERROR for one logger, the definition only needs
+// to precede their use.
+#define RCUTILS_LOG_MIN_SEVERITY_FOR_rcutils_test_stripped RCUTILS_LOG_MIN_SEVERITY_ERROR
+  RCUTILS_LOG_WARN_STATIC(rcutils_test_stripped, "message %d", undeclared_identifier);
+  RCUTILS_LOG_ERROR_STATIC(rcutils_test_stripped, "message %s", "bar");
+  if (g_log_calls != 3u) {
+    return 18;
+  }
+  if (strcmp(g_last_log_event.name, "rcutils_test_stripped")) {
+    return 19;
+  }
+
   rcutils_logging_set_output_handler(previous_output_handler);
   if (g_last_log_event.message) {
     free(g_last_log_event.message);
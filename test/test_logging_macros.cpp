@@ -182,3 +182,175 @@ TEST_F(TestLoggingMacros, test_logger_hierarchy) {
   RCUTILS_LOG_DEBUG("message");
   EXPECT_EQ(0u, g_log_calls);
 }
+
+// Compile out the static logging macros below ERROR for one logger, the definition only needs
+// to precede their use.
+#define RCUTILS_LOG_MIN_SEVERITY_FOR_rcutils_test_stripped RCUTILS_LOG_MIN_SEVERITY_ERROR
+
+TEST_F(TestLoggingMacros, test_logging_static) {
+  // loggers without a compile time minimum severity use RCUTILS_LOG_MIN_SEVERITY
+  RCUTILS_LOG_DEBUG_STATIC(rcutils_test_logging_macros_cpp, "message %d", 1);
+  EXPECT_EQ(1u, g_log_calls);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, g_last_log_event.level);
+  EXPECT_EQ("rcutils_test_logging_macros_cpp", g_last_log_event.name);
+  EXPECT_EQ("message 1", g_last_log_event.message);
+
+  // statements below the minimum severity are removed by the preprocessor, so they would not
+  // compile if they weren't
+  RCUTILS_LOG_DEBUG_STATIC(rcutils_test_stripped, "message %d", undeclared_identifier);
+  RCUTILS_LOG_WARN_ONCE_STATIC(rcutils_test_stripped, "message %d", undeclared_identifier);
+  RCUTILS_LOG_INFO_EXPRESSION_STATIC(undeclared_identifier, rcutils_test_stripped, "message");
+  EXPECT_EQ(1u, g_log_calls);
+
+  for (int i : {1, 2, 3, 4, 5, 6}) {
+    RCUTILS_LOG_ERROR_EXPRESSION_STATIC(i % 3, rcutils_test_stripped, "message %d", i);
+  }
+  EXPECT_EQ(5u, g_log_calls);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_ERROR, g_last_log_event.level);
+  EXPECT_EQ("rcutils_test_stripped", g_last_log_event.name);
+  EXPECT_EQ("message 5", g_last_log_event.message);
+
+  // the runtime level of the logger still applies
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_stripped", RCUTILS_LOG_SEVERITY_FATAL));
+  RCUTILS_LOG_ERROR_STATIC(rcutils_test_stripped, "message");
+  EXPECT_EQ(5u, g_log_calls);
+  RCUTILS_LOG_FATAL_STATIC(rcutils_test_stripped, "message");
+  EXPECT_EQ(6u, g_log_calls);
+}
+
+int g_evaluations = 0;
+
+int evaluate(int value)
+{
+  ++g_evaluations;
+  return value;
+}
+
+TEST_F(TestLoggingMacros, test_logging_lazy_arguments) {
+  g_evaluations = 0;
+  // a severity below the default level
+  g_rcutils_logging_default_logger_level = RCUTILS_LOG_SEVERITY_INFO;
+  RCUTILS_LOG_DEBUG("message %d", evaluate(1));
+  RCUTILS_LOG_DEBUG_NAMED("rcutils_test_lazy", "message %d", evaluate(1));
+  // a severity below the level of the logger
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_set_logger_level("rcutils_test_lazy", RCUTILS_LOG_SEVERITY_ERROR));
+  RCUTILS_LOG_WARN_NAMED("rcutils_test_lazy.child", "message %d", evaluate(1));
+  RCUTILS_LOG_WARN_ONCE_NAMED("rcutils_test_lazy", "message %d", evaluate(1));
+  // a condition which is false
+  RCUTILS_LOG_INFO_EXPRESSION(false, "message %d", evaluate(1));
+  for (int i : {1, 2, 3}) {
+    RCUTILS_LOG_INFO_ONCE("message %d", evaluate(i));
+  }
+  EXPECT_EQ(1, g_evaluations);
+  EXPECT_EQ(1u, g_log_calls);
+
+  RCUTILS_LOG_ERROR_NAMED("rcutils_test_lazy.child", "message %d", evaluate(4));
+  EXPECT_EQ(2, g_evaluations);
+  EXPECT_EQ(2u, g_log_calls);
+  EXPECT_EQ("message 4", g_last_log_event.message);
+}
+
+TEST_F(TestLoggingMacros, test_log_unchecked) {
+  // the level is not checked again
+  g_rcutils_logging_default_logger_level = RCUTILS_LOG_SEVERITY_FATAL;
+  rcutils_log_unchecked(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, nullptr, "message %d", 1);
+  EXPECT_EQ(1u, g_log_calls);
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, g_last_log_event.level);
+  EXPECT_EQ("", g_last_log_event.name);
+  EXPECT_EQ("message 1", g_last_log_event.message);
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, nullptr, "message %d", 2);
+  EXPECT_EQ(1u, g_log_calls);
+}
+
+TEST_F(TestLoggingMacros, test_logging_rate_limit) {
+  static std::vector<std::string> messages;
+  messages.clear();
+  rcutils_logging_set_output_handler(
+    [](const rcutils_log_location_t *, int level, const char * name, const char * format,
+    va_list * args) -> void
+    {
+      EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, level);
+      EXPECT_STREQ("name", name);
+      char buffer[1024];
+      vsnprintf(buffer, sizeof(buffer), format, *args);
+      messages.push_back(buffer);
+    });
+
+  for (int iteration : {0, 1}) {
+    for (int i = 0; i < 10; ++i) {
+      RCUTILS_LOG_WARN_RATELIMIT_NAMED(3, 100 /* ms */, "name", "message %d", i);
+    }
+    if (0 == iteration) {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(250ms);
+    }
+  }
+  // two messages are refilled while sleeping
+  std::vector<std::string> expected = {
+    "message 0", "message 1", "message 2",
+    "7 similar messages suppressed", "message 0", "message 1"};
+  EXPECT_EQ(expected, messages);
+}
+
+TEST_F(TestLoggingMacros, test_logging_rate_limit_reported_with_next_message) {
+  static std::vector<std::string> messages;
+  messages.clear();
+  rcutils_logging_set_output_handler(
+    [](const rcutils_log_location_t *, int, const char *, const char * format,
+    va_list * args) -> void
+    {
+      char buffer[1024];
+      vsnprintf(buffer, sizeof(buffer), format, *args);
+      messages.push_back(buffer);
+    });
+  auto log = [](int i) {
+      RCUTILS_LOG_WARN_RATELIMIT_NAMED(1, 50 /* ms */, "name", "message %d", i);
+    };
+
+  for (int i = 0; i < 5; ++i) {
+    log(i);
+  }
+  // the storm is over and the bucket is refilled, but the count isn't reported without a message
+  using namespace std::chrono_literals;
+  std::this_thread::sleep_for(150ms);
+  EXPECT_EQ(std::vector<std::string>({"message 0"}), messages);
+
+  log(5);
+  std::vector<std::string> expected = {
+    "message 0", "4 similar messages suppressed", "message 5"};
+  EXPECT_EQ(expected, messages);
+}
+
+TEST_F(TestLoggingMacros, test_logging_condition_rate_limit) {
+  rcutils_logging_rate_limit_t rate_limit = {0, 0};
+  uint64_t suppressed = 42;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 100, &suppressed));
+    EXPECT_EQ(0u, suppressed);
+  }
+  EXPECT_FALSE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 100, &suppressed));
+  EXPECT_FALSE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 109, &suppressed));
+  EXPECT_TRUE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 110, &suppressed));
+  EXPECT_EQ(2u, suppressed);
+  EXPECT_FALSE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 110, &suppressed));
+  // the bucket doesn't hold more than the burst
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 1000, &suppressed));
+  }
+  EXPECT_EQ(0u, suppressed);
+  EXPECT_FALSE(rcutils_logging_condition_rate_limit(&rate_limit, 3, 10, 1000, &suppressed));
+
+  // a burst of zero allows single messages, a period of zero disables the limit
+  rate_limit = {0, 0};
+  EXPECT_TRUE(rcutils_logging_condition_rate_limit(&rate_limit, 0, 10, 100, &suppressed));
+  EXPECT_FALSE(rcutils_logging_condition_rate_limit(&rate_limit, 0, 10, 100, &suppressed));
+  rate_limit = {0, 0};
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(rcutils_logging_condition_rate_limit(&rate_limit, 1, 0, 100, &suppressed));
+  }
+}
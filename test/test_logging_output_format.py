@@ -61,6 +61,37 @@ def test_logging_output_format():
         output_handlers=[ConsoleOutput(), handler],
     )
 
+    env_writev = dict(env_long)
+    # This is the same custom output as above, but written with writev instead of stdio.
+    env_writev['RCUTILS_CONSOLE_OUTPUT_WRITEV'] = '1'
+    name = 'test_logging_output_format_writev'
+    output_file = os.path.join(os.path.dirname(__file__), 'test_logging_output_format_long')
+    handler = create_handler(name, launch_descriptor, output_file)
+    assert handler, 'Cannot find appropriate handler for %s' % output_file
+    launch_descriptor.add_process(
+        cmd=[executable],
+        env=env_writev,
+        name=name,
+        exit_handler=ignore_exit_handler,
+        output_handlers=[ConsoleOutput(), handler],
+    )
+
+    env_time = dict(os.environ)
+    # This custom output checks the time and thread id tokens, which differ in each run.
+    env_time['RCUTILS_CONSOLE_OUTPUT_FORMAT'] = \
+        '[{time}] [{time_as_nanoseconds}] [{thread_id}] [{name}] {time}'
+    name = 'test_logging_output_format_time'
+    output_file = os.path.join(os.path.dirname(__file__), name)
+    handler = create_handler(name, launch_descriptor, output_file)
+    assert handler, 'Cannot find appropriate handler for %s' % output_file
+    launch_descriptor.add_process(
+        cmd=[executable],
+        env=env_time,
+        name=name,
+        exit_handler=ignore_exit_handler,
+        output_handlers=[ConsoleOutput(), handler],
+    )
+
     env_no_tokens = dict(os.environ)
     # This custom output is to check that there are no issues when no tokens are used.
     env_no_tokens['RCUTILS_CONSOLE_OUTPUT_FORMAT'] = 'no_tokens'
@@ -0,0 +1,153 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "rcutils/allocator.h"
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+
+std::atomic<size_t> g_allocations(0);
+std::atomic<size_t> g_live_allocations(0);
+
+void *
+counting_allocate(size_t size, void *)
+{
+  ++g_allocations;
+  ++g_live_allocations;
+  return rcutils_get_default_allocator().allocate(size, rcutils_get_default_allocator().state);
+}
+
+void
+counting_deallocate(void * pointer, void *)
+{
+  if (pointer) {
+    --g_live_allocations;
+  }
+  rcutils_get_default_allocator().deallocate(pointer, rcutils_get_default_allocator().state);
+}
+
+void *
+counting_reallocate(void * pointer, size_t size, void *)
+{
+  ++g_allocations;
+  if (!pointer) {
+    ++g_live_allocations;
+  }
+  return rcutils_get_default_allocator().reallocate(
+    pointer, size, rcutils_get_default_allocator().state);
+}
+
+class TestLoggingScratchBuffers : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    allocator.allocate = counting_allocate;
+    allocator.deallocate = counting_deallocate;
+    allocator.reallocate = counting_reallocate;
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize_with_allocator(allocator));
+    initial_live_allocations = g_live_allocations;
+  }
+
+  void TearDown()
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+    // The scratch buffers of the calling thread are released by the shutdown.
+    EXPECT_EQ(initial_live_allocations, g_live_allocations);
+  }
+
+protected:
+  size_t initial_live_allocations;
+};
+
+TEST_F(TestLoggingScratchBuffers, get_thread_scratch_buffer) {
+  char * buffer = nullptr;
+  size_t buffer_size = 0;
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_get_thread_scratch_buffer(10, nullptr, &buffer_size));
+  rcutils_reset_error();
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rcutils_logging_get_thread_scratch_buffer(10, &buffer, nullptr));
+  rcutils_reset_error();
+
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_thread_scratch_buffer(10, &buffer, &buffer_size));
+  ASSERT_NE(nullptr, buffer);
+  EXPECT_LE(10u, buffer_size);
+  memset(buffer, 'x', buffer_size);
+
+  // A larger buffer keeps the contents.
+  char * larger_buffer = nullptr;
+  size_t larger_buffer_size = 0;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rcutils_logging_get_thread_scratch_buffer(
+      buffer_size + 1, &larger_buffer, &larger_buffer_size));
+  ASSERT_NE(nullptr, larger_buffer);
+  EXPECT_LT(buffer_size, larger_buffer_size);
+  EXPECT_EQ(std::string(buffer_size, 'x'), std::string(larger_buffer, buffer_size));
+
+  // The buffer never shrinks and isn't reallocated when it is large enough.
+  size_t allocations = g_allocations;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_thread_scratch_buffer(10, &buffer, &buffer_size));
+  EXPECT_EQ(larger_buffer, buffer);
+  EXPECT_EQ(larger_buffer_size, buffer_size);
+  EXPECT_EQ(allocations, g_allocations);
+
+  rcutils_logging_release_thread_scratch_buffers();
+  EXPECT_EQ(initial_live_allocations, g_live_allocations);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_thread_scratch_buffer(10, &buffer, &buffer_size));
+  ASSERT_NE(nullptr, buffer);
+  EXPECT_LE(10u, buffer_size);
+}
+
+TEST_F(TestLoggingScratchBuffers, console_output_handler_steady_state) {
+  rcutils_log_location_t location = {"func", "file", 42u};
+  std::string argument(4096, 'y');
+  rcutils_log(
+    &location, RCUTILS_LOG_SEVERITY_INFO, "name", "X%sX%d", argument.c_str(), 42);
+  EXPECT_LT(initial_live_allocations, g_live_allocations);
+
+  // Once the scratch buffer has grown, logging messages of the same length doesn't allocate.
+  size_t allocations = g_allocations;
+  for (int i = 0; i < 3; ++i) {
+    rcutils_log(
+      &location, RCUTILS_LOG_SEVERITY_INFO, "name", "X%sX%d", argument.c_str(), i);
+  }
+  EXPECT_EQ(allocations, g_allocations);
+}
+
+TEST_F(TestLoggingScratchBuffers, released_at_thread_exit) {
+  std::thread thread([]() {
+      rcutils_log_location_t location = {"func", "file", 42u};
+      std::string argument(4096, 'y');
+      rcutils_log(
+        &location, RCUTILS_LOG_SEVERITY_INFO, "name", "X%sX%d", argument.c_str(), 42);
+      char * buffer = nullptr;
+      size_t buffer_size = 0;
+      EXPECT_EQ(
+        RCUTILS_RET_OK, rcutils_logging_get_thread_scratch_buffer(4096, &buffer, &buffer_size));
+      EXPECT_LT(0u, g_live_allocations);
+    });
+  thread.join();
+  EXPECT_EQ(initial_live_allocations, g_live_allocations);
+}
@@ -0,0 +1,228 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/logging_macros.h"
+
+struct LogEvent
+{
+  char sink;
+  int severity;
+  std::string message;
+  // The formatted message if it was passed by reference, NULL otherwise.
+  const char * shared_message;
+};
+static std::vector<LogEvent> g_log_events;
+
+static void record(char sink, int severity, const char * format, va_list * args)
+{
+  const char * shared_message = nullptr;
+  if (strcmp(format, "%s") == 0) {
+    va_list args_clone;
+    va_copy(args_clone, *args);
+    shared_message = va_arg(args_clone, const char *);
+    va_end(args_clone);
+  }
+  char buffer[1024];
+  vsnprintf(buffer, sizeof(buffer), format, *args);
+  g_log_events.push_back({sink, severity, buffer, shared_message});
+}
+
+#define DEFINE_RECORD_OUTPUT_HANDLER(sink) \
+  static void record_output_handler_ ## sink( \
+    const rcutils_log_location_t *, int severity, const char *, const char * format, \
+    va_list * args) \
+  { \
+    record(#sink[0], severity, format, args); \
+  }
+
+DEFINE_RECORD_OUTPUT_HANDLER(a)
+DEFINE_RECORD_OUTPUT_HANDLER(b)
+DEFINE_RECORD_OUTPUT_HANDLER(c)
+
+static void nested_output_handler(
+  const rcutils_log_location_t *, int severity, const char *, const char * format,
+  va_list * args)
+{
+  record('n', severity, format, args);
+  if (severity < RCUTILS_LOG_SEVERITY_FATAL) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_FATAL, "name", "nested %d", 2);
+  }
+}
+
+template<int N>
+static void discard_output_handler(
+  const rcutils_log_location_t *, int, const char *, const char *, va_list *)
+{
+}
+
+static std::string events_string()
+{
+  std::string result;
+  for (const auto & event : g_log_events) {
+    result += std::string(1, event.sink) + ":" + event.message + ";";
+  }
+  return result;
+}
+
+class TestLoggingSinks : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    g_log_events.clear();
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(nullptr);
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_DEBUG);
+  }
+
+  void TearDown()
+  {
+    rcutils_logging_set_output_handler(previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  }
+
+protected:
+  rcutils_logging_output_handler_t previous_output_handler;
+};
+
+TEST_F(TestLoggingSinks, severity_thresholds) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_a, 0));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_b, RCUTILS_LOG_SEVERITY_WARN));
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "name", "debug %d", 1);
+  ASSERT_EQ(1u, g_log_events.size());
+  // A single receiver gets the original format and arguments.
+  EXPECT_EQ(nullptr, g_log_events[0].shared_message);
+
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, "name", "warn %d", 2);
+  ASSERT_EQ(3u, g_log_events.size());
+  // Several receivers get the same formatted message.
+  EXPECT_NE(nullptr, g_log_events[1].shared_message);
+  EXPECT_EQ(g_log_events[1].shared_message, g_log_events[2].shared_message);
+  EXPECT_EQ("a:debug 1;a:warn 2;b:warn 2;", events_string());
+
+  // The output handler receives the messages first, and isn't limited by a threshold.
+  g_log_events.clear();
+  rcutils_logging_set_output_handler(record_output_handler_c);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "info %d", 3);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_ERROR, "name", "error %d", 4);
+  EXPECT_EQ("c:info 3;a:info 3;c:error 4;a:error 4;b:error 4;", events_string());
+
+  // Adding a sink again changes its threshold.
+  g_log_events.clear();
+  rcutils_logging_set_output_handler(nullptr);
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_a, RCUTILS_LOG_SEVERITY_ERROR));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, "name", "warn %d", 5);
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_ERROR, "name", "error %d", 6);
+  EXPECT_EQ("b:warn 5;a:error 6;b:error 6;", events_string());
+
+  g_log_events.clear();
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_remove_sink(record_output_handler_a));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_ERROR, "name", "error %d", 7);
+  EXPECT_EQ("b:error 7;", events_string());
+}
+
+TEST_F(TestLoggingSinks, enabled_check) {
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("name", RCUTILS_LOG_SEVERITY_FATAL));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_a, RCUTILS_LOG_SEVERITY_WARN));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("name", RCUTILS_LOG_SEVERITY_INFO));
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for("name", RCUTILS_LOG_SEVERITY_WARN));
+
+  // The arguments of the logging macros aren't evaluated if no sink receives the message.
+  int evaluated = 0;
+  for (int i = 0; i < 2; ++i) {
+    RCUTILS_LOG_INFO_NAMED("name", "info %d", ++evaluated);
+    RCUTILS_LOG_WARN_NAMED("name", "warn %d", ++evaluated);
+  }
+  EXPECT_EQ(2, evaluated);
+  EXPECT_EQ("a:warn 1;a:warn 2;", events_string());
+
+  // The levels of the loggers still apply.
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_set_logger_level("name", RCUTILS_LOG_SEVERITY_ERROR));
+  EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("name", RCUTILS_LOG_SEVERITY_WARN));
+
+  // An output handler receives all severities.
+  rcutils_logging_set_output_handler(record_output_handler_b);
+  EXPECT_TRUE(rcutils_logging_logger_is_enabled_for("other", RCUTILS_LOG_SEVERITY_DEBUG));
+}
+
+TEST_F(TestLoggingSinks, nested_logging) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(nested_output_handler, 0));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_a, 0));
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "outer %d", 1);
+  // The nested message is formatted by each receiver, since the outer message is still in use.
+  EXPECT_EQ("n:outer 1;n:nested 2;a:nested 2;a:outer 1;", events_string());
+  ASSERT_EQ(4u, g_log_events.size());
+  EXPECT_EQ(nullptr, g_log_events[1].shared_message);
+  EXPECT_EQ(nullptr, g_log_events[2].shared_message);
+  EXPECT_EQ(g_log_events[0].shared_message, g_log_events[3].shared_message);
+}
+
+TEST_F(TestLoggingSinks, long_message) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_a, 0));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(record_output_handler_b, 0));
+  std::string argument(100000, 'x');
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "%s", argument.c_str());
+  ASSERT_EQ(2u, g_log_events.size());
+  ASSERT_NE(nullptr, g_log_events[0].shared_message);
+  EXPECT_EQ(argument, g_log_events[0].shared_message);
+}
+
+TEST_F(TestLoggingSinks, invalid_arguments) {
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_add_sink(nullptr, 0));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_remove_sink(record_output_handler_a));
+  rcutils_reset_error();
+
+  // Sinks are identified by their output handler.
+  rcutils_logging_output_handler_t output_handlers[] = {
+    discard_output_handler<0>, discard_output_handler<1>, discard_output_handler<2>,
+    discard_output_handler<3>, discard_output_handler<4>, discard_output_handler<5>,
+    discard_output_handler<6>, discard_output_handler<7>, discard_output_handler<8>,
+  };
+  static_assert(
+    sizeof(output_handlers) / sizeof(output_handlers[0]) > RCUTILS_LOGGING_MAX_SINKS,
+    "more output handlers than sinks are needed");
+  for (size_t i = 0; i < RCUTILS_LOGGING_MAX_SINKS; ++i) {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(output_handlers[i], 0));
+  }
+  EXPECT_EQ(
+    RCUTILS_RET_ERROR, rcutils_logging_add_sink(output_handlers[RCUTILS_LOGGING_MAX_SINKS], 0));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(output_handlers[0], 10));
+  EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_remove_sink(output_handlers[0]));
+  EXPECT_EQ(
+    RCUTILS_RET_OK, rcutils_logging_add_sink(output_handlers[RCUTILS_LOGGING_MAX_SINKS], 0));
+
+  // The sinks are removed on shutdown.
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  rcutils_logging_set_output_handler(nullptr);
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_remove_sink(output_handlers[1]));
+  rcutils_reset_error();
+}
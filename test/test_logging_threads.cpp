@@ -0,0 +1,151 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Stress tests for the concurrent use of the logging system.
+// They are also built with ThreadSanitizer, which reports any data race they provoke.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/logging.h"
+#include "rcutils/logging_macros.h"
+
+static const int num_threads = 4;
+static const int num_messages = 2000;
+
+static std::atomic<size_t> g_output_counts[RCUTILS_LOG_SEVERITY_FATAL + 1];
+
+static void count_output_handler(
+  const rcutils_log_location_t *, int severity, const char *, const char *, va_list *)
+{
+  ++g_output_counts[severity];
+}
+
+// A second output handler, so that changing the output handler is observable.
+static void count_output_handler_2(
+  const rcutils_log_location_t * location, int severity, const char * name,
+  const char * format, va_list * args)
+{
+  count_output_handler(location, severity, name, format, args);
+}
+
+static std::atomic<size_t> g_sink_counts[2];
+
+// A sink which stays added, and one which is added and removed repeatedly.
+static void count_sink(
+  const rcutils_log_location_t *, int, const char *, const char *, va_list *)
+{
+  ++g_sink_counts[0];
+}
+
+static void count_sink_2(
+  const rcutils_log_location_t *, int, const char *, const char *, va_list *)
+{
+  ++g_sink_counts[1];
+}
+
+static void reset_output_counts()
+{
+  for (auto & count : g_output_counts) {
+    count = 0;
+  }
+  for (auto & count : g_sink_counts) {
+    count = 0;
+  }
+}
+
+TEST(TestLoggingThreads, concurrent_initialization) {
+  ASSERT_FALSE(RCUTILS_LOGGING_IS_INITIALIZED());
+  rcutils_logging_output_handler_t output_handlers[num_threads];
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([t, &output_handlers]() {
+        // the first use of the logging system initializes it
+        EXPECT_FALSE(rcutils_logging_logger_is_enabled_for("name", RCUTILS_LOG_SEVERITY_DEBUG));
+        output_handlers[t] = rcutils_logging_get_output_handler();
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(RCUTILS_LOGGING_IS_INITIALIZED());
+  // every thread saw the complete initialization
+  for (int t = 0; t < num_threads; ++t) {
+    EXPECT_EQ(rcutils_logging_console_output_handler, output_handlers[t]);
+  }
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, rcutils_logging_get_default_logger_level());
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
+
+TEST(TestLoggingThreads, log_while_configuring) {
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+  reset_output_counts();
+  rcutils_logging_set_output_handler(count_output_handler);
+  rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_INFO);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_add_sink(count_sink, RCUTILS_LOG_SEVERITY_ERROR));
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([t]() {
+        std::string name = "stress.thread" + std::to_string(t);
+        for (int i = 0; i < num_messages; ++i) {
+          RCUTILS_LOG_DEBUG_NAMED("stress.macro", "debug %d", i);
+          RCUTILS_LOG_WARN_NAMED("stress.macro", "warn %d", i);
+          RCUTILS_LOG_ERROR("error %d", i);
+          rcutils_log(NULL, RCUTILS_LOG_SEVERITY_WARN, name.c_str(), "warn %d", i);
+        }
+      });
+  }
+  std::thread configurer([&done]() {
+      for (int i = 0; !done; ++i) {
+        rcutils_logging_set_default_logger_level(
+          i % 2 ? RCUTILS_LOG_SEVERITY_DEBUG : RCUTILS_LOG_SEVERITY_INFO);
+        EXPECT_EQ(
+          RCUTILS_RET_OK,
+          rcutils_logging_set_logger_level(
+            "stress", i % 3 ? RCUTILS_LOG_SEVERITY_DEBUG : RCUTILS_LOG_SEVERITY_WARN));
+        EXPECT_EQ(
+          RCUTILS_RET_OK,
+          rcutils_logging_set_logger_level_pattern(
+            "stress.*", i % 5 ? RCUTILS_LOG_SEVERITY_UNSET : RCUTILS_LOG_SEVERITY_INFO));
+        rcutils_logging_set_output_handler(i % 2 ? count_output_handler_2 : count_output_handler);
+        if (i % 2) {
+          EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_remove_sink(count_sink_2));
+        } else {
+          EXPECT_EQ(
+            RCUTILS_RET_OK, rcutils_logging_add_sink(count_sink_2, RCUTILS_LOG_SEVERITY_WARN));
+        }
+      }
+    });
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  done = true;
+  configurer.join();
+
+  // the levels never filter out warnings and errors
+  const size_t total = static_cast<size_t>(num_threads * num_messages);
+  EXPECT_EQ(2 * total, g_output_counts[RCUTILS_LOG_SEVERITY_WARN]);
+  EXPECT_EQ(total, g_output_counts[RCUTILS_LOG_SEVERITY_ERROR]);
+  EXPECT_LE(g_output_counts[RCUTILS_LOG_SEVERITY_DEBUG], total);
+  // changing the other sink doesn't affect the sink which stays added
+  EXPECT_EQ(total, g_sink_counts[0]);
+  EXPECT_LE(g_sink_counts[1], 3 * total);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+}
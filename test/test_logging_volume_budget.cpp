@@ -0,0 +1,173 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcutils/error_handling.h"
+#include "rcutils/logging.h"
+#include "rcutils/time.h"
+
+struct LogEvent
+{
+  int severity;
+  std::string name;
+  std::string message;
+};
+static std::vector<LogEvent> g_log_events;
+
+static void record_output_handler(
+  const rcutils_log_location_t *, int severity, const char * name, const char * format,
+  va_list * args)
+{
+  char buffer[1024];
+  vsnprintf(buffer, sizeof(buffer), format, *args);
+  g_log_events.push_back({severity, name, buffer});
+}
+
+static size_t count(int severity)
+{
+  size_t result = 0;
+  for (const auto & event : g_log_events) {
+    result += event.severity == severity ? 1 : 0;
+  }
+  return result;
+}
+
+/// Wait until the start of the next second of the steady time.
+static void wait_for_next_second()
+{
+  rcutils_time_point_value_t now;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_steady_time_now(&now));
+  std::this_thread::sleep_for(
+    std::chrono::nanoseconds(RCUTILS_S_TO_NS(1) - now % RCUTILS_S_TO_NS(1)) +
+    std::chrono::milliseconds(10));
+}
+
+class TestLoggingVolumeBudget : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_initialize());
+    g_log_events.clear();
+    previous_output_handler = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(record_output_handler);
+    rcutils_logging_set_default_logger_level(RCUTILS_LOG_SEVERITY_DEBUG);
+  }
+
+  void TearDown()
+  {
+    rcutils_logging_set_volume_budget(0, 0);
+    rcutils_logging_set_output_handler(previous_output_handler);
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_logging_shutdown());
+  }
+
+protected:
+  rcutils_logging_output_handler_t previous_output_handler;
+};
+
+TEST_F(TestLoggingVolumeBudget, no_budget) {
+  for (int i = 0; i < 100; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "name", "message %d", i);
+  }
+  EXPECT_EQ(100u, count(RCUTILS_LOG_SEVERITY_DEBUG));
+
+  rcutils_logging_volume_statistics_t statistics;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_volume_statistics(&statistics));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, statistics.shed_severity);
+  EXPECT_EQ(0u, statistics.shed_debug_count);
+  EXPECT_EQ(0u, statistics.shed_info_count);
+
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, rcutils_logging_get_volume_statistics(nullptr));
+  rcutils_reset_error();
+}
+
+TEST_F(TestLoggingVolumeBudget, lines_per_second) {
+  rcutils_logging_set_volume_budget(10, 0);
+  wait_for_next_second();
+  // Exceeding the budget sheds DEBUG messages, but everything else passes.
+  for (int i = 0; i < 20; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "name", "message %d", i);
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_WARN, "name", "message %d", i);
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_FATAL, "name", "message %d", i);
+  }
+  EXPECT_EQ(20u, count(RCUTILS_LOG_SEVERITY_INFO));
+  EXPECT_EQ(0u, count(RCUTILS_LOG_SEVERITY_DEBUG));
+  EXPECT_EQ(5u, count(RCUTILS_LOG_SEVERITY_WARN));
+  EXPECT_EQ(5u, count(RCUTILS_LOG_SEVERITY_FATAL));
+
+  rcutils_logging_volume_statistics_t statistics;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_volume_statistics(&statistics));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, statistics.shed_severity);
+  EXPECT_EQ(5u, statistics.shed_debug_count);
+  EXPECT_EQ(0u, statistics.shed_info_count);
+
+  // Staying over the budget in the next second sheds INFO messages as well.
+  wait_for_next_second();
+  g_log_events.clear();
+  for (int i = 0; i < 20; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "message %d", i);
+  }
+  ASSERT_LE(1u, g_log_events.size());
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, g_log_events[0].severity);
+  EXPECT_EQ("rcutils", g_log_events[0].name);
+  EXPECT_EQ(
+    "5 messages with a severity below INFO were dropped by the log volume budget",
+    g_log_events[0].message);
+  // The warning counts against the budget as well.
+  EXPECT_EQ(10u, count(RCUTILS_LOG_SEVERITY_INFO));
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_volume_statistics(&statistics));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_WARN, statistics.shed_severity);
+  EXPECT_EQ(10u, statistics.shed_info_count);
+
+  // The threshold is restored once the load subsides.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+  g_log_events.clear();
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "name", "message");
+  ASSERT_EQ(2u, g_log_events.size());
+  EXPECT_EQ(
+    "10 messages with a severity below WARN were dropped by the log volume budget",
+    g_log_events[0].message);
+  EXPECT_EQ("message", g_log_events[1].message);
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_volume_statistics(&statistics));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_DEBUG, statistics.shed_severity);
+  EXPECT_EQ(5u, statistics.shed_debug_count);
+  EXPECT_EQ(10u, statistics.shed_info_count);
+}
+
+TEST_F(TestLoggingVolumeBudget, bytes_per_second) {
+  // The output handlers of this library account the bytes they write.
+  rcutils_logging_set_output_handler(rcutils_logging_console_output_handler);
+  rcutils_logging_set_volume_budget(0, 100);
+  wait_for_next_second();
+  for (int i = 0; i < 10; ++i) {
+    rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_INFO, "name", "a message of about fifty bytes");
+  }
+  rcutils_log(nullptr, RCUTILS_LOG_SEVERITY_DEBUG, "name", "shed message");
+
+  rcutils_logging_volume_statistics_t statistics;
+  ASSERT_EQ(RCUTILS_RET_OK, rcutils_logging_get_volume_statistics(&statistics));
+  EXPECT_EQ(RCUTILS_LOG_SEVERITY_INFO, statistics.shed_severity);
+  EXPECT_EQ(1u, statistics.shed_debug_count);
+}
@@ -1526,3 +1526,80 @@ TEST(test_string_map, strange_keys) {
     ASSERT_EQ(RCUTILS_RET_OK, ret);
   }
 }
+
+TEST(test_string_map, many_keys) {
+  auto allocator = rcutils_get_default_allocator();
+  rcutils_ret_t ret;
+  const size_t num_keys = 1000;
+
+  rcutils_string_map_t string_map = rcutils_get_zero_initialized_string_map();
+  ret = rcutils_string_map_init(&string_map, 0, allocator);
+  ASSERT_EQ(RCUTILS_RET_OK, ret);
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    std::string key = "key" + std::to_string(i);
+    std::string value = "value" + std::to_string(i);
+    ret = rcutils_string_map_set(&string_map, key.c_str(), value.c_str());
+    ASSERT_EQ(RCUTILS_RET_OK, ret) << rcutils_get_error_string_safe();
+  }
+  size_t size = 0;
+  ret = rcutils_string_map_get_size(&string_map, &size);
+  EXPECT_EQ(RCUTILS_RET_OK, ret);
+  EXPECT_EQ(num_keys, size);
+  size_t capacity = 0;
+  ret = rcutils_string_map_get_capacity(&string_map, &capacity);
+  EXPECT_EQ(RCUTILS_RET_OK, ret);
+  EXPECT_EQ(1024u, capacity);
+
+  // remove every other key
+  for (size_t i = 0; i < num_keys; i += 2) {
+    std::string key = "key" + std::to_string(i);
+    ret = rcutils_string_map_unset(&string_map, key.c_str());
+    ASSERT_EQ(RCUTILS_RET_OK, ret) << rcutils_get_error_string_safe();
+  }
+  for (size_t i = 0; i < num_keys; ++i) {
+    std::string key = "key" + std::to_string(i);
+    std::string value = "value" + std::to_string(i);
+    if (i % 2) {
+      EXPECT_STREQ(value.c_str(), rcutils_string_map_get(&string_map, key.c_str()));
+      EXPECT_STREQ(value.c_str(), rcutils_string_map_getn(&string_map, key.c_str(), key.size()));
+    } else {
+      EXPECT_FALSE(rcutils_string_map_key_exists(&string_map, key.c_str()));
+    }
+  }
+
+  // keys are iterated in the order they were added
+  size_t expected_index = 1;
+  const char * key = rcutils_string_map_get_next_key(&string_map, NULL);
+  while (key) {
+    EXPECT_EQ("key" + std::to_string(expected_index), key);
+    expected_index += 2;
+    key = rcutils_string_map_get_next_key(&string_map, key);
+  }
+  EXPECT_EQ(num_keys + 1, expected_index);
+
+  // adding and removing new keys repeatedly reuses the removed entries without growing
+  for (size_t i = 0; i < 10 * num_keys; ++i) {
+    std::string key = "other_key" + std::to_string(i);
+    ret = rcutils_string_map_set(&string_map, key.c_str(), "value");
+    ASSERT_EQ(RCUTILS_RET_OK, ret) << rcutils_get_error_string_safe();
+    ret = rcutils_string_map_unset(&string_map, key.c_str());
+    ASSERT_EQ(RCUTILS_RET_OK, ret) << rcutils_get_error_string_safe();
+  }
+  ret = rcutils_string_map_get_capacity(&string_map, &capacity);
+  EXPECT_EQ(RCUTILS_RET_OK, ret);
+  EXPECT_EQ(1024u, capacity);
+  EXPECT_STREQ("value999", rcutils_string_map_get(&string_map, "key999"));
+
+  // shrinking keeps all keys
+  ret = rcutils_string_map_reserve(&string_map, 0);
+  EXPECT_EQ(RCUTILS_RET_OK, ret);
+  ret = rcutils_string_map_get_capacity(&string_map, &capacity);
+  EXPECT_EQ(RCUTILS_RET_OK, ret);
+  EXPECT_EQ(num_keys / 2, capacity);
+  EXPECT_STREQ("value1", rcutils_string_map_get(&string_map, "key1"));
+  EXPECT_STREQ("value999", rcutils_string_map_get(&string_map, "key999"));
+
+  ret = rcutils_string_map_fini(&string_map);
+  ASSERT_EQ(RCUTILS_RET_OK, ret);
+}